@@ -17,43 +17,52 @@ INCLUDEPATH += models network views util tools
 
 QMAKE_LFLAGS+=-Wl,-Map=mapfile
 
+#the RTLS core (serial connection, report parsing, tag registry, filters), QtCore only
+include(core.pri)
+
 SOURCES += main.cpp\
     RTLSDisplayApplication.cpp \
     views/mainwindow.cpp \
-    network/RTLSClient.cpp \
     views/GraphicsView.cpp \
     views/GraphicsWidget.cpp \
     views/ViewSettingsWidget.cpp \
     views/MinimapView.cpp \
     views/connectionwidget.cpp \
+    views/DiagnosticsWidget.cpp \
+    views/EllipseItemPool.cpp \
+    views/TrailItem.cpp \
     models/ViewSettings.cpp \
+    models/FloorplanPyramid.cpp \
+    models/TagTableModel.cpp \
+    models/ConsoleModel.cpp \
     tools/OriginTool.cpp \
     tools/GeoFenceTool.cpp \
     tools/RubberBandTool.cpp \
     tools/ScaleTool.cpp \
     util/QPropertyModel.cpp \
-    network/SerialConnection.cpp \
-    util/json_utils.cpp \
     views/serial_widget.cpp
 
 HEADERS  += \
     RTLSDisplayApplication.h \
     views/mainwindow.h \
-    network/RTLSClient.h \
     views/GraphicsView.h \
     views/GraphicsWidget.h \
     views/ViewSettingsWidget.h \
     views/MinimapView.h \
     views/connectionwidget.h \
+    views/DiagnosticsWidget.h \
+    views/EllipseItemPool.h \
+    views/TrailItem.h \
     models/ViewSettings.h \
+    models/FloorplanPyramid.h \
+    models/TagTableModel.h \
+    models/ConsoleModel.h \
     tools/AbstractTool.h \
     tools/OriginTool.h \
     tools/GeoFenceTool.h \
     tools/RubberBandTool.h \
     tools/ScaleTool.h \
     util/QPropertyModel.h \
-    network/SerialConnection.h \
-    util/json_utils.h \
     views/serial_widget.h
 
 
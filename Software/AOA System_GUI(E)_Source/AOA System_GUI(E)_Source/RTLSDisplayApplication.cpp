@@ -14,6 +14,7 @@
 
 #include "mainwindow.h"
 #include "SerialConnection.h"
+#include "ReplaySource.h"
 #include "RTLSClient.h"
 #include "ViewSettings.h"
 #include "GraphicsWidget.h"
@@ -21,6 +22,7 @@
 
 #include <QMetaProperty>
 #include <QScreen>
+#include <QThread>
 
 /**
 * @brief RTLSDisplayApplication
@@ -28,6 +30,8 @@
 *        the _serialConnection is used for managing the COM port connection
 *        the _client consumes the data received over the COM port connection and sends the
 * processed data to the graphical display
+*        both of them live in the _ioThread, so reading and parsing the reports is not held up by the GUI;
+* the GUI talks to them through signals/queued calls only
 *        the _mainWindow holds the various GUI parts
 *        the _viewSettings is used for configuration of the graphical display
 */
@@ -48,36 +52,50 @@ RTLSDisplayApplication::RTLSDisplayApplication(int &argc, char **argv) : QApplic
 
     _viewSettings = new ViewSettings(this);
 
-    _serialConnection = new SerialConnection(this);
+    qRegisterMetaType<SerialConnection::ConnectionState>("SerialConnection::ConnectionState");
+
+    _ioThread = new QThread(this);
+
+    _serialConnection = new SerialConnection();
+    _replaySource = new ReplaySource(_serialConnection, _serialConnection); //moves to the I/O thread with its parent
+    _serialConnection->moveToThread(_ioThread);
 
     _serialSettings = new serial_widget();
 
-    _client = new RTLSClient(this);
+    _client = new RTLSClient(_serialConnection);
+    _client->moveToThread(_ioThread);
+
+    _ioThread->start();
 
     _mainWindow = new MainWindow();
     _mainWindow->resize(desktopWidth/2,desktopHeight/2);
 
+    QMetaObject::invokeMethod(_client, "setAppVersion", Qt::QueuedConnection, Q_ARG(QString, _mainWindow->version()));
+
     _ready = true;
 
     //Connect the various signals and corresponding slots
     QObject::connect(_client, SIGNAL(nodePos(int,double,double)), graphicsWidget(), SLOT(nodePos(int,double,double)));
-    QObject::connect(_client, SIGNAL(tagPos(quint64,double,double, int)), graphicsWidget(), SLOT(tagPos(quint64,double,double, int)));
-    QObject::connect(_client, SIGNAL(tagRange(quint64,double,double,double, int, int, int, int, int)), graphicsWidget(), SLOT(tagRange(quint64,double,double,double, int, int, int, int, int)));
+    QObject::connect(_client, SIGNAL(updatesReady()), graphicsWidget(), SLOT(updatesReady()));
     QObject::connect(_client, SIGNAL(statusBarMessage(QString)), _mainWindow, SLOT(statusBarMessage(QString)));
     QObject::connect(_client, SIGNAL(centerOnNodes(void)), graphicsWidget(), SLOT(centerOnNodes(void)));
     QObject::connect(_client, SIGNAL(addDiscoveredTag(quint64, int, bool, int, int)), graphicsWidget(), SLOT(addDiscoveredTag(quint64, int, bool, int, int)));
     QObject::connect(_client, SIGNAL(clearTags()), graphicsWidget(), SLOT(clearTags()));
 
     QObject::connect(_serialConnection, SIGNAL(statusBarMessage(QString)), _mainWindow, SLOT(statusBarMessage(QString)));
-    QObject::connect(_serialConnection, SIGNAL(connectionStateChanged(SerialConnection::ConnectionState)), _client, SLOT(connectionStateChanged(SerialConnection::ConnectionState)));
+    QObject::connect(_serialConnection, SIGNAL(connectionStateChanged(SerialConnection::ConnectionState)),
+                     _serialSettings, SLOT(connectionStateChanged(SerialConnection::ConnectionState)));
 
     emit ready();
 }
 
 RTLSDisplayApplication::~RTLSDisplayApplication()
 {
-    //first close any open connections
-    RTLSDisplayApplication::serialConnection()->closeConnection(false);
+    //first close any open connections (in the I/O thread, which owns the port), then stop the thread
+    QMetaObject::invokeMethod(_serialConnection, "closeConnection", Qt::BlockingQueuedConnection, Q_ARG(bool, false));
+
+    _ioThread->quit();
+    _ioThread->wait();
 
     // Delete the objects manually, because we want to control the order
     delete _mainWindow;
@@ -117,6 +135,11 @@ SerialConnection *RTLSDisplayApplication::serialConnection()
     return instance()->_serialConnection;
 }
 
+ReplaySource *RTLSDisplayApplication::replaySource()
+{
+    return instance()->_replaySource;
+}
+
 MainWindow *RTLSDisplayApplication::mainWindow()
 {
     return instance()->_mainWindow;
@@ -24,7 +24,9 @@ class SerialConnection;
 class GraphicsWidget;
 class GraphicsView;
 class RTLSClient;
+class ReplaySource;
 class serial_widget;
+class QThread;
 
 /**
  * The RTLSDisplayApplication class is a singleton class which handles the application.
@@ -53,6 +55,7 @@ public:
 
     static serial_widget *serialSettings();
     static SerialConnection *serialConnection();
+    static ReplaySource *replaySource();
     static RTLSClient *client();
     static MainWindow *mainWindow();
 
@@ -84,8 +87,12 @@ private:
 
     SerialConnection *_serialConnection;
 
+    ReplaySource *_replaySource; //feeds a recorded capture to the _serialConnection instead of the COM port
+
     RTLSClient *_client;
 
+    QThread *_ioThread; //the serial connection and the client run here, away from the GUI repaints
+
     MainWindow *_mainWindow;
 
     bool _ready;
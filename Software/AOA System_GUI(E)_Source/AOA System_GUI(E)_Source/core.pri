@@ -0,0 +1,46 @@
+#-------------------------------------------------
+#
+# RTLS core: serial connection, frame decoding, report parsing, tag registry and position filters
+# It only needs QtCore and QtSerialPort (no QtWidgets, no windows.h), it is shared by
+# PDOARTLSdisplay.pro and the headless console application (headless/rtlsheadless.pro)
+#
+#-------------------------------------------------
+
+QT += core serialport
+
+INCLUDEPATH += $$PWD/network $$PWD/util
+
+SOURCES += \
+    $$PWD/network/RTLSClient.cpp \
+    $$PWD/network/SerialConnection.cpp \
+    $$PWD/network/CommandScheduler.cpp \
+    $$PWD/network/JsFrameDecoder.cpp \
+    $$PWD/network/TagRegistry.cpp \
+    $$PWD/network/PositionFilter.cpp \
+    $$PWD/network/CaptureFile.cpp \
+    $$PWD/network/ReplaySource.cpp \
+    $$PWD/util/SlidingMedian.cpp \
+    $$PWD/util/LatencyHistogram.cpp \
+    $$PWD/util/LatencyMonitor.cpp \
+    $$PWD/util/LogWriter.cpp \
+    $$PWD/util/LogCategories.cpp \
+    $$PWD/util/SessionFile.cpp \
+    $$PWD/util/json_utils.cpp
+
+HEADERS += \
+    $$PWD/network/RTLSClient.h \
+    $$PWD/network/SerialConnection.h \
+    $$PWD/network/CommandScheduler.h \
+    $$PWD/network/JsFrameDecoder.h \
+    $$PWD/network/TagRegistry.h \
+    $$PWD/network/PositionFilter.h \
+    $$PWD/network/CaptureFile.h \
+    $$PWD/network/ReplaySource.h \
+    $$PWD/util/SpscQueue.h \
+    $$PWD/util/SlidingMedian.h \
+    $$PWD/util/LatencyHistogram.h \
+    $$PWD/util/LatencyMonitor.h \
+    $$PWD/util/LogWriter.h \
+    $$PWD/util/LogCategories.h \
+    $$PWD/util/SessionFile.h \
+    $$PWD/util/json_utils.h
@@ -0,0 +1,139 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: PositionStream.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "PositionStream.h"
+#include "LogCategories.h"
+
+#include "RTLSClient.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <stdio.h>
+
+PositionStream::PositionStream(RTLSClient *client, bool quiet, QObject *parent) :
+    QObject(parent),
+    _client(client),
+    _out(stdout),
+    _count(0),
+    _quiet(quiet),
+    _done(false)
+{
+    _clock.start();
+
+    if(!_quiet)
+    {
+        _out << "time_ms,tag,x,y,range,angle,mode" << endl;
+    }
+}
+
+/**
+* @brief updatesReady()
+*        same protocol as the GraphicsWidget: re-arm, then drain the queue
+*        (the "scene" latency stage is the time to print the line)
+* */
+void PositionStream::updatesReady(void)
+{
+    LatencyMonitor *latency = _client->latency();
+    tag_update_t u;
+
+    _client->rearmUpdates();
+
+    while(_client->takeUpdate(&u))
+    {
+        qint64 taken = LatencyMonitor::now();
+
+        _count++;
+
+        if(_quiet)
+        {
+            latency->record(LatencyQueue, taken - u.filterTime);
+            latency->record(LatencyTotal, LatencyMonitor::now() - u.rxTime);
+            continue;
+        }
+
+        //the client's y-axis increases downwards (for the display), print it the right way up
+        _out << _clock.elapsed() << ','
+             << QString("%1").arg(u.id64, 16, 16, QChar('0')).toUpper() << ','
+             << QString::number(u.x, 'f', 3) << ','
+             << QString::number(-u.y, 'f', 3) << ','
+             << QString::number(u.range, 'f', 3) << ','
+             << u.angle << ','
+             << u.mode << '\n';
+
+        qint64 done = LatencyMonitor::now();
+
+        latency->record(LatencyQueue, taken - u.filterTime);
+        latency->record(LatencyScene, done - taken);
+        latency->record(LatencyTotal, done - u.rxTime);
+    }
+
+    _out.flush();
+}
+
+void PositionStream::statusBarMessage(QString status)
+{
+    qCInfo(lcSerial) << status;
+}
+
+void PositionStream::connectionStateChanged(SerialConnection::ConnectionState state)
+{
+    if(state == SerialConnection::ConnectionFailed)
+    {
+        qWarning() << "connection failed";
+        QCoreApplication::exit(1);
+    }
+    else if(state == SerialConnection::Disconnected)
+    {
+        finished();
+    }
+}
+
+/**
+* @brief finished()
+*        the replay has finished or the port has been closed: print the summary and quit
+* */
+void PositionStream::finished(void)
+{
+    if(_done)
+    {
+        return;
+    }
+
+    _done = true;
+
+    updatesReady();
+
+    qWarning().nospace() << _count << " positions in " << _clock.elapsed() << " ms, "
+                         << _client->droppedUpdates() << " dropped, max queue depth " << _client->updateQueueMaxDepth();
+
+    if(_client->rangeLog()->isOpen())
+    {
+        LogWriter *log = _client->rangeLog();
+
+        log->close();
+
+        qWarning().nospace() << "log: " << log->written() << " records in " << log->files() << " files, "
+                             << log->dropped() << " dropped";
+    }
+
+    LatencyHistogram h[LatencyStages];
+
+    _client->latency()->snapshot(h);
+
+    for(int i = 0; i < LatencyStages; i++)
+    {
+        qWarning().nospace() << LatencyMonitor::stageName(i) << ": p50 " << h[i].percentile(50) / 1000.0
+                             << " us, p99 " << h[i].percentile(99) / 1000.0 << " us, max " << h[i].max() / 1000.0 << " us";
+    }
+
+    QCoreApplication::quit();
+}
@@ -0,0 +1,53 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: PositionStream.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef POSITIONSTREAM_H
+#define POSITIONSTREAM_H
+
+#include <QObject>
+#include <QTextStream>
+#include <QElapsedTimer>
+
+#include "SerialConnection.h"
+
+class RTLSClient;
+
+/**
+* @brief PositionStream
+*        Takes the place of the GraphicsWidget in the headless application: drains the client's update queue
+*        and writes every position to stdout as a CSV line
+*        time_ms,tag,x,y,range,angle,mode
+*/
+class PositionStream : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PositionStream(RTLSClient *client, bool quiet, QObject *parent = 0);
+
+    quint64 count(void) const { return _count; }
+
+public slots:
+    void updatesReady(void);
+    void statusBarMessage(QString status);
+    void connectionStateChanged(SerialConnection::ConnectionState state);
+    void finished(void);
+
+private:
+    RTLSClient *_client;
+    QTextStream _out;
+    QElapsedTimer _clock;
+    quint64 _count;
+    bool _quiet;     //no position lines, only the summary at the end
+    bool _done;
+};
+
+#endif // POSITIONSTREAM_H
@@ -0,0 +1,426 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: main.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "SerialConnection.h"
+#include "RTLSClient.h"
+#include "ReplaySource.h"
+#include "PositionFilter.h"
+#include "PositionStream.h"
+#include "SessionFile.h"
+#include "SlidingMedian.h"
+#include "LogCategories.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <stdio.h>
+#include <string.h>
+
+/**
+* @brief the headless application main entry point
+*        rtlsheadless --port /dev/ttyACM0
+*        rtlsheadless --replay session.cap --speed 0
+*        rtlsheadless --replay session.cap --speed 0 --quiet [--log ./Logs --log-format bin]
+*            (throughput benchmark: compare the summary with and without the range log)
+*        rtlsheadless --query session.ses [--query session_1.ses] [--tag 1A2B] [--from 2024-01-31T06:00] [--to ...]
+*            (prints the selected reports of session files to stdout as CSV)
+*        rtlsheadless --bench-logging 1000000
+*            (cost of a debug trace per report with qDebug(), and with qCDebug() when its category is on and off)
+*        rtlsheadless --bench-median 100000
+*            (cost of the median motion filter per report at windows 5 to 201, SlidingMedian against the sort it replaced)
+*        everything runs in the main thread: serial port/replay -> frame decoding -> RTLS client -> stdout
+*/
+static qint64 parseTime(const QString &s, qint64 value)
+{
+    bool ok;
+    qint64 ms = s.toLongLong(&ok);
+
+    if(s.isEmpty())
+    {
+        return value;
+    }
+
+    if(ok)
+    {
+        return ms;
+    }
+
+    QDateTime t = QDateTime::fromString(s, Qt::ISODate);
+
+    return t.isValid() ? t.toMSecsSinceEpoch() : value;
+}
+
+/**
+* @brief query()
+*        select the reports of a tag and a time range from session files (see SessionFile.h)
+*/
+static int query(const QStringList &files, int addr16, qint64 from, qint64 to)
+{
+    QTextStream out(stdout);
+    QElapsedTimer clock;
+    qint64 selectTime = 0;
+    qint64 total = 0;
+
+    out << "time_ms,tag,seq,x,y,range,angle,mode,accX,accY,accZ\n";
+
+    foreach(const QString &file, files)
+    {
+        SessionReader reader;
+        QVector<range_log_t> records;
+
+        if(!reader.open(file))
+        {
+            fprintf(stderr, "cannot read the session %s\n", qPrintable(file));
+            return 1;
+        }
+
+        clock.start();
+        reader.select(addr16, from, to, &records);
+        selectTime += clock.nsecsElapsed();
+
+        foreach(const range_log_t &r, records)
+        {
+            out << r.time << ',' << QString("%1").arg(r.addr16, 4, 16, QChar('0')).toUpper() << ','
+                << r.seq << ',' << r.x << ',' << r.y << ',' << r.range << ',' << r.angle << ','
+                << r.mode << ',' << r.accX << ',' << r.accY << ',' << r.accZ << '\n';
+        }
+
+        out.flush();
+
+        qWarning().nospace() << file << ": " << reader.rows() << " reports in " << reader.chunks() << " chunks, "
+                             << records.size() << " selected";
+
+        total += records.size();
+    }
+
+    qWarning().nospace() << total << " reports selected in " << selectTime / 1000000.0 << " ms";
+
+    return 0;
+}
+
+static void discardMessage(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    Q_UNUSED(type);
+    Q_UNUSED(context);
+    Q_UNUSED(message);
+}
+
+/**
+* @brief benchLogging()
+*        time \a reports traces like the one of SerialConnection::writeData(), the messages are formatted and
+*        then dropped by the message handler, so only the cost on the reporting thread is measured
+*/
+static int benchLogging(int reports)
+{
+    QByteArray data("getDlist\r\n");
+    QElapsedTimer clock;
+    qint64 ns[3];
+    const char *names[3] = { "qDebug()", "qCDebug(), category on", "qCDebug(), category off" };
+    QtMessageHandler previous = qInstallMessageHandler(discardMessage);
+    bool serialEnabled = lcSerial().isDebugEnabled();
+
+    clock.start();
+    for(int i = 0; i < reports; i++)
+    {
+        qDebug() << "send:" << data.constData() << i;
+    }
+    ns[0] = clock.nsecsElapsed();
+
+    setLogCategoryEnabled(LogSerial, true);
+    clock.restart();
+    for(int i = 0; i < reports; i++)
+    {
+        qCDebug(lcSerial) << "send:" << data.constData() << i;
+    }
+    ns[1] = clock.nsecsElapsed();
+
+    setLogCategoryEnabled(LogSerial, false);
+    clock.restart();
+    for(int i = 0; i < reports; i++)
+    {
+        qCDebug(lcSerial) << "send:" << data.constData() << i;
+    }
+    ns[2] = clock.nsecsElapsed();
+
+    setLogCategoryEnabled(LogSerial, serialEnabled);
+    qInstallMessageHandler(previous);
+
+    for(int i = 0; i < 3; i++)
+    {
+        double perReport = (double)ns[i] / qMax(reports, 1);
+
+        //at 1000 reports/s a trace per report costs perReport us of every ms
+        qWarning().nospace() << names[i] << ": " << perReport << " ns per trace, "
+                             << perReport / 1000.0 << " ms per second at 1000 reports/s ("
+                             << perReport / 10000.0 << "% of a core)";
+    }
+
+    return 0;
+}
+
+/**
+* @brief r95Sort()
+*        the quicksort the median motion filter ran on a copy of each window before SlidingMedian,
+*        kept as the reference of benchMedian()
+* */
+static void r95Sort(double s[], int l, int r)
+{
+    int i,j;
+    double x;
+    if(l<r)
+    {
+        i = l;
+        j = r;
+        x = s[i];
+        while(i<j)
+        {
+            while (i<j&&s[j]>x) j--;
+            if (i<j) s[i++] = s[j];
+            while (i<j&&s[i]<x) i++;
+            if (i < j) s[j--] = s[i];
+        }
+        s[i] = x;
+        r95Sort(s, l, i-1);
+        r95Sort(s, i+1, r);
+    }
+}
+
+/**
+* @brief benchMedian()
+*        time the median motion filter (x and y) over \a reports positions of a walking tag with +-10 cm of noise,
+*        at window sizes 5 to 201: the previous copy and sort of both windows for every report, against the two
+*        SlidingMedians. Both have to give the same positions.
+*/
+static int benchMedian(int reports)
+{
+    static const int windows[] = { 5, 11, 25, 51, 101, 201 };
+    QVector<double> inX(reports), inY(reports);
+    QVector<double> sortX(reports), sortY(reports);
+    QVector<double> heapX(reports), heapY(reports);
+    quint32 seed = 1;
+    int result = 0;
+
+    for(int i = 0; i < reports; i++)
+    {
+        //1 m/s, 10 reports/s, back and forth along 20 m
+        double walk = (i % 400) * 0.1;
+
+        seed = seed * 1664525 + 1013904223;
+        inX[i] = ((walk < 20) ? walk : (40 - walk)) + ((int)((seed >> 8) % 2001) - 1000) / 10000.0;
+        seed = seed * 1664525 + 1013904223;
+        inY[i] = 5.0 + ((int)((seed >> 8) % 2001) - 1000) / 10000.0;
+    }
+
+    for(unsigned int w = 0; w < (sizeof(windows) / sizeof(windows[0])); w++)
+    {
+        int window = windows[w];
+        QVector<double> hisX(window), hisY(window), tempX(window), tempY(window);
+        SlidingMedian medianX(window), medianY(window);
+        QElapsedTimer clock;
+        qint64 nsSort, nsHeap;
+        int mismatches = 0;
+
+        sortX.fill(0); sortY.fill(0);
+        heapX.fill(0); heapY.fill(0);
+
+        clock.start();
+        for(int i = 0; i < reports; i++)
+        {
+            hisX[i % window] = inX.at(i);
+            hisY[i % window] = inY.at(i);
+
+            if(i >= window)
+            {
+                memcpy(tempX.data(), hisX.constData(), window * sizeof(double));
+                memcpy(tempY.data(), hisY.constData(), window * sizeof(double));
+
+                r95Sort(tempX.data(), 0, window - 1);
+                r95Sort(tempY.data(), 0, window - 1);
+
+                sortX[i] = (tempX.at(window/2) + tempX.at(window/2 - 1)) / 2;
+                sortY[i] = (tempY.at(window/2) + tempY.at(window/2 - 1)) / 2;
+            }
+        }
+        nsSort = clock.nsecsElapsed();
+
+        clock.restart();
+        for(int i = 0; i < reports; i++)
+        {
+            medianX.add(inX.at(i));
+            medianY.add(inY.at(i));
+
+            if(medianX.ready())
+            {
+                heapX[i] = medianX.median();
+                heapY[i] = medianY.median();
+            }
+        }
+        nsHeap = clock.nsecsElapsed();
+
+        for(int i = 0; i < reports; i++)
+        {
+            if((sortX.at(i) != heapX.at(i)) || (sortY.at(i) != heapY.at(i)))
+            {
+                mismatches++;
+            }
+        }
+
+        qWarning().nospace() << "window " << window << ": sort " << (double)nsSort / qMax(reports, 1)
+                             << " ns, sliding median " << (double)nsHeap / qMax(reports, 1)
+                             << " ns per report (x and y), " << mismatches << " mismatches";
+
+        if(mismatches > 0)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    app.setOrganizationName("Jiulin");
+    app.setApplicationName("UWB-X2-AOA-headless");
+
+    qRegisterMetaType<SerialConnection::ConnectionState>("SerialConnection::ConnectionState");
+
+    QCommandLineParser parser;
+    QCommandLineOption portOption("port", "Serial port name or device path of the node (e.g. /dev/ttyACM0).", "name");
+    QCommandLineOption replayOption("replay", "Replay a capture file (.cap) instead of connecting to a node.", "file");
+    QCommandLineOption speedOption("speed", "Replay speed: 1 = real time, N = N times faster, 0 = as fast as possible.", "speed", "1");
+    QCommandLineOption filterOption("filter", "Position filter: none, median, alpha-beta or kalman.", "filter", "none");
+    QCommandLineOption quietOption("quiet", "Do not print the positions, only the summary at the end.");
+    QCommandLineOption logOption("log", "Write the range log into this directory.", "dir");
+    QCommandLineOption logFormatOption("log-format", "Range log format: csv, bin or ses (session).", "format", "csv");
+    QCommandLineOption queryOption("query", "Print the reports of a session file (.ses), can be repeated.", "file");
+    QCommandLineOption tagOption("tag", "Only the reports of this tag (hex addr16) for --query.", "addr16");
+    QCommandLineOption fromOption("from", "Only the reports from this time (ISO date or ms) for --query.", "time");
+    QCommandLineOption toOption("to", "Only the reports up to this time (ISO date or ms) for --query.", "time");
+    QCommandLineOption benchLoggingOption("bench-logging", "Time this many debug traces with the log categories on and off.", "traces");
+    QCommandLineOption benchMedianOption("bench-median", "Time the median motion filter over this many reports at windows 5 to 201.", "reports");
+
+    parser.setApplicationDescription("Streams the tag positions reported by a PDOA node to stdout as CSV.");
+    parser.addHelpOption();
+    parser.addOption(portOption);
+    parser.addOption(replayOption);
+    parser.addOption(speedOption);
+    parser.addOption(filterOption);
+    parser.addOption(quietOption);
+    parser.addOption(logOption);
+    parser.addOption(logFormatOption);
+    parser.addOption(queryOption);
+    parser.addOption(tagOption);
+    parser.addOption(fromOption);
+    parser.addOption(toOption);
+    parser.addOption(benchLoggingOption);
+    parser.addOption(benchMedianOption);
+    parser.process(app);
+
+    if(parser.isSet(benchLoggingOption))
+    {
+        return benchLogging(parser.value(benchLoggingOption).toInt());
+    }
+
+    if(parser.isSet(benchMedianOption))
+    {
+        return benchMedian(parser.value(benchMedianOption).toInt());
+    }
+
+    if(parser.isSet(queryOption))
+    {
+        bool ok = true;
+        int addr16 = parser.isSet(tagOption) ? parser.value(tagOption).toInt(&ok, 16) : -1;
+
+        if(!ok)
+        {
+            fprintf(stderr, "bad tag %s\n", qPrintable(parser.value(tagOption)));
+            return 1;
+        }
+
+        return query(parser.values(queryOption), addr16,
+                     parseTime(parser.value(fromOption), Q_INT64_C(0)),
+                     parseTime(parser.value(toOption), Q_INT64_C(0x7FFFFFFFFFFFFFFF)));
+    }
+
+    if(parser.isSet(portOption) == parser.isSet(replayOption))
+    {
+        fprintf(stderr, "one of --port or --replay is needed\n");
+        parser.showHelp(1);
+    }
+
+    if(parser.isSet(replayOption) && !QFile::exists(parser.value(replayOption)))
+    {
+        fprintf(stderr, "cannot find %s\n", qPrintable(parser.value(replayOption)));
+        return 1;
+    }
+
+    int filter = QStringList({"none", "median", "alpha-beta", "kalman"}).indexOf(parser.value(filterOption));
+    int logFormat = QStringList({"csv", "bin", "ses"}).indexOf(parser.value(logFormatOption));
+
+    if(filter < 0)
+    {
+        fprintf(stderr, "unknown filter %s\n", qPrintable(parser.value(filterOption)));
+        return 1;
+    }
+
+    if(logFormat < 0)
+    {
+        fprintf(stderr, "unknown log format %s\n", qPrintable(parser.value(logFormatOption)));
+        return 1;
+    }
+
+    SerialConnection connection;
+    RTLSClient client(&connection);
+    ReplaySource replay(&connection);
+    PositionStream stream(&client, parser.isSet(quietOption));
+
+    client.setAppVersion(app.applicationName());
+    client.setDefaultFilter(filter);
+
+    if(parser.isSet(logOption) &&
+       !client.rangeLog()->open(parser.value(logOption), "rtlsheadless", (LogWriter::Format)logFormat))
+    {
+        fprintf(stderr, "cannot create the log in %s\n", qPrintable(parser.value(logOption)));
+        return 1;
+    }
+
+    //the client and the stream are in the same thread, updatesReady() is a direct call from the parser
+    QObject::connect(&client, SIGNAL(updatesReady()), &stream, SLOT(updatesReady()));
+    QObject::connect(&client, SIGNAL(statusBarMessage(QString)), &stream, SLOT(statusBarMessage(QString)));
+    QObject::connect(&connection, SIGNAL(statusBarMessage(QString)), &stream, SLOT(statusBarMessage(QString)));
+    QObject::connect(&connection, SIGNAL(connectionStateChanged(SerialConnection::ConnectionState)),
+                     &stream, SLOT(connectionStateChanged(SerialConnection::ConnectionState)));
+    QObject::connect(&replay, SIGNAL(finished(int,qint64,qint64)), &stream, SLOT(finished()));
+
+    if(parser.isSet(replayOption))
+    {
+        QMetaObject::invokeMethod(&replay, "start", Qt::QueuedConnection,
+                                  Q_ARG(QString, parser.value(replayOption)),
+                                  Q_ARG(double, parser.value(speedOption).toDouble()));
+    }
+    else
+    {
+        QMetaObject::invokeMethod(&connection, "openPort", Qt::QueuedConnection,
+                                  Q_ARG(QString, parser.value(portOption)));
+    }
+
+    return app.exec();
+}
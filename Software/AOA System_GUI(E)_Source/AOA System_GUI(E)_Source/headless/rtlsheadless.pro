@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Headless console application: the RTLS core without the GUI,
+# streams the tag positions to stdout as CSV (Linux/macOS/Windows, QtCore only)
+#
+#-------------------------------------------------
+
+QT       = core serialport
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TARGET = rtlsheadless
+TEMPLATE = app
+
+include(../core.pri)
+
+SOURCES += main.cpp \
+    PositionStream.cpp
+
+HEADERS += \
+    PositionStream.h
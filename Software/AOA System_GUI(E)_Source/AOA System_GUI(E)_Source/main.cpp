@@ -12,7 +12,9 @@
 
 #include "RTLSDisplayApplication.h"
 #include "mainwindow.h"
+#include "ReplaySource.h"
 #include <QApplication>
+#include <QCommandLineParser>
 
 /**
 * @brief this is the application main entry point
@@ -22,7 +24,24 @@ int main(int argc, char *argv[])
 {
     RTLSDisplayApplication app(argc, argv);
 
+    //--replay <capture> [--speed N]: replay a recorded session instead of connecting to a node
+    QCommandLineParser parser;
+    QCommandLineOption replayOption("replay", "Replay a capture file (.cap) recorded with Start Log.", "file");
+    QCommandLineOption speedOption("speed", "Replay speed: 1 = real time, N = N times faster, 0 = as fast as possible.", "speed", "1");
+
+    parser.addHelpOption();
+    parser.addOption(replayOption);
+    parser.addOption(speedOption);
+    parser.process(app);
+
     app.mainWindow()->show();
 
+    if(parser.isSet(replayOption))
+    {
+        QMetaObject::invokeMethod(app.replaySource(), "start", Qt::QueuedConnection,
+                                  Q_ARG(QString, parser.value(replayOption)),
+                                  Q_ARG(double, parser.value(speedOption).toDouble()));
+    }
+
     return app.QApplication::exec();
 }
@@ -0,0 +1,240 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: ConsoleModel.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "ConsoleModel.h"
+
+#include <limits.h>
+
+ConsoleModel::ConsoleModel(int capacity, QObject *parent) :
+    QAbstractListModel(parent),
+    _lines(capacity),
+    _rows(capacity),
+    _pending(capacity),
+    _paused(false),
+    _hex(false),
+    _dropped(0)
+{
+}
+
+int ConsoleModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : _rows.count();
+}
+
+QVariant ConsoleModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || (index.row() >= _rows.count()) || (role != Qt::DisplayRole))
+    {
+        return QVariant();
+    }
+
+    const QByteArray &line = _lines.at(_rows.at(_rows.firstIndex() + index.row()));
+
+    if(_hex)
+    {
+        return QString::fromLatin1(line.toHex(' ').toUpper());
+    }
+
+    return QString::fromUtf8(line);
+}
+
+bool ConsoleModel::matches(const QByteArray &line) const
+{
+    if(_filter.pattern().isEmpty())
+    {
+        return true;
+    }
+
+    return _filter.match(QString::fromUtf8(line)).hasMatch();
+}
+
+void ConsoleModel::append(const QByteArray &chunk)
+{
+    QList<QByteArray> lines = chunk.split('\n');
+
+    //the chunk ends with "\r\n", so the last part is empty
+    if(!lines.isEmpty() && lines.last().isEmpty())
+    {
+        lines.removeLast();
+    }
+
+    for(int i = 0; i < lines.size(); i++)
+    {
+        if(lines.at(i).endsWith('\r'))
+        {
+            lines[i].chop(1);
+        }
+    }
+
+    if(_paused)
+    {
+        for(int i = 0; i < lines.size(); i++)
+        {
+            if(_pending.isFull())
+            {
+                _dropped++;
+            }
+
+            _pending.append(lines.at(i));
+        }
+
+        return;
+    }
+
+    appendLines(lines);
+}
+
+/**
+* @brief appendLines()
+*        drop the rows of the lines which are pushed out of the ring, then insert the rows of the new lines
+*        (one removal and one insertion per chunk, whatever the number of lines kept)
+* */
+void ConsoleModel::appendLines(const QList<QByteArray> &lines)
+{
+    int capacity = _lines.capacity();
+    int first = qMax(0, lines.size() - capacity);   //only the last capacity lines can be kept
+    int evict = qMax(0, _lines.count() + (lines.size() - first) - capacity);
+    QList<int> added;
+
+    //the line indexes only grow, renumber them well before they overflow
+    if(_lines.lastIndex() > (INT_MAX - 2 * capacity))
+    {
+        setFilter(_filter);
+    }
+
+    if(evict > 0)
+    {
+        int limit = _lines.firstIndex() + evict;
+        int rows = 0;
+
+        while((rows < _rows.count()) && (_rows.at(_rows.firstIndex() + rows) < limit))
+        {
+            rows++;
+        }
+
+        if(rows > 0)
+        {
+            beginRemoveRows(QModelIndex(), 0, rows - 1);
+
+            for(int i = 0; i < rows; i++)
+            {
+                _rows.removeFirst();
+            }
+
+            endRemoveRows();
+        }
+    }
+
+    for(int i = first; i < lines.size(); i++)
+    {
+        _lines.append(lines.at(i));
+
+        if(matches(lines.at(i)))
+        {
+            added.append(_lines.lastIndex());
+        }
+    }
+
+    if(!added.isEmpty())
+    {
+        beginInsertRows(QModelIndex(), _rows.count(), _rows.count() + added.size() - 1);
+
+        for(int i = 0; i < added.size(); i++)
+        {
+            _rows.append(added.at(i));
+        }
+
+        endInsertRows();
+    }
+}
+
+void ConsoleModel::clear(void)
+{
+    beginResetModel();
+
+    _lines.clear();
+    _rows.clear();
+    _pending.clear();
+    _dropped = 0;
+
+    endResetModel();
+}
+
+void ConsoleModel::setPaused(bool paused)
+{
+    if(_paused == paused)
+    {
+        return;
+    }
+
+    _paused = paused;
+
+    if(!_paused && !_pending.isEmpty())
+    {
+        QList<QByteArray> lines;
+
+        for(int i = _pending.firstIndex(); i <= _pending.lastIndex(); i++)
+        {
+            lines.append(_pending.at(i));
+        }
+
+        _pending.clear();
+
+        appendLines(lines);
+    }
+}
+
+/**
+* @brief setFilter()
+*        the rows are rebuilt from the whole ring, the lines are renumbered from 0 at the same time
+* */
+void ConsoleModel::setFilter(const QRegularExpression &filter)
+{
+    QContiguousCache<QByteArray> lines(_lines.capacity());
+
+    beginResetModel();
+
+    _filter = filter;
+
+    for(int i = _lines.firstIndex(); (i <= _lines.lastIndex()) && !_lines.isEmpty(); i++)
+    {
+        lines.append(_lines.at(i));
+    }
+
+    _lines = lines;
+    _rows.clear();
+
+    for(int i = _lines.firstIndex(); (i <= _lines.lastIndex()) && !_lines.isEmpty(); i++)
+    {
+        if(matches(_lines.at(i)))
+        {
+            _rows.append(i);
+        }
+    }
+
+    endResetModel();
+}
+
+void ConsoleModel::setHexMode(bool hex)
+{
+    if(_hex == hex)
+    {
+        return;
+    }
+
+    _hex = hex;
+
+    if(!_rows.isEmpty())
+    {
+        emit dataChanged(index(0), index(_rows.count() - 1), QVector<int>() << Qt::DisplayRole);
+    }
+}
@@ -0,0 +1,76 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: ConsoleModel.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef CONSOLEMODEL_H
+#define CONSOLEMODEL_H
+
+#include <QAbstractListModel>
+#include <QContiguousCache>
+#include <QRegularExpression>
+
+#define CONSOLE_LINES   (5000)  //lines of scrollback kept by the serial console
+
+/**
+ * The ConsoleModel class is the model of the serial console, one row per line received from the node.
+ *
+ * The lines are kept in a ring of CONSOLE_LINES (the oldest line is dropped for each new one once it is full),
+ * and the rows are the lines which match the filter, so appending a chunk costs the same whatever the scrollback:
+ * one row removal for the dropped lines and one row insertion for the new ones. The text is only made in data(),
+ * i.e. for the rows the view actually paints, as text or as hex bytes.
+ *
+ * While paused the model does not change, the received lines wait in a second ring of the same size and are
+ * appended when it is resumed (the oldest ones are dropped and counted if more arrive in the meantime).
+ */
+class ConsoleModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit ConsoleModel(int capacity = CONSOLE_LINES, QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    /**
+     * Add the lines of \a chunk, one or more lines each ending with "\r\n" (see SerialConnection::consoleData()).
+     */
+    void append(const QByteArray &chunk);
+    void clear(void);
+
+    void setPaused(bool paused);
+    bool isPaused(void) const { return _paused; }
+
+    /**
+     * Only show the lines matching \a filter (an empty pattern shows all), the rows are rebuilt.
+     */
+    void setFilter(const QRegularExpression &filter);
+
+    void setHexMode(bool hex);
+    bool hexMode(void) const { return _hex; }
+
+    int dropped(void) const { return _dropped; }
+
+private:
+    void appendLines(const QList<QByteArray> &lines);
+    bool matches(const QByteArray &line) const;
+
+    QContiguousCache<QByteArray> _lines;
+    QContiguousCache<int> _rows;        //index in _lines of the line of each row
+    QContiguousCache<QByteArray> _pending;
+
+    QRegularExpression _filter;
+    bool _paused;
+    bool _hex;
+    int _dropped;       //lines which did not fit into _pending while paused
+};
+
+#endif // CONSOLEMODEL_H
@@ -0,0 +1,250 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: FloorplanPyramid.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "FloorplanPyramid.h"
+#include "LogCategories.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QPainter>
+#include <QSettings>
+#include <qmath.h>
+
+#define TILE_KEY(level, i, j)   (((quint64)(level) << 48) | ((quint64)(i) << 24) | (quint64)(j))
+
+FloorplanPyramid::FloorplanPyramid() :
+    _levels(0),
+    _tiles(FP_CACHE_KB)
+{
+}
+
+void FloorplanPyramid::clear(void)
+{
+    _dir.clear();
+    _size = QSize();
+    _levels = 0;
+    _tiles.clear();
+}
+
+/**
+* @brief cacheDir()
+*        the directory of the pyramid of the image at \a path
+* */
+QString FloorplanPyramid::cacheDir(const QString &path)
+{
+    QByteArray hash = QCryptographicHash::hash(QFileInfo(path).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+
+    return QString(FP_CACHE_DIR) + "/" + QString::fromLatin1(hash.toHex().left(16));
+}
+
+bool FloorplanPyramid::load(const QString &path)
+{
+    QFileInfo info(path);
+    QString dir;
+
+    clear();
+
+    if(path.isEmpty() || !info.exists())
+    {
+        return false;
+    }
+
+    dir = cacheDir(path);
+
+    {
+        QSettings index(dir + "/" + FP_INDEX_FILE, QSettings::IniFormat);
+
+        //up to date pyramid of the same image
+        if((index.value("source").toString() == info.absoluteFilePath()) &&
+           (index.value("bytes").toLongLong() == info.size()) &&
+           (index.value("modified").toLongLong() == info.lastModified().toMSecsSinceEpoch()) &&
+           (index.value("tile").toInt() == FP_TILE_SIZE) &&
+           (index.value("levels").toInt() > 0))
+        {
+            _dir = dir;
+            _size = QSize(index.value("width").toInt(), index.value("height").toInt());
+            _levels = index.value("levels").toInt();
+
+            return true;
+        }
+    }
+
+    if(!generate(path, dir))
+    {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+* @brief generate()
+*        read the full image once and write the tiles of all its levels and the index into \a dir
+* */
+bool FloorplanPyramid::generate(const QString &path, const QString &dir)
+{
+    QFileInfo info(path);
+    QImageReader reader(path);
+    QImage image;
+    int level = 0;
+
+    if(!reader.read(&image))
+    {
+        qCWarning(lcScene) << "floorplan" << path << "could not be read:" << reader.errorString();
+        return false;
+    }
+
+    QDir(dir).removeRecursively();
+
+    if(!QDir().mkpath(dir))
+    {
+        qCWarning(lcScene) << "floorplan cache" << dir << "could not be created";
+        return false;
+    }
+
+    qCDebug(lcScene) << "floorplan" << path << image.size() << "generating the tile pyramid in" << dir;
+
+    _dir = dir;
+    _size = image.size();
+
+    while(true)
+    {
+        int columns = (image.width() + FP_TILE_SIZE - 1) / FP_TILE_SIZE;
+        int rows = (image.height() + FP_TILE_SIZE - 1) / FP_TILE_SIZE;
+
+        for(int i = 0; i < columns; i++)
+        {
+            for(int j = 0; j < rows; j++)
+            {
+                QImage t = image.copy(i * FP_TILE_SIZE, j * FP_TILE_SIZE,
+                                      qMin(FP_TILE_SIZE, image.width() - i * FP_TILE_SIZE),
+                                      qMin(FP_TILE_SIZE, image.height() - j * FP_TILE_SIZE));
+
+                if(!t.save(tilePath(level, i, j), "PNG"))
+                {
+                    qCWarning(lcScene) << "floorplan tile" << tilePath(level, i, j) << "could not be written";
+                    return false;
+                }
+            }
+        }
+
+        level++;
+
+        //the last level fits in one tile
+        if((columns == 1) && (rows == 1))
+        {
+            break;
+        }
+
+        image = image.scaled(qMax(1, image.width() / 2), qMax(1, image.height() / 2),
+                             Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    _levels = level;
+
+    //written last, so an interrupted generation is never taken as a valid pyramid
+    {
+        QSettings index(dir + "/" + FP_INDEX_FILE, QSettings::IniFormat);
+
+        index.setValue("source", info.absoluteFilePath());
+        index.setValue("bytes", info.size());
+        index.setValue("modified", info.lastModified().toMSecsSinceEpoch());
+        index.setValue("tile", FP_TILE_SIZE);
+        index.setValue("width", _size.width());
+        index.setValue("height", _size.height());
+        index.setValue("levels", _levels);
+        index.sync();
+    }
+
+    return true;
+}
+
+QString FloorplanPyramid::tilePath(int level, int i, int j) const
+{
+    return QString("%1/%2_%3_%4.png").arg(_dir).arg(level).arg(i).arg(j);
+}
+
+QPixmap FloorplanPyramid::tile(int level, int i, int j)
+{
+    quint64 key = TILE_KEY(level, i, j);
+    QPixmap *cached = _tiles.object(key);
+
+    if(cached)
+    {
+        return *cached;
+    }
+
+    QPixmap pm(tilePath(level, i, j));
+
+    if(!pm.isNull())
+    {
+        _tiles.insert(key, new QPixmap(pm), (pm.width() * pm.height() * pm.depth() / 8) / 1024);
+    }
+
+    return pm;
+}
+
+void FloorplanPyramid::draw(QPainter *painter, const QRectF &rect)
+{
+    if(isNull())
+    {
+        return;
+    }
+
+    //device pixels per full resolution image pixel
+    qreal scale = qSqrt(qAbs(painter->worldTransform().determinant())) * painter->device()->devicePixelRatioF();
+    int level = 0;
+
+    //a tile pixel of the level is 2^level image pixels, i.e. 2^level * scale device pixels:
+    //rounding down keeps that at most 1 (never larger than a device pixel)
+    if(scale > 0)
+    {
+        level = qBound(0, (int)qFloor(qLn(1 / scale) / qLn(2)), _levels - 1);
+    }
+
+    QRectF area = rect.intersected(QRectF(0, 0, _size.width(), _size.height()));
+
+    if(area.isEmpty())
+    {
+        return;
+    }
+
+    //size of a tile of this level in full resolution pixels
+    qreal span = (qreal)FP_TILE_SIZE * (1 << level);
+    int i0 = qFloor(area.left() / span);
+    int i1 = qFloor((area.right() - 1e-6) / span);
+    int j0 = qFloor(area.top() / span);
+    int j1 = qFloor((area.bottom() - 1e-6) / span);
+
+    for(int i = i0; i <= i1; i++)
+    {
+        for(int j = j0; j <= j1; j++)
+        {
+            QPixmap pm = tile(level, i, j);
+
+            if(!pm.isNull())
+            {
+                //the last column/row of a level can be narrower, and a level is not always exactly half
+                qreal w = qMin(span, _size.width() - i * span);
+                qreal h = qMin(span, _size.height() - j * span);
+
+                painter->drawPixmap(QRectF(i * span, j * span, w, h), pm, QRectF(pm.rect()));
+            }
+        }
+    }
+}
@@ -0,0 +1,82 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: FloorplanPyramid.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef FLOORPLANPYRAMID_H
+#define FLOORPLANPYRAMID_H
+
+#include <QCache>
+#include <QPixmap>
+#include <QString>
+#include <QSize>
+
+class QPainter;
+class QImage;
+
+#define FP_TILE_SIZE    (512)                           //tile size of every level, in pixels of that level
+#define FP_CACHE_KB     (64 * 1024)                     //memory limit of the tiles loaded from the disk cache
+#define FP_CACHE_DIR    "./PDOARTLSfloorplan_cache"     //next to the view config (./PDOARTLSview_config.xml)
+#define FP_INDEX_FILE   "pyramid.ini"
+
+/**
+ * The FloorplanPyramid class holds the floorplan image as a mipmapped tile pyramid.
+ *
+ * Level 0 is the full resolution image, each next level is half the size of the previous one, down to the first
+ * level which fits in one tile. Every level is cut into FP_TILE_SIZE tiles stored as PNG files in a directory of
+ * FP_CACHE_DIR named after the image path, with an index recording the size and modification time of the image.
+ * The pyramid is only generated when the image is new or has changed, later loads just read the index.
+ *
+ * draw() only loads and draws the tiles covering the exposed rectangle, from the level matching the painter's
+ * scale, so the full resolution image is never held in memory (the loaded tiles are kept in a QCache).
+ */
+class FloorplanPyramid
+{
+public:
+    FloorplanPyramid();
+
+    /**
+     * Use the image at \a path, generating its pyramid if there is no up to date one in the disk cache.
+     * @return false if the image could not be read (the pyramid is then empty)
+     */
+    bool load(const QString &path);
+    void clear(void);
+
+    bool isNull(void) const { return _levels == 0; }
+
+    /**
+     * @return the size of the full resolution image
+     */
+    QSize size(void) const { return _size; }
+    int width(void) const { return _size.width(); }
+    int height(void) const { return _size.height(); }
+    int levels(void) const { return _levels; }
+
+    /**
+     * Draw the part of the floorplan in \a rect (in full resolution image pixels, the painter's transform maps
+     * image pixels to the device). The level is chosen so that a tile pixel is at most one device pixel:
+     * the coarsest level which is still not magnified, so the plan is never blurrier than the screen.
+     */
+    void draw(QPainter *painter, const QRectF &rect);
+
+private:
+    static QString cacheDir(const QString &path);
+    bool generate(const QString &path, const QString &dir);
+    QPixmap tile(int level, int i, int j);
+    QString tilePath(int level, int i, int j) const;
+
+    QString _dir;
+    QSize _size;
+    int _levels;
+
+    QCache<quint64, QPixmap> _tiles;    //cost is in KB
+};
+
+#endif // FLOORPLANPYRAMID_H
@@ -0,0 +1,392 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: TagTableModel.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "TagTableModel.h"
+
+#include "RTLSClient.h"
+
+#include <QBrush>
+#include <algorithm>
+
+#define COLUMN_BIT(c)       (1u << (c))
+#define COLUMNS_POSITION    (COLUMN_BIT(TagTableModel::ColumnX) | COLUMN_BIT(TagTableModel::ColumnY))
+#define COLUMNS_RANGE       (((COLUMN_BIT(TagTableModel::ColumnOffPDoa + 1) - 1)) & ~(COLUMN_BIT(TagTableModel::ColumnRA0) - 1))
+
+TagTableModel::TagTableModel(QObject *parent) :
+    QAbstractTableModel(parent),
+    _flushQueued(false)
+{
+}
+
+int TagTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : _rows.size();
+}
+
+int TagTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant TagTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    static const char *headers[ColumnCount] =
+    {
+        "Tag ID/Label", "Joined", "X\n(m)", "Y\n(m)", "Range (m)", "Angle (°)",
+        "SOS Alarm", "Battery (V)", "CHG",
+        "Acc X", "Acc Y", "Acc Z",
+        "Cali Dist", "Cali Angle",
+        "ID"
+    };
+
+    if((orientation == Qt::Horizontal) && (role == Qt::DisplayRole) && (section >= 0) && (section < ColumnCount))
+    {
+        return QString::fromUtf8(headers[section]);
+    }
+
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+Qt::ItemFlags TagTableModel::flags(const QModelIndex &index) const
+{
+    switch(index.column())
+    {
+        case ColumnID:
+            return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsUserCheckable;
+        case ColumnJoin:
+            return Qt::ItemIsEnabled | Qt::ItemIsUserCheckable;
+        default:
+            return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+    }
+}
+
+/**
+* @brief data()
+*        the texts are formatted here, only for the cells which are painted
+* */
+QVariant TagTableModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || (index.row() >= _rows.size()))
+    {
+        return QVariant();
+    }
+
+    const tag_row_t &r = _rows.at(index.row());
+    int c = index.column();
+
+    switch(role)
+    {
+        case Qt::DisplayRole:
+        {
+            user_cmd_t user_cmd = *(user_cmd_t*)&r.mode;
+
+            if(c == ColumnID) return r.label;
+            if(c == ColumnJoin) return QString(" ");
+            if(c == ColumnIDr) return "0x" + QString::number(r.id64, 16);
+
+            if((c == ColumnX) || (c == ColumnY))
+            {
+                return r.hasPosition ? QString::number((c == ColumnX) ? r.x : r.y, 'f', 3) : QString();
+            }
+
+            if(!r.hasRange)
+            {
+                return QString();
+            }
+
+            switch(c)
+            {
+                case ColumnRA0:     return QString::number(r.range, 'f', 3);
+                case ColumnAngle:   return QString::number(r.angle);
+                case ColumnAlarm:   return (user_cmd.is_alarm == 1) ? "Alarm" : "Normal";
+                case ColumnBattery: return QString::number(user_cmd.battery_val/100.0, 'f', 3);
+                case ColumnCHRG:
+                    if(user_cmd.is_chrg == 0 && user_cmd.is_tdby == 1) return "Charging";
+                    if(user_cmd.is_chrg == 1 && user_cmd.is_tdby == 0) return "Fully Charged";
+                    return "Not Charging";
+                case Column_AccX:
+                case Column_AccY:
+                case Column_AccZ:   return QString::number(0);
+                case ColumnOffRange:
+                case ColumnOffPDoa: return (user_cmd.is_offset_pdoa_zero_bit == 1) ? "Uncalibrated" : "Calibrated";
+                default:            return QString();
+            }
+        }
+
+        case Qt::CheckStateRole:
+            if(c == ColumnID) return r.showLabel ? Qt::Checked : Qt::Unchecked;
+            if(c == ColumnJoin) return r.joined ? Qt::Checked : Qt::Unchecked;
+            break;
+
+        case Qt::ForegroundRole:
+            if(c == ColumnID) return QBrush(r.labelColour);
+            break;
+
+        case Qt::BackgroundRole:
+            if(c == ColumnJoin) return QBrush(r.joined ? r.colour : QColor(Qt::white));
+            if((c == ColumnID) && r.alarm) return QBrush(QColor(185, 0, 0, 127));
+            break;
+
+        case Qt::TextAlignmentRole:
+            if(c == ColumnJoin) return (int)Qt::AlignHCenter;
+            break;
+
+        default:
+            break;
+    }
+
+    return QVariant();
+}
+
+bool TagTableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if(!index.isValid() || (role != Qt::CheckStateRole))
+    {
+        return false;
+    }
+
+    bool checked = (value.toInt() == Qt::Checked);
+
+    if(index.column() == ColumnID)
+    {
+        setShowLabel(index.row(), checked);
+        emit showLabelChanged(_rows.at(index.row()).id64, checked);
+        return true;
+    }
+
+    if(index.column() == ColumnJoin)
+    {
+        setJoined(index.row(), checked);
+        emit joinedChanged(_rows.at(index.row()).id64, checked);
+        return true;
+    }
+
+    return false;
+}
+
+int TagTableModel::addTag(quint64 id64, const QString &label, const QColor &colour, bool joined, bool showLabel)
+{
+    int row = rowOf(id64);
+
+    if(row >= 0)
+    {
+        return row;
+    }
+
+    tag_row_t r;
+
+    r.id64 = id64;
+    r.label = label;
+    r.colour = colour;
+    r.labelColour = QColor(Qt::black);
+    r.joined = joined;
+    r.showLabel = showLabel;
+    r.alarm = false;
+    r.hasPosition = false;
+    r.hasRange = false;
+    r.x = r.y = r.range = 0;
+    r.angle = 0;
+    r.mode = 0;
+    r.dirty = 0;
+
+    row = _rows.size();
+
+    beginInsertRows(QModelIndex(), row, row);
+    _rows.append(r);
+    _index.insert(id64, row);
+    endInsertRows();
+
+    return row;
+}
+
+void TagTableModel::removeTag(int row)
+{
+    if((row < 0) || (row >= _rows.size()))
+    {
+        return;
+    }
+
+    //the pending changes refer to the current row numbers
+    flush();
+
+    beginRemoveRows(QModelIndex(), row, row);
+
+    _index.remove(_rows.at(row).id64);
+    _rows.remove(row);
+
+    for(int i = row; i < _rows.size(); i++)
+    {
+        _index[_rows.at(i).id64] = i;
+    }
+
+    endRemoveRows();
+}
+
+void TagTableModel::clear(void)
+{
+    beginResetModel();
+    _rows.clear();
+    _index.clear();
+    _dirtyRows.clear();
+    endResetModel();
+}
+
+void TagTableModel::markDirty(int row, quint32 columns)
+{
+    tag_row_t &r = _rows[row];
+
+    if(r.dirty == 0)
+    {
+        _dirtyRows.append(row);
+    }
+
+    r.dirty |= columns;
+
+    //one flush for all the changes made before going back to the event loop
+    if(!_flushQueued)
+    {
+        _flushQueued = true;
+        QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+    }
+}
+
+void TagTableModel::setPosition(int row, double x, double y)
+{
+    tag_row_t &r = _rows[row];
+
+    if(r.hasPosition && (r.x == x) && (r.y == y))
+    {
+        return;
+    }
+
+    r.x = x;
+    r.y = y;
+    r.hasPosition = true;
+
+    markDirty(row, COLUMNS_POSITION);
+}
+
+void TagTableModel::setRange(int row, double range, int angle, int mode)
+{
+    tag_row_t &r = _rows[row];
+    quint32 columns = 0;
+
+    if(!r.hasRange)
+    {
+        columns = COLUMNS_RANGE;
+    }
+    else
+    {
+        if(r.range != range) columns |= COLUMN_BIT(ColumnRA0);
+        if(r.angle != angle) columns |= COLUMN_BIT(ColumnAngle);
+        if(r.mode != mode)   columns |= COLUMNS_RANGE & ~(COLUMN_BIT(ColumnRA0) | COLUMN_BIT(ColumnAngle));
+    }
+
+    r.range = range;
+    r.angle = angle;
+    r.mode = mode;
+    r.hasRange = true;
+
+    if(columns)
+    {
+        markDirty(row, columns);
+    }
+}
+
+void TagTableModel::setLabelColour(int row, const QColor &colour)
+{
+    tag_row_t &r = _rows[row];
+
+    if(r.labelColour != colour)
+    {
+        r.labelColour = colour;
+        markDirty(row, COLUMN_BIT(ColumnID));
+    }
+}
+
+void TagTableModel::setAlarm(int row, bool alarm)
+{
+    tag_row_t &r = _rows[row];
+
+    if(r.alarm != alarm)
+    {
+        r.alarm = alarm;
+        markDirty(row, COLUMN_BIT(ColumnID));
+    }
+}
+
+void TagTableModel::setJoined(int row, bool joined)
+{
+    tag_row_t &r = _rows[row];
+
+    if(r.joined != joined)
+    {
+        r.joined = joined;
+        markDirty(row, COLUMN_BIT(ColumnJoin));
+    }
+}
+
+void TagTableModel::setShowLabel(int row, bool show)
+{
+    tag_row_t &r = _rows[row];
+
+    if(r.showLabel != show)
+    {
+        r.showLabel = show;
+        markDirty(row, COLUMN_BIT(ColumnID));
+    }
+}
+
+/**
+* @brief flush()
+*        emit the changes: one dataChanged() per run of consecutive rows with the same changed columns,
+*        covering the columns from the first to the last changed one
+* */
+void TagTableModel::flush(void)
+{
+    _flushQueued = false;
+
+    if(_dirtyRows.isEmpty())
+    {
+        return;
+    }
+
+    std::sort(_dirtyRows.begin(), _dirtyRows.end());
+
+    for(int i = 0; i < _dirtyRows.size(); )
+    {
+        int first = _dirtyRows.at(i);
+        int last = first;
+        quint32 columns = _rows.at(first).dirty;
+        int c0 = 0, c1 = ColumnCount - 1;
+
+        while(((i + 1) < _dirtyRows.size()) && (_dirtyRows.at(i + 1) == last + 1) &&
+              (_rows.at(last + 1).dirty == columns))
+        {
+            last++;
+            i++;
+        }
+        i++;
+
+        while(!(columns & COLUMN_BIT(c0))) c0++;
+        while(!(columns & COLUMN_BIT(c1))) c1--;
+
+        for(int row = first; row <= last; row++)
+        {
+            _rows[row].dirty = 0;
+        }
+
+        emit dataChanged(index(first, c0), index(last, c1));
+    }
+
+    _dirtyRows.clear();
+}
@@ -0,0 +1,122 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: TagTableModel.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef TAGTABLEMODEL_H
+#define TAGTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QColor>
+#include <QHash>
+#include <QVector>
+
+/**
+* @brief tag_row_t
+*        what the tag table shows for one tag, kept as raw values: the texts are only formatted in data(),
+*        i.e. for the rows the view actually paints
+*/
+typedef struct
+{
+    quint64 id64;
+    QString label;
+    QColor  colour;         //the tag's colour in the scene (background of the Joined cell)
+    QColor  labelColour;    //black: seen, red: not joined, dark red: lost
+    bool    joined;
+    bool    showLabel;
+    bool    alarm;          //inside the geo-fencing zone
+    bool    hasPosition;
+    bool    hasRange;
+    double  x, y;
+    double  range;
+    int     angle;
+    int     mode;           //user_cmd_t
+    quint32 dirty;          //columns changed since the last flush(), bit per Column
+} tag_row_t;
+
+/**
+ * The TagTableModel class is the model of the GraphicsWidget's tag table.
+ *
+ * Rows are found by 64-bit address in O(1). The setters only store the values and mark the cells dirty,
+ * flush() (run from the event loop after a batch of updates, or called directly) then emits one dataChanged()
+ * per run of consecutive rows with the same changed columns.
+ * The Tag ID (show label) and Joined check boxes are changed by the user through setData(), which emits
+ * showLabelChanged() and joinedChanged().
+ */
+class TagTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        ColumnID = 0,   ///< 64 bit address of the tag (uint64)
+        ColumnJoin,     ///< join checkbox
+        ColumnX,        ///< X coordinate (double)
+        ColumnY,        ///< Y coordinate (double)
+        ColumnRA0,      ///< range (double)
+        ColumnAngle,    ///< angle (int)
+
+        ColumnAlarm,     //是否按键报警
+        ColumnBattery,   //电池当前电压
+        ColumnCHRG,      //充电状态
+        Column_AccX,     //三轴加速度X轴的值
+        Column_AccY,     //三轴加速度Y轴的值
+        Column_AccZ,     //三轴加速度Z轴的值
+        ColumnOffRange,  //是否距离校正
+        ColumnOffPDoa,   //是否角度校正
+
+        ColumnIDr,      ///< ID raw (hex) hidden
+        ColumnCount
+    };
+
+    explicit TagTableModel(QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole);
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+    /**
+     * Add a row for the tag at the end of the table.
+     * @return the row, or the existing row if the tag is already in the table
+     */
+    int addTag(quint64 id64, const QString &label, const QColor &colour, bool joined, bool showLabel);
+    void removeTag(int row);
+    void clear(void);
+
+    int rowOf(quint64 id64) const { return _index.value(id64, -1); }
+    const tag_row_t &tag(int row) const { return _rows.at(row); }
+
+    void setPosition(int row, double x, double y);
+    void setRange(int row, double range, int angle, int mode);
+    void setLabelColour(int row, const QColor &colour);
+    void setAlarm(int row, bool alarm);
+    void setJoined(int row, bool joined);
+    void setShowLabel(int row, bool show);
+
+public slots:
+    void flush(void);
+
+signals:
+    void joinedChanged(quint64 id64, bool joined);
+    void showLabelChanged(quint64 id64, bool show);
+
+private:
+    void markDirty(int row, quint32 columns);
+
+    QVector<tag_row_t> _rows;
+    QHash<quint64, int> _index;     //id64 -> row
+    QVector<int> _dirtyRows;
+    bool _flushQueued;
+};
+
+#endif // TAGTABLEMODEL_H
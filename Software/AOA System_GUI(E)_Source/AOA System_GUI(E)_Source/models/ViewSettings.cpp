@@ -117,9 +117,14 @@ double ViewSettings::floorplanYOffset() const
     return _floorplanYOffset;
 }
 
-const QPixmap &ViewSettings::floorplanPixmap() const
+FloorplanPyramid &ViewSettings::floorplan()
 {
-    return _floorplanPixmap;
+    return _floorplan;
+}
+
+QSize ViewSettings::floorplanSize() const
+{
+    return _floorplan.size();
 }
 
 const QString &ViewSettings::getFloorplanPath()
@@ -201,11 +206,24 @@ void ViewSettings::setFloorplanYOffset(double arg)
     }
 }
 
-void ViewSettings::setFloorplanPixmap(const QPixmap &arg)
+bool ViewSettings::setFloorplanImage(const QString &path)
 {
-    _floorplanPixmap = arg;
-    floorplanFlipX(true);
+    if (path.isEmpty())
+    {
+        _floorplan.clear();
+    }
+    else if (!_floorplan.load(path))
+    {
+        return false;
+    }
+    else
+    {
+        floorplanFlipX(true);
+    }
+
     emit floorplanPixmapChanged();
+
+    return true;
 }
 
 void ViewSettings::setFloorplanPath(const QString &arg)
@@ -227,7 +245,7 @@ void ViewSettings::viewSettingsChanged()
     double xoffset = floorplanXOffset();
     double yoffset = floorplanYOffset();
 
-    if (!floorplanPixmap().isNull() && xscale != 0 && yscale != 0)
+    if (!_floorplan.isNull() && xscale != 0 && yscale != 0)
     {
         if (floorplanFlipX())
         {
@@ -16,6 +16,9 @@
 #include <QObject>
 #include <QDebug>
 #include <QPixmap>
+#include <QTransform>
+
+#include "FloorplanPyramid.h"
 
 /**
  * The ViewSettings class holds many properties about the view, such as the grid and viewplan settings.
@@ -35,7 +38,6 @@ class ViewSettings : public QObject
     Q_PROPERTY(double floorplanYOffset READ floorplanYOffset WRITE setFloorplanYOffset NOTIFY floorplanYOffsetChanged)
     Q_PROPERTY(bool showGrid READ gridShow WRITE setShowGrid NOTIFY showGridChanged)
     Q_PROPERTY(bool showOrigin READ originShow WRITE setShowOrigin NOTIFY showOriginChanged)
-    Q_PROPERTY(QPixmap floorplanPixmap READ floorplanPixmap WRITE setFloorplanPixmap NOTIFY floorplanPixmapChanged)
 
     Q_PROPERTY(QTransform floorplanTransform READ floorplanTransform)
 
@@ -56,7 +58,11 @@ public:
     double floorplanXOffset() const;
     double floorplanYOffset() const;
 
-    const QPixmap &floorplanPixmap() const;
+    /**
+     * The floorplan image as a tile pyramid, see FloorplanPyramid::draw()
+     */
+    FloorplanPyramid &floorplan();
+    QSize floorplanSize() const;
 
     QTransform floorplanTransform() const;
 
@@ -84,7 +90,11 @@ public slots:
     void setFloorplanXOffset(double arg);
     void setFloorplanYOffset(double arg);
 
-    void setFloorplanPixmap(const QPixmap &arg);
+    /**
+     * Load the floorplan image at \a path (an empty path clears the floorplan).
+     * @return false if the image could not be read
+     */
+    bool setFloorplanImage(const QString &path);
 
     void setShowGrid(bool);
     void setShowOrigin(bool);
@@ -139,7 +149,7 @@ private:
     bool _showOrigin;
     bool _showGrid;
     bool _floorplanSave;
-    QPixmap _floorplanPixmap;
+    FloorplanPyramid _floorplan;
     QString _floorplanPath;
     bool _floorplanShow;
     QTransform _floorplanTransform;
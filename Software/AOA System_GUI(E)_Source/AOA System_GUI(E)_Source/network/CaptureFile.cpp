@@ -0,0 +1,124 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: CaptureFile.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "CaptureFile.h"
+#include "LogCategories.h"
+
+#include <QtEndian>
+#include <QDebug>
+#include <string.h>
+
+CaptureWriter::CaptureWriter()
+{
+}
+
+bool CaptureWriter::open(const QString &path)
+{
+    close();
+
+    _file.setFileName(path);
+
+    if(!_file.open(QIODevice::WriteOnly))
+    {
+        qCWarning(lcFile) << "capture: can't create" << path << _file.errorString();
+        return false;
+    }
+
+    _file.write(CAPTURE_MAGIC, CAPTURE_MAGIC_LEN);
+    _clock.start();
+
+    return true;
+}
+
+void CaptureWriter::close(void)
+{
+    if(_file.isOpen())
+    {
+        _file.close();
+    }
+}
+
+void CaptureWriter::write(const char *data, int length)
+{
+    uchar header[CAPTURE_RECORD_LEN];
+
+    if(!_file.isOpen() || (length <= 0))
+    {
+        return;
+    }
+
+    qToLittleEndian<qint64>(_clock.nsecsElapsed() / 1000, header);
+    qToLittleEndian<qint32>(length, header + 8);
+
+    _file.write((const char *)header, CAPTURE_RECORD_LEN);
+    _file.write(data, length);
+}
+
+CaptureReader::CaptureReader()
+{
+}
+
+bool CaptureReader::open(const QString &path)
+{
+    char magic[CAPTURE_MAGIC_LEN];
+
+    close();
+
+    _file.setFileName(path);
+
+    if(!_file.open(QIODevice::ReadOnly))
+    {
+        qCWarning(lcFile) << "capture: can't open" << path << _file.errorString();
+        return false;
+    }
+
+    if((_file.read(magic, CAPTURE_MAGIC_LEN) != CAPTURE_MAGIC_LEN) || (memcmp(magic, CAPTURE_MAGIC, CAPTURE_MAGIC_LEN) != 0))
+    {
+        qCWarning(lcFile) << "capture: not a capture file" << path;
+        _file.close();
+        return false;
+    }
+
+    return true;
+}
+
+void CaptureReader::close(void)
+{
+    if(_file.isOpen())
+    {
+        _file.close();
+    }
+}
+
+bool CaptureReader::next(qint64 *time_us, QByteArray *data)
+{
+    uchar header[CAPTURE_RECORD_LEN];
+    qint32 length;
+
+    if(!_file.isOpen() || (_file.read((char *)header, CAPTURE_RECORD_LEN) != CAPTURE_RECORD_LEN))
+    {
+        return false;
+    }
+
+    *time_us = qFromLittleEndian<qint64>(header);
+    length = qFromLittleEndian<qint32>(header + 8);
+
+    if((length <= 0) || (length > CAPTURE_MAX_CHUNK))
+    {
+        qCWarning(lcFile) << "capture: corrupted record at" << (_file.pos() - CAPTURE_RECORD_LEN);
+        return false;
+    }
+
+    *data = _file.read(length);
+
+    return (data->size() == length);
+}
@@ -0,0 +1,74 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: CaptureFile.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef CAPTUREFILE_H
+#define CAPTUREFILE_H
+
+#include <QFile>
+#include <QElapsedTimer>
+
+/*
+ * Raw capture of the bytes received from the node, to replay a session through the whole pipeline.
+ *
+ * file   : CAPTURE_MAGIC, then one record per chunk read from the serial port
+ * record : time of the chunk since the start of the capture in us (qint64), chunk length (qint32), chunk bytes
+ *          (all little endian)
+ */
+#define CAPTURE_MAGIC       ("DWCAP001")
+#define CAPTURE_MAGIC_LEN   (8)
+#define CAPTURE_RECORD_LEN  (12)        //record header: time + length
+#define CAPTURE_MAX_CHUNK   (0x100000)  //larger chunks mean a corrupted file
+
+/**
+* @brief CaptureWriter
+*        records the chunks as they are received
+*/
+class CaptureWriter
+{
+public:
+    CaptureWriter();
+
+    bool open(const QString &path);
+    void close(void);
+    bool isOpen(void) const { return _file.isOpen(); }
+
+    void write(const char *data, int length);
+
+private:
+    QFile _file;
+    QElapsedTimer _clock;
+};
+
+/**
+* @brief CaptureReader
+*        reads the chunks back in the order they were received
+*/
+class CaptureReader
+{
+public:
+    CaptureReader();
+
+    bool open(const QString &path);
+    void close(void);
+    bool isOpen(void) const { return _file.isOpen(); }
+
+    /**
+     * Read the next chunk.
+     * @return false at the end of the capture (or if the rest of the file is corrupted)
+     */
+    bool next(qint64 *time_us, QByteArray *data);
+
+private:
+    QFile _file;
+};
+
+#endif // CAPTUREFILE_H
@@ -0,0 +1,167 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: CommandScheduler.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "CommandScheduler.h"
+
+#include <QDebug>
+#include <QTimer>
+#include <string.h>
+
+#include "LatencyMonitor.h"
+#include "LogCategories.h"
+
+CommandScheduler::CommandScheduler(QObject *parent) :
+    QObject(parent),
+    _inFlight(false),
+    _attempt(0),
+    _sent(0),
+    _timeouts(0)
+{
+    _timer = new QTimer(this);
+    _timer->setSingleShot(true);
+    connect(_timer, SIGNAL(timeout()), this, SLOT(timerExpired()));
+}
+
+void CommandScheduler::queue(const QByteArray &data, const QByteArray &reply, int timeout, int retries)
+{
+    node_cmd_t cmd;
+
+    //a poll (it has a reply e.g. getKList) still waiting to be sent will bring the same answer: merge with it.
+    //Not with the one in flight, its reply may predate the caller's reason to ask again.
+    //A command without a reply changes the node's state (e.g. "save"), it is always queued
+    if(!reply.isEmpty())
+    {
+        for(int i = (_inFlight ? 1 : 0); i < _queue.size(); i++)
+        {
+            node_cmd_t &waiting = _queue[i];
+
+            if((waiting.data == data) && (waiting.reply == reply))
+            {
+                waiting.timeout = qMax(waiting.timeout, timeout);
+                waiting.retries = qMax(waiting.retries, retries);
+                return;
+            }
+        }
+    }
+
+    if(_queue.size() >= CMD_QUEUE_MAX)
+    {
+        qCWarning(lcSerial) << "command queue full, dropped:" << data.trimmed();
+        return;
+    }
+
+    cmd.data = data;
+    cmd.reply = reply;
+    cmd.timeout = timeout;
+    cmd.retries = retries;
+
+    _queue.append(cmd);
+
+    if(!_inFlight)
+    {
+        sendNext();
+    }
+}
+
+void CommandScheduler::clear(void)
+{
+    _timer->stop();
+    _queue.clear();
+    _inFlight = false;
+    _attempt = 0;
+}
+
+/**
+* @brief sendNext()
+*        write the command at the head of the queue (again, if it is being retried) and wait for its reply
+* */
+void CommandScheduler::sendNext(void)
+{
+    if(_queue.isEmpty())
+    {
+        _inFlight = false;
+        return;
+    }
+
+    //a copy: a slot of write() may queue() or clear() and change the list
+    const QByteArray data = _queue.first().data;
+
+    _inFlight = true;
+    _sent = LatencyMonitor::now();
+    _timer->start(_queue.first().timeout);
+
+    emit write(data);
+}
+
+bool CommandScheduler::replyReceived(const char *name, int length)
+{
+    if(!_inFlight)
+    {
+        return false;
+    }
+
+    const QByteArray &reply = _queue.first().reply;
+
+    if(reply.isEmpty() || (reply.size() != length) || (memcmp(reply.constData(), name, length) != 0))
+    {
+        return false;
+    }
+
+    qint64 rtt = LatencyMonitor::now() - _sent;
+    node_cmd_t cmd = _queue.takeFirst();
+
+    _timer->stop();
+    _attempt = 0;
+
+    emit commandReplied(cmd.data, rtt);
+
+    sendNext();
+
+    return true;
+}
+
+/**
+* @brief timerExpired()
+*        the pause after a command without a reply is over, or the reply has not come in time
+* */
+void CommandScheduler::timerExpired(void)
+{
+    if(!_inFlight)
+    {
+        return;
+    }
+
+    if(!_queue.first().reply.isEmpty() && (_attempt < _queue.first().retries))
+    {
+        _attempt++;
+
+        qCDebug(lcSerial) << "no reply to" << _queue.first().data.trimmed() << "retry" << _attempt;
+
+        sendNext();
+        return;
+    }
+
+    //taken out before commandFailed() is emitted, its slots may queue() or clear()
+    node_cmd_t cmd = _queue.takeFirst();
+    int attempts = _attempt + 1;
+
+    _attempt = 0;
+
+    if(!cmd.reply.isEmpty())
+    {
+        _timeouts++;
+
+        emit commandFailed(cmd.data, attempts);
+    }
+
+    sendNext();
+}
@@ -0,0 +1,96 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: CommandScheduler.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+
+class QTimer;
+
+#define CMD_TIMEOUT_MS  (500)   //default wait for the reply of a command
+#define CMD_PAUSE_MS    (50)    //pause after a command the node does not reply to (e.g. "pdoaoff", "save")
+#define CMD_QUEUE_MAX   (32)    //commands waiting to be sent, more are dropped
+
+/**
+* @brief node_cmd_t
+*        one command line for the node and how to know it has been done
+*/
+typedef struct
+{
+    QByteArray data;    //the command line, including "\r\n"
+    QByteArray reply;   //root element name of the reply which completes it (e.g. "KList"), empty if there is none
+    int timeout;        //ms to wait for the reply, or the pause before the next command if there is no reply
+    int retries;        //times the command is sent again if the reply does not come in time
+} node_cmd_t;
+
+/**
+* @brief CommandScheduler
+*        Non-blocking queue of the commands sent to the node, it replaces the fixed sleeps between the writes.
+*
+*        Only one command is in flight at a time: the next one is written when the reply of the current one has been
+*        received (see replyReceived()) or, for a command without a reply, when its pause has elapsed. A command
+*        whose reply does not come in time is sent again up to its number of retries, then given up.
+*        The round trip time of every replied command is reported with commandReplied().
+*
+*        It lives on the thread of the serial connection, the writes are emitted with write().
+*/
+class CommandScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CommandScheduler(QObject *parent = 0);
+
+    /**
+     * Queue a command, it is sent straight away if nothing is in flight.
+     * A poll (\a reply not empty) already waiting to be sent is not queued again, it keeps the longer
+     * timeout and the most retries; commands without a reply are always queued.
+     */
+    void queue(const QByteArray &data, const QByteArray &reply = QByteArray(),
+               int timeout = CMD_TIMEOUT_MS, int retries = 0);
+
+    /**
+     * Drop the queued commands and the one in flight (e.g. when the connection is closed).
+     */
+    void clear(void);
+
+    /**
+     * Called with the root element name of each reply frame from the node.
+     * @return true if it completed the command in flight
+     */
+    bool replyReceived(const char *name, int length);
+
+    int pending(void) const { return _queue.size(); }
+    int timeouts(void) const { return _timeouts; }
+
+signals:
+    void write(const QByteArray &data);
+    void commandReplied(const QByteArray &data, qint64 rtt);   //rtt in ns, from the last write to the reply
+    void commandFailed(const QByteArray &data, int attempts);
+
+private slots:
+    void timerExpired(void);
+
+private:
+    void sendNext(void);
+
+    QList<node_cmd_t> _queue;   //the head is the command in flight when _inFlight is set
+    QTimer *_timer;
+    bool _inFlight;
+    int _attempt;               //retries of the command in flight so far
+    qint64 _sent;               //LatencyMonitor::now() of the last write of the command in flight
+    int _timeouts;
+};
+
+#endif // COMMANDSCHEDULER_H
@@ -0,0 +1,447 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: JsFrameDecoder.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "JsFrameDecoder.h"
+
+#include <string.h>
+
+/**
+* @brief hexDigit()
+*        return the value of the hex character or -1 if it is not a hex character
+* */
+static inline int hexDigit(char c)
+{
+    if((c >= '0') && (c <= '9')) return c - '0';
+    if((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+    if((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+    return -1;
+}
+
+/**
+* @brief parseLength()
+*        parse the 4 chars of the JSON object length following the 'JS', leading spaces are allowed
+*        (same as QByteArray::toInt(&ok, 16) used previously)
+*        return -1 if the length is corrupted
+* */
+static int parseLength(const char *p)
+{
+    int i = 0;
+    int value = 0;
+    int digits = 0;
+
+    while((i < 4) && (p[i] == ' '))
+    {
+        i++;
+    }
+
+    for(; i < 4; i++)
+    {
+        int d = hexDigit(p[i]);
+
+        if(d < 0)
+        {
+            return -1;
+        }
+
+        value = (value << 4) | d;
+        digits++;
+    }
+
+    return (digits > 0) ? value : -1;
+}
+
+/**
+* @brief crc16()
+*        CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF) used by the binary frames
+* */
+uint16_t JsFrameDecoder::crc16(const char *data, int length)
+{
+    uint16_t crc = 0xFFFF;
+
+    for(int i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)((uint8_t)data[i]) << 8;
+
+        for(int b = 0; b < 8; b++)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+bool JsFrameDecoder::twrReport(const char *data, int length, jb_twr_t *twr)
+{
+    if((length < (int)sizeof(jb_twr_t)) || ((uint8_t)data[0] != JB_TYPE_TWR))
+    {
+        return false;
+    }
+
+    //the node and the PC are both little endian
+    memcpy(twr, data, sizeof(jb_twr_t));
+
+    return true;
+}
+
+JsFrameDecoder::JsFrameDecoder(int capacity) :
+    _buf(new char[capacity]),
+    _capacity(capacity),
+    _head(0),
+    _tail(0),
+    _checked(0),
+    _dropped(0),
+    _skipped(0),
+    _crcErrors(0)
+{
+}
+
+JsFrameDecoder::~JsFrameDecoder()
+{
+    delete [] _buf;
+}
+
+void JsFrameDecoder::clear(void)
+{
+    _head = 0;
+    _tail = 0;
+    _checked = 0;
+}
+
+/**
+* @brief compact()
+*        move the pending bytes to the front of the buffer to make room at the tail
+* */
+void JsFrameDecoder::compact(void)
+{
+    int length = _tail - _head;
+
+    if(_head == 0)
+    {
+        return;
+    }
+
+    if(length > 0)
+    {
+        memmove(_buf, _buf + _head, length);
+    }
+
+    _head = 0;
+    _tail = length;
+}
+
+char *JsFrameDecoder::writePtr(int *space)
+{
+    if(_head == _tail) //nothing pending - rewind for free
+    {
+        _head = _tail = 0;
+    }
+    else if((_capacity - _tail) < (_capacity / 4))
+    {
+        compact();
+    }
+
+    if(_tail == _capacity) //full of bytes which never formed a frame, drop the older half
+    {
+        int drop = (_tail - _head) / 2;
+
+        _dropped += drop;
+        _head += drop;
+        _checked = 0;
+        compact();
+    }
+
+    *space = _capacity - _tail;
+
+    return _buf + _tail;
+}
+
+void JsFrameDecoder::commit(int length)
+{
+    if(length > (_capacity - _tail))
+    {
+        length = _capacity - _tail;
+    }
+
+    _tail += length;
+}
+
+int JsFrameDecoder::append(const char *data, int length)
+{
+    int dropped = 0;
+
+    if(length <= 0)
+    {
+        return 0;
+    }
+
+    //only the newest bytes can be kept
+    if(length > _capacity)
+    {
+        dropped += length - _capacity;
+        data += length - _capacity;
+        length = _capacity;
+    }
+
+    if(length > (_capacity - _tail))
+    {
+        compact();
+
+        //still not enough room, drop the oldest pending bytes
+        if(length > (_capacity - _tail))
+        {
+            int drop = length - (_capacity - _tail);
+
+            dropped += drop;
+            _head += drop;
+            _checked = 0;
+            compact();
+        }
+    }
+
+    memcpy(_buf + _tail, data, length);
+    _tail += length;
+
+    _dropped += dropped;
+
+    return dropped;
+}
+
+bool JsFrameDecoder::next(js_frame_t *frame)
+{
+    while((_tail - _head) > 1) //need at least "JS"
+    {
+        const char *start = _buf + _head;
+        const char *p = (const char *)memchr(start, 'J', _tail - _head);
+
+        if(p == NULL) //no header in what we have, the whole lot is garbage
+        {
+            _skipped += _tail - _head;
+            _head = _tail;
+            break;
+        }
+
+        _skipped += (p - start);
+        _head = p - _buf;
+
+        if((_tail - _head) < 2)
+        {
+            break; //'J' was the last byte, wait for the rest
+        }
+
+        if(_buf[_head + 1] == 'B')
+        {
+            int result = nextBin(frame);
+
+            if(result > 0)
+            {
+                return true;
+            }
+            if(result == 0)
+            {
+                break; //wait for the rest of the frame
+            }
+            continue;
+        }
+
+        if(_buf[_head + 1] != 'S')
+        {
+            _head += 1;
+            _skipped += 1;
+            continue;
+        }
+
+        if((_tail - _head) < JS_HEADER_LEN)
+        {
+            break; //wait for the length
+        }
+
+        //123456789....  : length
+        //      12345... : jlength : JSON object length, including curly brackets
+        //JS  xx{"TWR": {"a16":"2E5C","R":3,"T":8605,"D":343,"P":1695,"Xcm":165,"Ycm":165,"O":14,"V":1,"X":53015,"Y":60972,"Z":10797}}
+        int jlength = parseLength(_buf + _head + 2);
+
+        if((jlength <= 0) || (jlength > (_capacity - JS_HEADER_LEN)) ||
+           (((_tail - _head) > JS_HEADER_LEN) && (_buf[_head + JS_HEADER_LEN] != '{')))
+        {
+            //corrupted header, skip the "JS" and search again
+            _head += 2;
+            _skipped += 2;
+            _checked = 0;
+            continue;
+        }
+
+        if((_tail - _head) < (jlength + JS_HEADER_LEN))
+        {
+            //a corrupted length (e.g. 'JSFFFF{') would hold up all the frames behind it,
+            //give up on this header as soon as the next frame shows up where its object should be
+            if(headerFollows())
+            {
+                _head += 2;
+                _skipped += 2;
+                _checked = 0;
+                continue;
+            }
+
+            break; //wait for the rest of the object
+        }
+
+        frame->data = _buf + _head + JS_HEADER_LEN;
+        frame->length = jlength;
+        frame->type = JS_FRAME_JSON;
+
+        _head += jlength + JS_HEADER_LEN;
+        _checked = 0;
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+* @brief binLength()
+*        length of the binary frame starting at \a pos ('JB' already matched) if it is complete and passes the CRC
+*        check, 0 if more data is needed, -1 if the payload length is not valid, -2 if the CRC check fails
+* */
+int JsFrameDecoder::binLength(int pos) const
+{
+    int plength;
+    uint16_t crc;
+
+    if((_tail - pos) < JB_HEADER_LEN)
+    {
+        return 0;
+    }
+
+    plength = (uint8_t)_buf[pos + 2];
+
+    if((plength == 0) || (plength > JB_MAX_PAYLOAD_LEN))
+    {
+        return -1;
+    }
+
+    if((_tail - pos) < (JB_HEADER_LEN + plength + JB_CRC_LEN))
+    {
+        return 0;
+    }
+
+    crc = (uint8_t)_buf[pos + JB_HEADER_LEN + plength] |
+          ((uint8_t)_buf[pos + JB_HEADER_LEN + plength + 1] << 8);
+
+    if(crc != crc16(_buf + pos + 2, plength + 1))
+    {
+        return -2;
+    }
+
+    return JB_HEADER_LEN + plength + JB_CRC_LEN;
+}
+
+/**
+* @brief headerFollows()
+*        search the (incomplete) object of the JSON frame at _head for the header of another frame:
+*        a 'JSxxxx{' with a valid length or a complete 'JB' frame with a good CRC, neither of which is ever part
+*        of the node's JSON. Only the bytes received since the last call are searched (see _checked).
+* */
+bool JsFrameDecoder::headerFollows(void)
+{
+    int pos = _head + ((_checked > JS_HEADER_LEN) ? _checked : (JS_HEADER_LEN + 1));
+
+    while(pos < _tail)
+    {
+        const char *p = (const char *)memchr(_buf + pos, 'J', _tail - pos);
+
+        if(p == NULL)
+        {
+            break;
+        }
+
+        pos = p - _buf;
+
+        if((_tail - pos) < 2)
+        {
+            _checked = pos - _head; //check this 'J' again when the next byte is in
+            return false;
+        }
+
+        if(_buf[pos + 1] == 'S')
+        {
+            if((_tail - pos) <= JS_HEADER_LEN)
+            {
+                _checked = pos - _head;
+                return false;
+            }
+
+            if((parseLength(_buf + pos + 2) > 0) && (_buf[pos + JS_HEADER_LEN] == '{'))
+            {
+                return true;
+            }
+        }
+        else if(_buf[pos + 1] == 'B')
+        {
+            int length = binLength(pos);
+
+            if(length == 0)
+            {
+                _checked = pos - _head;
+                return false;
+            }
+
+            if(length > 0)
+            {
+                return true;
+            }
+        }
+
+        pos++;
+    }
+
+    _checked = _tail - _head;
+
+    return false;
+}
+
+/**
+* @brief nextBin()
+*        decode the binary frame at _head ('JB' already matched)
+*        return 1 if \a frame has been filled in, 0 if more data is needed,
+*        -1 if the header was not a valid frame (it has been skipped)
+* */
+int JsFrameDecoder::nextBin(js_frame_t *frame)
+{
+    int length = binLength(_head);
+
+    if(length == 0)
+    {
+        return 0;
+    }
+
+    if(length < 0)
+    {
+        if(length == -2)
+        {
+            _crcErrors++;
+        }
+
+        _head += 2;
+        _skipped += 2;
+        return -1;
+    }
+
+    frame->data = _buf + _head + JB_HEADER_LEN;
+    frame->length = length - JB_HEADER_LEN - JB_CRC_LEN;
+    frame->type = JS_FRAME_BIN;
+
+    _head += length;
+
+    return 1;
+}
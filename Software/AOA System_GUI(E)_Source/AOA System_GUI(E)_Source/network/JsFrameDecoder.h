@@ -0,0 +1,150 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: JsFrameDecoder.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef JSFRAMEDECODER_H
+#define JSFRAMEDECODER_H
+
+#include <stdint.h>
+
+#define JS_HEADER_LEN       (6)     //JS + 4 chars of length e.g. 'JSxxxx{.....}'
+#define JS_MAX_FRAME_LEN    (0xFFFF)//largest length which fits in the 4 hex chars of the header
+#define JS_DECODER_SIZE     (JS_MAX_FRAME_LEN + JS_HEADER_LEN)
+
+#define JB_HEADER_LEN       (3)     //JB + 1 byte of payload length e.g. 'JBn<payload><crc16>'
+#define JB_CRC_LEN          (2)     //CRC-16/CCITT (0x1021, init 0xFFFF) of the length byte and the payload, little endian
+#define JB_MAX_PAYLOAD_LEN  (64)    //keeps a false 'JB' in the text from holding up the JSON frames for long
+
+#define JB_TYPE_TWR         (0x01)  //first byte of the payload: jb_twr_t
+
+#define JS_FRAME_JSON       (0)     //'JSxxxx{...}'
+#define JS_FRAME_BIN        (1)     //'JBn...'
+
+/**
+* @brief jb_twr_t
+*        payload of the compact binary range report, the binary form of the "TWR" JSON object
+*        (same fields and units as the firmware prints in the JSON), all fields little endian.
+*        The node only sends it after it has been switched to the binary report mode during the handshake.
+*/
+#pragma pack(push, 1)
+typedef struct
+{
+    uint8_t     type;           //JB_TYPE_TWR
+    uint16_t    addr16;         //"a16"
+    uint16_t    rangeNum;       //"R"   range number
+    uint32_t    resTime_us;     //"T"   reception time of Final w.r.t. the SuperFrame start, us
+    int32_t     dist_cm;        //"D"   distance, cm
+    int16_t     pdoa_deg;       //"P"   pdoa, degrees
+    int32_t     xdist_cm;       //"Xcm" X distance w.r.t. node, cm
+    int32_t     ydist_cm;       //"Ycm" Y distance w.r.t. node, cm
+    int16_t     clockOffset;    //"O"   clock offset, 1/100 ppm
+    uint16_t    vData;          //"V"   service message data from the tag (stationary, etc)
+    int32_t     accX;           //"X"
+    int32_t     accY;           //"Y"
+    int32_t     accZ;           //"Z"
+} jb_twr_t;
+#pragma pack(pop)
+
+/**
+* @brief js_frame_t
+*        a frame found by the JsFrameDecoder: the JSON object (including curly brackets) without the 'JSxxxx' header,
+*        or the CRC checked payload of a binary frame without the 'JBn' header and the CRC.
+*        The data points into the decoder's buffer and is only valid until the next append()/commit()/clear().
+*/
+typedef struct
+{
+    const char *data;
+    int         length;
+    int         type;   //JS_FRAME_JSON or JS_FRAME_BIN
+} js_frame_t;
+
+/**
+* @brief JsFrameDecoder
+*        Decodes the 'JSxxxx{...}' frames, and the compact binary 'JBn...' frames, sent by the node over a
+*        fixed-capacity byte buffer.
+*        Incoming bytes are appended at the tail; frames are located with memchr() and handed out as
+*        spans into the buffer, so no per-header or per-frame allocation is done.
+*        Consumed bytes are only compacted to the front of the buffer when the tail runs out of space,
+*        so frames are always contiguous.
+*
+* @code
+* _decoder.append(data, length);
+* while(_decoder.next(&frame))
+*     check_json_stream(QByteArray::fromRawData(frame.data, frame.length), client);
+* @endcode
+*/
+class JsFrameDecoder
+{
+public:
+    explicit JsFrameDecoder(int capacity = JS_DECODER_SIZE);
+    ~JsFrameDecoder();
+
+    /**
+     * Append \a length bytes to the buffer. If there is not enough room the oldest pending bytes are dropped.
+     * @return number of bytes dropped to make room
+     */
+    int append(const char *data, int length);
+
+    /**
+     * Direct access to the free space at the tail of the buffer (e.g. to read the serial port straight into it).
+     * The bytes written there are made visible to next() with commit().
+     * Call next() until it returns false after each commit(): a full buffer drops the older half of the
+     * pending bytes, complete frames included.
+     * @param space set to the number of bytes which can be written
+     */
+    char *writePtr(int *space);
+    void commit(int length);
+
+    /**
+     * Find the next complete frame in the buffer.
+     * Any bytes in front of the 'JS'/'JB' header, headers with a corrupted length and binary frames
+     * failing the CRC check are skipped.
+     * @return true if \a frame has been filled in, false if more data is needed
+     */
+    bool next(js_frame_t *frame);
+
+    void clear(void);
+
+    int pending(void) const { return _tail - _head; }
+    int capacity(void) const { return _capacity; }
+    uint32_t droppedBytes(void) const { return _dropped; }
+    uint32_t skippedBytes(void) const { return _skipped; }
+    uint32_t crcErrors(void) const { return _crcErrors; }
+
+    static uint16_t crc16(const char *data, int length);
+
+    /**
+     * Copy a binary range report out of the payload of a JS_FRAME_BIN frame.
+     * @return false if it is not a (complete) JB_TYPE_TWR payload
+     */
+    static bool twrReport(const char *data, int length, jb_twr_t *twr);
+
+private:
+    JsFrameDecoder(const JsFrameDecoder &);
+    JsFrameDecoder &operator=(const JsFrameDecoder &);
+
+    void compact(void);
+    int  nextBin(js_frame_t *frame);
+    int  binLength(int pos) const;
+    bool headerFollows(void);
+
+    char    *_buf;
+    int      _capacity;
+    int      _head;     //first byte not yet consumed
+    int      _tail;     //one past the last byte received
+    int      _checked;  //bytes of the JSON frame at _head already searched by headerFollows()
+
+    uint32_t _dropped;  //bytes lost because the buffer was full
+    uint32_t _skipped;  //bytes discarded while searching for a header
+    uint32_t _crcErrors;//binary frames discarded because of a bad CRC
+};
+
+#endif // JSFRAMEDECODER_H
@@ -0,0 +1,207 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: PositionFilter.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "PositionFilter.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+PositionFilter *PositionFilter::create(int type, int window)
+{
+    switch(type)
+    {
+    case FilterMedian:
+        return new MedianPositionFilter(window);
+    case FilterAlphaBeta:
+        return new AlphaBetaPositionFilter();
+    case FilterKalman:
+        return new KalmanPositionFilter();
+    default:
+        return NULL;
+    }
+}
+
+const char *PositionFilter::typeName(int type)
+{
+    switch(type)
+    {
+    case FilterMedian:
+        return "median";
+    case FilterAlphaBeta:
+        return "alpha-beta";
+    case FilterKalman:
+        return "Kalman";
+    default:
+        return "none";
+    }
+}
+
+MedianPositionFilter::MedianPositionFilter(int window) :
+    _x(window),
+    _y(window)
+{
+}
+
+void MedianPositionFilter::reset(void)
+{
+    _x.clear();
+    _y.clear();
+}
+
+void MedianPositionFilter::filter(double *x, double *y, double t, bool stationary)
+{
+    Q_UNUSED(t);
+    Q_UNUSED(stationary);
+
+    _x.add(*x);
+    _y.add(*y);
+
+    if(_x.ready())
+    {
+        *x = _x.median();
+        *y = _y.median();
+    }
+}
+
+PolarPositionFilter::PolarPositionFilter()
+{
+    reset();
+}
+
+void PolarPositionFilter::reset(void)
+{
+    _started = false;
+    _t = 0;
+}
+
+/**
+* @brief innovation()
+*        difference between the measurement and the prediction, for the angle it is wrapped to [-pi, pi]
+* */
+double PolarPositionFilter::innovation(double z, double p, bool angle)
+{
+    double d = z - p;
+
+    if(angle)
+    {
+        while(d > M_PI) d -= 2 * M_PI;
+        while(d < -M_PI) d += 2 * M_PI;
+    }
+
+    return d;
+}
+
+void PolarPositionFilter::filter(double *x, double *y, double t, bool stationary)
+{
+    double range = sqrt((*x) * (*x) + (*y) * (*y));
+    double angle = atan2(*x, *y);
+    double dt = t - _t;
+
+    if(!_started || (dt <= 0) || (dt > FILTER_MAX_GAP))
+    {
+        start(&_range, range, false);
+        start(&_angle, angle, true);
+        _started = true;
+    }
+    else
+    {
+        update(&_range, range, dt, stationary, false);
+        update(&_angle, angle, dt, stationary, true);
+    }
+
+    _t = t;
+
+    *x = _range.p * sin(_angle.p);
+    *y = _range.p * cos(_angle.p);
+}
+
+void AlphaBetaPositionFilter::start(polar_state_t *s, double z, bool angle)
+{
+    Q_UNUSED(angle);
+
+    s->p = z;
+    s->v = 0;
+}
+
+void AlphaBetaPositionFilter::update(polar_state_t *s, double z, double dt, bool stationary, bool angle)
+{
+    double r;
+
+    if(stationary) //hold the position and average the measurements
+    {
+        s->v = 0;
+        s->p += AB_ALPHA_STATIONARY * innovation(z, s->p, angle);
+        return;
+    }
+
+    s->p += s->v * dt;
+
+    r = innovation(z, s->p, angle);
+
+    s->p += AB_ALPHA * r;
+    s->v += (AB_BETA / dt) * r;
+}
+
+void KalmanPositionFilter::start(polar_state_t *s, double z, bool angle)
+{
+    double noise = angle ? KF_ANGLE_NOISE : KF_RANGE_NOISE;
+    double acc = angle ? KF_ANGLE_ACC : KF_RANGE_ACC;
+
+    s->p = z;
+    s->v = 0;
+    s->P00 = noise * noise;
+    s->P01 = 0;
+    s->P11 = acc * acc; //unknown velocity, about what 1 s of acceleration gives
+}
+
+void KalmanPositionFilter::update(polar_state_t *s, double z, double dt, bool stationary, bool angle)
+{
+    double noise = angle ? KF_ANGLE_NOISE : KF_RANGE_NOISE;
+    double acc = angle ? KF_ANGLE_ACC : KF_RANGE_ACC;
+    double q = acc * acc;
+    double R = noise * noise;
+    double S, K0, K1, r;
+
+    if(stationary) //the IMU says the tag is not moving: no velocity and no process noise, the filter averages
+    {
+        s->v = 0;
+        s->P01 = 0;
+        s->P11 = 0;
+        q = 0;
+    }
+    else if(s->P11 == 0) //moving again, the velocity is unknown
+    {
+        s->P11 = q;
+    }
+
+    //predict
+    s->p += s->v * dt;
+    s->P00 += dt * (2 * s->P01 + dt * s->P11) + q * dt * dt * dt * dt / 4;
+    s->P01 += dt * s->P11 + q * dt * dt * dt / 2;
+    s->P11 += q * dt * dt;
+
+    //update
+    S = s->P00 + R;
+    K0 = s->P00 / S;
+    K1 = s->P01 / S;
+    r = innovation(z, s->p, angle);
+
+    s->p += K0 * r;
+    s->v += K1 * r;
+
+    s->P11 -= K1 * s->P01;
+    s->P01 *= (1 - K0);
+    s->P00 *= (1 - K0);
+}
@@ -0,0 +1,154 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: PositionFilter.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef POSITIONFILTER_H
+#define POSITIONFILTER_H
+
+#include "SlidingMedian.h"
+
+//alpha-beta filter gains (beta = alpha^2 / (2 - alpha), critically damped)
+#define AB_ALPHA            (0.5)
+#define AB_BETA             (0.1667)
+#define AB_ALPHA_STATIONARY (0.1)       //the tag is not moving, average the position harder
+
+//constant velocity Kalman filter, measurement and process (white acceleration) noise
+#define KF_RANGE_NOISE      (0.10)      //m, std. dev. of the reported range
+#define KF_RANGE_ACC        (1.0)       //m/s^2, std. dev. of the acceleration (e.g. a forklift)
+#define KF_ANGLE_NOISE      (0.087)     //rad (5 deg), std. dev. of the reported angle
+#define KF_ANGLE_ACC        (0.5)       //rad/s^2, std. dev. of the angular acceleration
+
+#define FILTER_MAX_GAP      (2.0)       //s, a longer gap between two reports restarts the filter
+
+enum PositionFilterType
+{
+    FilterNone = 0,     //the reported position is used as is
+    FilterMedian,       //median of the last N positions (the original motion filter)
+    FilterAlphaBeta,    //alpha-beta filter on (range, angle)
+    FilterKalman,       //constant velocity Kalman filter on (range, angle)
+    FilterTypes
+};
+
+/**
+* @brief filter_stats_t
+*        measured cost and effect of a filter type, over all the tags using it
+*/
+typedef struct
+{
+    quint64 count;          //filtered reports
+    double  timeSum_us;     //processing time
+    double  timeMax_us;
+    quint64 steps;          //consecutive report pairs of the same tag
+    double  inStepSq;       //sum of the squared steps between consecutive reported positions, m^2
+    double  outStepSq;      //sum of the squared steps between consecutive filtered positions, m^2
+} filter_stats_t;
+
+/**
+ * The PositionFilter class is the interface of a stage smoothing the position of one tag.
+ *
+ * filter() is given each new position (x, y in m, as plotted: y-axis increases downwards), the time of the
+ * report in seconds and the tag's IMU stationary flag (bit 0 of the report's mode), and replaces the position
+ * with the filtered one.
+ * The alpha-beta and Kalman filters work on the range and angle seen from the node, which is how the
+ * measurement noise is shaped (the angle from the PDOA is much noisier than the range).
+ */
+class PositionFilter
+{
+public:
+    virtual ~PositionFilter() {}
+
+    virtual int type(void) const = 0;
+    virtual void reset(void) = 0;
+    virtual void filter(double *x, double *y, double t, bool stationary) = 0;
+
+    /**
+     * @return a new filter of the given type, NULL for FilterNone
+     *         (window is the number of positions of the median filter)
+     */
+    static PositionFilter *create(int type, int window);
+
+    static const char *typeName(int type);
+};
+
+/**
+ * The MedianPositionFilter class takes the median of the last N positions, separately in x and y.
+ */
+class MedianPositionFilter : public PositionFilter
+{
+public:
+    explicit MedianPositionFilter(int window);
+
+    int type(void) const { return FilterMedian; }
+    void reset(void);
+    void filter(double *x, double *y, double t, bool stationary);
+
+private:
+    SlidingMedian _x;
+    SlidingMedian _y;
+};
+
+/**
+ * @brief polar_state_t
+ *        position and velocity of one coordinate (range or angle) and, for the Kalman filter, its covariance
+ */
+typedef struct
+{
+    double p;               //position
+    double v;               //velocity
+    double P00, P01, P11;   //covariance
+} polar_state_t;
+
+/**
+ * The PolarPositionFilter class converts the position to (range, angle) and back around the filtering
+ * of each coordinate, it handles the restarts (first report, long gaps) for the filters below.
+ */
+class PolarPositionFilter : public PositionFilter
+{
+public:
+    PolarPositionFilter();
+
+    void reset(void);
+    void filter(double *x, double *y, double t, bool stationary);
+
+protected:
+    virtual void start(polar_state_t *s, double z, bool angle) = 0;
+    virtual void update(polar_state_t *s, double z, double dt, bool stationary, bool angle) = 0;
+
+    static double innovation(double z, double p, bool angle);
+
+private:
+    polar_state_t _range;
+    polar_state_t _angle;
+    double _t;
+    bool _started;
+};
+
+class AlphaBetaPositionFilter : public PolarPositionFilter
+{
+public:
+    int type(void) const { return FilterAlphaBeta; }
+
+protected:
+    void start(polar_state_t *s, double z, bool angle);
+    void update(polar_state_t *s, double z, double dt, bool stationary, bool angle);
+};
+
+class KalmanPositionFilter : public PolarPositionFilter
+{
+public:
+    int type(void) const { return FilterKalman; }
+
+protected:
+    void start(polar_state_t *s, double z, bool angle);
+    void update(polar_state_t *s, double z, double dt, bool stationary, bool angle);
+};
+
+#endif // POSITIONFILTER_H
@@ -27,22 +27,16 @@
 
 #include "RTLSClient.h"
 
-#include "RTLSDisplayApplication.h"
 #include "SerialConnection.h"
-#include "mainwindow.h"
 
-#include <QTextStream>
 #include <QDateTime>
-#include <QThread>
-#include <QFile>
 #include <QDebug>
 #include <math.h>
-#include <QMessageBox>
+#include <string.h>
 
-#include <QDomDocument>
-#include <QFile>
 #include "json_utils.h"
-#include "windows.h"
+#include "SessionFile.h"
+#include "LogCategories.h"
 
 //e.g. RAtagID(16bit) seq (8bit) range(32bit signed mm) PDOA (32bit signed mrad) mode (8bit)
 //"RA%04x %02x %04x %04x %02x"
@@ -52,20 +46,19 @@
 
 #define ANT_FACTOR (1.8)  // ANT_FACTOR depends on antenna characteristics
 
-
-static bool is_startLog = false;
-static FILE* file_T;
-
 /**
-* @brief RTLSDisplayApplication
-*        Constructor; The application consumes the data received over the COM port connection and sends the
-*        processed data to the graphical display
+* @brief RTLSClient
+*        Constructor; The client consumes the data received over the COM port connection (the frames decoded by
+*        the given serial connection) and sends the processed data to the graphical display
+*        It only depends on QtCore, so it can run without the GUI (see core.pri)
 * */
-RTLSClient::RTLSClient(QObject *parent) :
+RTLSClient::RTLSClient(SerialConnection *connection, QObject *parent) :
     QObject(parent),
-    _first(true)
+    _first(true),
+    _connection(connection)
 {
-    _motionFilterOn = false;
+    _clock.start();
+    resetFilterStats();
 
     _serial = NULL;
 
@@ -83,31 +76,45 @@ RTLSClient::RTLSClient(QObject *parent) :
         rangeHisCalib[i] = 0;
     }
 
-    RTLSDisplayApplication::connectReady(this, "onReady()");
+    //set up the connection to the serial connection's serialOpened signal and the frames
+    QObject::connect(_connection, SIGNAL(serialOpened(QString)),
+                         this, SLOT(onConnected(QString)));
 
+    //the frames refer to the serial connection's decoder buffer, so they must be consumed straight away
+    QObject::connect(_connection, SIGNAL(reportFrame(QByteArray)),
+                         this, SLOT(reportFrame(QByteArray)), Qt::DirectConnection);
+    QObject::connect(_connection, SIGNAL(binReportFrame(QByteArray)),
+                         this, SLOT(binReportFrame(QByteArray)), Qt::DirectConnection);
+    QObject::connect(_connection, SIGNAL(listFrame(QByteArray)),
+                         this, SLOT(listFrame(QByteArray)), Qt::DirectConnection);
+    QObject::connect(_connection, SIGNAL(connectionStateChanged(SerialConnection::ConnectionState)),
+                         this, SLOT(connectionStateChanged(SerialConnection::ConnectionState)));
+
+    //round trip of the commands sent to the node
+    QObject::connect(_connection->commands(), SIGNAL(commandReplied(QByteArray,qint64)),
+                         this, SLOT(commandReplied(QByteArray,qint64)));
+    QObject::connect(_connection->commands(), SIGNAL(commandFailed(QByteArray,int)),
+                         this, SLOT(commandFailed(QByteArray,int)));
 }
 
 /**
-* @brief onReady()
-*        When onReady signal is received by the RTLS Client the client sets up a connection to serialConnection
-*        serialOpened signal.
+* @brief setAppVersion()
+*        the application's version, to write into the log file
 * */
-void RTLSClient::onReady()
+void RTLSClient::setAppVersion(const QString &version)
 {
-    QObject::connect(RTLSDisplayApplication::serialConnection(), SIGNAL(serialOpened(QString)),
-                         this, SLOT(onConnected(QString)));
-
+    _verGUI = version;
 }
 
 /**
 * @brief onConnected()
 *        When onConnected signal is received by the RTLS Client the client gets ready to consume the data from the
-*        opened COM port (connectes to readyRead() signal). It also opens a new log file and updates the status bar message
+*        opened COM port (the frames are delivered by the serial connection). It also updates the status bar message
 *        on the main window.
 * */
 void RTLSClient::onConnected(QString conf)
 {
-    qDebug() << "RTLSClient.cpp onConnected";
+    qCDebug(lcSerial) << "RTLSClient.cpp onConnected";
 
     bool ok = true;
 
@@ -116,21 +123,15 @@ void RTLSClient::onConnected(QString conf)
 
     //save Node's version
     _verNode = conf ;
-    //get application version to write into the log file
-    _verGUI = RTLSDisplayApplication::mainWindow()->version();
 
-    //get pointer to Serial Connection object and set up a connection to serial ports readyRead() signal
-    _serial = RTLSDisplayApplication::serialConnection();
-    connect(_serial->serialPort(), SIGNAL(readyRead()), this, SLOT(newData()));
+    //get pointer to Serial Connection object
+    _serial = _connection;
 
-    // send STOP command and then get a list of known tag's from the node
+    //get a list of known tag's from the node, the periodic requests below are queued after its reply
     _serial->clear();
-    Sleep(100);
 
-    _serial->writeData("getKList\r\n");
-    Sleep(1000);
+    _serial->queueCommand("getKList\r\n", "KList", KLIST_TIMEOUT_MS, KLIST_RETRIES);
 
-    //start the Node application (as it was stopped above)
     //start periodic timer, to periodically request a new tag's list
     _serial->timerUpdateStart(2000);
 
@@ -154,34 +155,21 @@ void RTLSClient::onConnected(QString conf)
 * */
 void RTLSClient::updateTagAddr16(quint64 id64, int id16)
 {
-    int idx = -1;
+    int idx = _tagList.indexOf64(id64);
 
-    //find the tag in the _tagList
-    for(idx=0; idx<_tagList.size(); idx++)
+    //if this is the tag update the 16-bit address (another tag with same 16 bit address loses it)
+    if(idx != -1)
     {
-        //if this is the tag update the 16-bit address
-        if(_tagList.at(idx).id64 == id64)
-        {
-            tag_reports_t rp = _tagList.at(idx);
-
-            rp.id16 = id16 ;
-
-            //update the list entry
-            _tagList.replace(idx, rp);
-
-            continue; //break;
-        }
+        _tagList.setId16(idx, id16);
+    }
+    else
+    {
+        idx = _tagList.indexOf16(id16);
 
-        if(_tagList.at(idx).id16 == id16) //another tag with same 16 bit address
+        if(idx != -1) //another tag with same 16 bit address
         {
-            tag_reports_t rp = _tagList.at(idx);
-
-            rp.id16 = -1 ;
-
-            //update the list entry
-            _tagList.replace(idx, rp);
+            _tagList.setId16(idx, -1);
         }
-
     }
 }
 
@@ -191,24 +179,8 @@ void RTLSClient::updateTagAddr16(quint64 id64, int id16)
 * */
 void RTLSClient::removeTagFromList(quint64 id64)
 {
-    //first check if we have this tag already
-    int idx;
-    //find the tag in the list
-    for(idx=0; idx<_tagList.size(); idx++)
-    {
-        //find this tag in the list
-        if(_tagList.at(idx).id64 == id64)
-        {
-            break;
-        }
-    }
-
     //remove the tag from the list
-    if(idx < _tagList.size())
-    {
-        _tagList.removeAt(idx);
-    }
-
+    _tagList.remove(id64);
 }
 
 /**
@@ -218,39 +190,22 @@ void RTLSClient::removeTagFromList(quint64 id64)
 * */
 void RTLSClient::addTagToList(quint64 id64)
 {
-    tag_reports_t r;
+    int idx;
 
     //first check if we have this tag already
-    int idx;
-    //find the tag in the list
-    for(idx=0; idx<_tagList.size(); idx++)
+    if(_tagList.indexOf64(id64) != -1)
     {
-        //find this tag in the list
-        if(_tagList.at(idx).id64 == id64)
-        {
-            return;
-        }
+        return;
     }
 
-    //add new tag to our list
-    memset(&r, 0, sizeof(tag_reports_t));
-    r.id16 = - 1 ; //don't assign the 16 bit address here ... node will do it when tag joins
-    r.id64 = id64;
+    //add new tag to our list (history and filter state cleared)
+    idx = _tagList.insert(id64, -1); //don't assign the 16 bit address here ... node will do it when tag joins
+
+    tag_info_t &r = _tagList.info(idx);
     r.Mode = 0;
     r.multFast = 1;
     r.multSlow = 1;
     r.ready = false;
-    r.filterReady = 0;
-
-    r.filterHisIdx = 0;
-    r.motionFilterReady = false;
-    for (int i = 0; i<FILTER_SIZE; i++)
-    {
-       r.estXHis[i] = 0;
-       r.estYHis[i] = 0;
-    }
-
-    _tagList.append(r);
 
     //Add newly discovered tag to the list (64-bit ID, 16-bit ID, false as it is new)
     emit addDiscoveredTag(r.id64, r.id16, false, -1, 0);
@@ -264,27 +219,14 @@ void RTLSClient::addTagToList(quint64 id64)
 void RTLSClient::addTagFromKList(short slot, quint64 id64, short id16,
                                  short mFast, short mSlow, short mode)
 {
-    tag_reports_t r;
-    memset(&r, 0, sizeof(tag_reports_t));
-    r.id16 = id16;
-    r.id64 = id64;
+    //resets the entry if the tag has been discovered already (history and filter state cleared)
+    int idx = _tagList.insert(id64, id16);
+
+    tag_info_t &r = _tagList.info(idx);
     r.Mode = mode;
     r.multFast = mFast;
     r.multSlow = mSlow;
     r.ready = true;
-    r.filterReady = 0;
-    //r.rangeSeq = -1;
-    //memset(&r.rangeValue[0][0], -1, sizeof(r.rangeValue));
-
-    r.filterHisIdx = 0;
-    r.motionFilterReady = false;
-    for (int i = 0; i<FILTER_SIZE; i++)
-    {
-       r.estXHis[i] = 0;
-       r.estYHis[i] = 0;
-    }
-
-    _tagList.append(r);
 
     //Add a known tag to the list (64-bit ID, 16-bit ID, true as it is already known)
     emit addDiscoveredTag(r.id64, r.id16, true, mFast, (mode & 0x1));
@@ -301,7 +243,7 @@ void RTLSClient::updatePDOAandRangeOffset(int pdoa_offset_mrad, int range_offset
     _nodeConfig[0].phaseCorection = (double)pdoa_offset_mrad/1000 ;
     _nodeConfig[0].rangeCorection = (double)range_offset_mm/1000 ;
 
-	qDebug() << "------------------------updatePDOAandRangeOffset" << _nodeConfig[0].phaseCorection << _nodeConfig[0].rangeCorection;
+	qCDebug(lcParse) << "------------------------updatePDOAandRangeOffset" << _nodeConfig[0].phaseCorection << _nodeConfig[0].rangeCorection;
 
     emit phaseOffsetUpdated(_nodeConfig[0].phaseCorection);
     emit rangeOffsetUpdated(_nodeConfig[0].rangeCorection);
@@ -341,9 +283,8 @@ double stddev(double *array, int length)
 * */
 void RTLSClient::updateTagStatistics(int i, double x, double y)
 {
-    int idx = _tagList.at(i).arr_idx;
-
-    tag_reports_t rp = _tagList.at(i);
+    tag_history_t &rp = _tagList.history(i);
+    int idx = rp.arr_idx;
 
     //update the value in the array
     rp.x_arr[idx] = x;
@@ -354,8 +295,8 @@ void RTLSClient::updateTagStatistics(int i, double x, double y)
     if(rp.arr_idx >= HIS_LENGTH)
     {
         rp.arr_idx = 0;
-        rp.ready = true;
         rp.filterReady = 1;
+        _tagList.info(i).ready = true;
     }
 
     rp.count++;
@@ -369,18 +310,52 @@ void RTLSClient::updateTagStatistics(int i, double x, double y)
         }
 
     }
-
-    //update the list entry
-    _tagList.replace(i, rp);
 }
 
 /**
 * @brief enableMotionFilter()
-*        Set _motionFilterOn flag to the given value
+*        Turn the (median) motion filter on or off for all the tags
 * */
 void RTLSClient::enableMotionFilter(bool enabled)
 {
-    _motionFilterOn = enabled;
+    setDefaultFilter(enabled ? FilterMedian : FilterNone);
+}
+
+/**
+* @brief setDefaultFilter()
+*        Select the position filter (PositionFilterType) of all the tags, and of the tags added later
+* */
+void RTLSClient::setDefaultFilter(int type)
+{
+    _tagList.setFilterType(type);
+}
+
+/**
+* @brief setTagFilter()
+*        Select the position filter (PositionFilterType) of one tag
+* */
+void RTLSClient::setTagFilter(quint64 id64, int type)
+{
+    int idx = _tagList.indexOf64(id64);
+
+    if(idx != -1)
+    {
+        _tagList.setFilterType(idx, type);
+    }
+}
+
+filter_stats_t RTLSClient::filterStats(int type) const
+{
+    QMutexLocker locker(&_filterStatsLock);
+
+    return _filterStats[type];
+}
+
+void RTLSClient::resetFilterStats(void)
+{
+    QMutexLocker locker(&_filterStatsLock);
+
+    memset(_filterStats, 0, sizeof(_filterStats));
 }
 
 /**
@@ -440,17 +415,13 @@ void RTLSClient::sendPhaseAndRangeCorrectionToNode(double phase, double range)
     //久凌电子 计算出角度 = 弧度*180/π
     uint16_t    tmp = (uint16_t)(180*phase/M_PI);
     QString s_pdof = QString("pdoaoff %1\r\n").arg(tmp, 4, 10, QChar('0'));
-    _serial->writeData(s_pdof.toLocal8Bit());
-
-    Sleep(50);
+    _serial->queueCommand(s_pdof.toLocal8Bit(), QByteArray(), CMD_PAUSE_MS);
 
     tmp = (uint16_t)(range*1000);
     s_pdof = QString("rngoff %1\r\n").arg(tmp, 4, 10, QChar('0'));
-    _serial->writeData(s_pdof.toLocal8Bit());
-
-    Sleep(50);
+    _serial->queueCommand(s_pdof.toLocal8Bit(), QByteArray(), CMD_PAUSE_MS);
 
-    _serial->writeData("save\r\n");
+    _serial->queueCommand("save\r\n", QByteArray(), CMD_PAUSE_MS);
 }
 
 /**
@@ -468,23 +439,15 @@ void RTLSClient::processRangeAndPDOAReport(int tid,
                                             int vec_y,
                                             int vec_z)
 {
-    int n, idx;
-    int tag_index = -1;
+    int tag_index;
     int angle;
+    qint64 parsed = LatencyMonitor::now();
+    qint64 filtered;
 
     double pdoa_rad = (pdoa_deg / 180.0) * M_PI ;   //弧度 = 角度/180.0 * π
 
-    //1st need to check if we know about this tag, if we do it will be in the list,
-    //find the tag in the list
-    for(idx=0; idx<_tagList.size(); idx++)
-    {
-        //find this tag in the list
-        if(_tagList.at(idx).id16 == tid)
-        {
-            tag_index = idx;
-            break;
-        }
-    }
+    //1st need to check if we know about this tag, if we do it will be in the list
+    tag_index = _tagList.indexOf16(tid);
 
     if(tag_index == -1)
     {
@@ -493,9 +456,6 @@ void RTLSClient::processRangeAndPDOAReport(int tid,
         return;
     }
 
-    QDateTime now = QDateTime::currentDateTime();
-    QString nowstr = now.toString("T:hhmmsszzz:");
-
     //if invalid ("DEAD") value report to log
     if(((int) x_m) == 0xDEADBEEF ||\
        ((int) y_m) == 0xDEADBEEF ||\
@@ -505,23 +465,21 @@ void RTLSClient::processRangeAndPDOAReport(int tid,
     }
     // have rang/PDOA report  - update position on the GUI
     {
-        tag_reports_t rp1;
         double x, y; //coordinates for plotting on the GUI
         double estCoordPhaseDeg; //this is the filtered phase (if motion filtering is on)
 
         x = x_m; y = -y_m; //for GUI the y-axis increases downwards
 
         // Motion Filter of estimation coordinates and phase correction part of stationary node filter
-        motionFilter(&x, &y, tag_index);
+        motionFilter(&x, &y, tag_index, mode);
 
-        angle = atan(x / y) * 180.0 / M_PI;
+        filtered = LatencyMonitor::now();
 
+        angle = atan(x / y) * 180.0 / M_PI;
 
-        // update position on screen
-        emit tagPos(_tagList.at(tag_index).id64, x, y, mode);
 
         //PDOA calibration
-        if (_phaseCalibration && (_tagList.at(tag_index).id64 == _calibrationTagID)) //check if correct tag
+        if (_phaseCalibration && (_tagList.info(tag_index).id64 == _calibrationTagID)) //check if correct tag
         {
             //when calculating pdoa offset, the raw pdoa should be used (i.e. before any offset is applied),
             //need to make sure the ranges/pdoa reported from node are using offsets of 0
@@ -533,7 +491,7 @@ void RTLSClient::processRangeAndPDOAReport(int tid,
 
                 if (_calibrationDone)
                 {
-                	qDebug() << "校准";
+                	qCDebug(lcFilter) << "校准";
                     _phaseCalibration = false;
                     emit phaseOffsetUpdated(_nodeConfig[0].phaseCorection);
                     emit rangeOffsetUpdated(_nodeConfig[0].rangeCorection);
@@ -545,142 +503,180 @@ void RTLSClient::processRangeAndPDOAReport(int tid,
         }
 
         {
-            double a1, stdev;
+            tag_update_t update;
+
             //update tag position statistics
             updateTagStatistics(tag_index, x, y); //phase changed to degrees before STDEV calc.
 
-            rp1 = _tagList.at(tag_index);
-
-            emit tagRange(rp1.id64, range_m, x, y, angle, mode, vec_x, vec_y, vec_z);
+            // update position and range on screen
+            update.id64 = _tagList.info(tag_index).id64;
+            update.x = x;
+            update.y = y;
+            update.range = range_m;
+            update.angle = angle;
+            update.mode = mode;
+            update.accX = vec_x;
+            update.accY = vec_y;
+            update.accZ = vec_z;
+            update.rxTime = _connection->rxTime();
+            update.filterTime = filtered;
+
+            _latency.record(LatencyDecode, _connection->decodeTime() - update.rxTime);
+            _latency.record(LatencyParse, parsed - _connection->decodeTime());
+            _latency.record(LatencyFilter, filtered - parsed);
+
+            postUpdate(update);
         }
     } //end of PDOA processing
 
 
-	_dbg_printf3("Tag_Addr:%04X, Seq:%d, Xcm:%.2f, Ycm:%.2f, Range:%.2f, Angle:%d\n",
-							tid,
-							seq,
-							x_m,
-							y_m,
-							range_m,
-                            angle);
-
-
+    //only a copy into the log queue here, the log file is formatted and written on the log's own thread
+    if(_log.isOpen())
+    {
+        range_log_t record;
+
+        record.time = QDateTime::currentMSecsSinceEpoch();
+        record.addr16 = tid;
+        record.seq = seq;
+        record.x = x_m;
+        record.y = y_m;
+        record.range = range_m;
+        record.angle = angle;
+        record.mode = mode;
+        record.accX = vec_x;
+        record.accY = vec_y;
+        record.accZ = vec_z;
+
+        _log.append(record);
+    }
 }
-void RTLSClient::GetList()
-{
-    _serial->writeData("GetList\r\n");
 
-}
-void RTLSClient::save()
+/**
+* @brief postUpdate()
+*        Queue a processed report for the GUI (I/O thread side). The GUI is only signalled when the queue
+*        goes from drained to non-empty, so a burst of reports costs one queued signal.
+*        If the GUI falls behind and the queue is full the update is dropped and counted.
+* */
+void RTLSClient::postUpdate(const tag_update_t &update)
 {
-    _serial->writeData("save\r\n");
+    int depth;
+
+    if(!_updates.push(update))
+    {
+        _updatesDropped.fetchAndAddRelaxed(1);
+    }
 
+    depth = _updates.size();
+
+    if(depth > _updatesMaxDepth.loadRelaxed())
+    {
+        _updatesMaxDepth.storeRelaxed(depth);
+    }
+
+    if(_updatesSignalled.testAndSetOrdered(0, 1))
+    {
+        emit updatesReady();
+    }
 }
 
 /**
-* @brief newData()
-*        Function to consume and parse the data received on the serial connection from the Node
+* @brief rearmUpdates()
+*        Called by the GUI before it drains the queue with takeUpdate(), so that any update posted
+*        after this point will emit a new updatesReady()
 * */
-QByteArray report_data;
+void RTLSClient::rearmUpdates(void)
+{
+    _updatesSignalled.storeRelease(0);
+}
 
-void RTLSClient::newData()
+bool RTLSClient::takeUpdate(tag_update_t *update)
 {
-    QByteArray data = _serial->serialPort()->readAll();
-	
-    report_data.append(data);
-    //界面显示上位机数据
-    if(report_data.lastIndexOf("\r\n") != -1)
-	{	
-        QByteArray report_byte = report_data.left(report_data.lastIndexOf("\r\n")+2);
-        report_data = report_data.mid(report_data.lastIndexOf("\r\n")+2);
+    return _updates.pop(update);
+}
 
-        emit Signal_Uart_Recvdata(report_byte);
-	}
-    if(report_data.size() > 9096)
-	    report_data.clear();	
+int RTLSClient::updateQueueDepth(void) const
+{
+    return _updates.size();
+}
 
+int RTLSClient::updateQueueMaxDepth(void) const
+{
+    return _updatesMaxDepth.loadRelaxed();
+}
 
-#if 1
+int RTLSClient::droppedUpdates(void) const
+{
+    return _updatesDropped.loadRelaxed();
+}
 
-    QByteArray dataChunk;
+void RTLSClient::GetList()
+{
+    _serial->queueCommand("GetList\r\n", "KList");
 
-    int offset = 0;
+}
+void RTLSClient::save()
+{
+    _serial->queueCommand("save\r\n", QByteArray(), CMD_PAUSE_MS);
 
-    _data.append(data);
+}
 
-    int length = _data.length();
+/**
+* @brief reportFrame()
+*        Consume a range (TWR) or service (SN) report decoded by the serial connection
+* */
+void RTLSClient::reportFrame(const QByteArray &frame)
+{
+    check_json_stream(frame, this);
+}
 
-	//qDebug() << "_data_len" << length << "data_len" << data.length();
+/**
+* @brief binReportFrame()
+*        Consume a compact binary range report (the binary form of the "TWR" object)
+* */
+void RTLSClient::binReportFrame(const QByteArray &frame)
+{
+    tag_data_t tag;
 
-    while(length > 1) // we have received a range report from the node
+    //same units and addr16 as the JSON report, so the tag matches its KList entry
+    if(!parse_twr_bin(frame, &tag))
     {
-        QByteArray header = _data.mid(offset, 2);
-
-        if(header.contains("JS")) //loop here until we reach header ("JS")
-        {
-//123456789....  : length
-//      12345... : jlength : JSON object length, including curly brackets
-//JS  xx{"TWR": {"a16":"2E5C","R":3,"T":8605,"D":343,"P":1695,"Xcm":165,"Ycm":165,"O":14,"V":1,"X":53015,"Y":60972,"Z":10797}}
-            if(length > 6)
-            {
-                bool ok = false;
-                int jlength =  _data.mid(offset+2, 4).toInt(&ok,16);
-                //qDebug() << "json len "<< jlength;
-                if(jlength == 0)
-                {
-                    qDebug() << _data;
-                    length = 0;     //清除所有字符
-                    break;
-                }
-                if(ok && (length >= jlength+6))
-                {
-                	//qDebug() << "check_json_stream";
-                    dataChunk = _data.mid(offset+6, jlength);
-                    check_json_stream(dataChunk);
-
-                    offset += (jlength+6);
-                    length -= (jlength+6);
-                }
-                else
-                {
-                    break;
-                }
-            }
-            else
-            {
-                break;
-            }
-        }
-        else
-        {
-            offset += 1;
-            length -= 1;
-        }
+        return;
+    }
 
-    } //end of while
-	//qDebug() << "ritgh length" << length;
-    _data = _data.right(length);	
-#endif
+    processRangeAndPDOAReport(tag.addr16,
+                              tag.twr.rangeNum,
+                              tag.twr.dist_m,
+                              tag.twr.xdist_m,
+                              tag.twr.ydist_m,
+                              tag.twr.pdoa_deg,
+                              tag.twr.vData,
+                              tag.twr.accX,
+                              tag.twr.accY,
+                              tag.twr.accZ);
+}
 
+/**
+* @brief listFrame()
+*        Consume any other reply from the Node (KList, DList, NewTag, TagAdded, Calibration...)
+* */
+void RTLSClient::listFrame(const QByteArray &frame)
+{
+    check_json_stream(frame, this);
 }
 
 /**
 * @brief connectionStateChanged()
 *        Consumes the state changed signal from the serial connection, if
-*        serial port is closed/disconnected then close the log file and disconnect the readyRead signal
+*        serial port is closed/disconnected then forget the connection and the tags
 * */
 void RTLSClient::connectionStateChanged(SerialConnection::ConnectionState state)
 {
 	//久凌电子  	0:断开    1:连接，并读取数据，槽newData()
-    qDebug() << "RTLSClient::connectionStateChanged " << state;
+    qCDebug(lcSerial) << "RTLSClient::connectionStateChanged " << state;
 
     if(state == SerialConnection::Disconnected) //disconnect from Serial Port
     {
-        if(_serial != NULL)
-        {
-            disconnect(_serial->serialPort(), SIGNAL(readyRead()), this, SLOT(newData()));
-            _serial = NULL;
-        }
+        _serial = NULL;
 
         _tagList.clear();
 
@@ -689,6 +685,22 @@ void RTLSClient::connectionStateChanged(SerialConnection::ConnectionState state)
 
 }
 
+/**
+* @brief commandReplied()
+*        the node has replied to a command, record its round trip time
+* */
+void RTLSClient::commandReplied(const QByteArray &data, qint64 rtt)
+{
+    _latency.record(LatencyCommand, rtt);
+
+    qCDebug(lcSerial) << "command" << data.trimmed() << "replied in" << rtt / 1000000.0 << "ms";
+}
+
+void RTLSClient::commandFailed(const QByteArray &data, int attempts)
+{
+    qCWarning(lcSerial) << "command" << data.trimmed() << "not replied after" << attempts << "attempts";
+}
+
 /**
 * @brief phaseAndRangeCalibration()
 *        called during calibration to calculate the PDOA and range offsets.
@@ -731,116 +743,90 @@ void RTLSClient::phaseAndRangeCalibration(double phase, double range)
 
 /**
 * @brief motionFilter()
-*        perfrom the motion-filter on the x and y inputs
+*        run the tag's position filter on the x and y inputs (bit 0 of mode is the IMU stationary flag)
+*        and measure its processing time and the jitter of its input and output positions
 * */
-void RTLSClient::motionFilter(double* x, double* y, int i)
+void RTLSClient::motionFilter(double* x, double* y, int i, int mode)
 {
-     tag_reports_t rp = _tagList.at(i);
-
-     if (rp.filterHisIdx >= FILTER_SIZE)
+     tag_filter_t &f = _tagList.filter(i);
+     int type = f.filter.isNull() ? FilterNone : f.filter->type();
+     filter_stats_t st;
+     double inX = *x, inY = *y;
+     qint64 start = _clock.nsecsElapsed();
+     double us;
+
+     if(!f.filter.isNull())
      {
-         rp.filterHisIdx = fmod(rp.filterHisIdx,FILTER_SIZE);
-         rp.motionFilterReady = true;
+         f.filter->filter(x, y, start / 1e9, (mode & 0x1));
      }
 
-     rp.estXHis[rp.filterHisIdx] = *x;
-     rp.estYHis[rp.filterHisIdx] = *y;
+     us = (_clock.nsecsElapsed() - start) / 1000.0;
 
-     rp.filterHisIdx = rp.filterHisIdx + 1;
+     //the statistics are read by the GUI thread (filterStats())
+     _filterStatsLock.lock();
 
-     if (_motionFilterOn)
-     {
-         if(rp.motionFilterReady)
-         {
-             double tempX[FILTER_SIZE];
-             memcpy(tempX, &rp.estXHis[0], sizeof(tempX));
+     filter_stats_t &stats = _filterStats[type];
 
-             double tempY[FILTER_SIZE];
-             memcpy(tempY, &rp.estYHis[0], sizeof(tempY));
+     stats.count++;
+     stats.timeSum_us += us;
+     if(us > stats.timeMax_us)
+     {
+         stats.timeMax_us = us;
+     }
 
-             r95Sort(tempX,0,FILTER_SIZE-1);
+     if(f.hasLast)
+     {
+         stats.steps++;
+         stats.inStepSq += (inX - f.inX) * (inX - f.inX) + (inY - f.inY) * (inY - f.inY);
+         stats.outStepSq += (*x - f.outX) * (*x - f.outX) + (*y - f.outY) * (*y - f.outY);
+     }
 
-             *x = (tempX[FILTER_SIZE/2] + tempX[FILTER_SIZE/2-1])/2;
+     st = stats;
 
-             r95Sort(tempY,0,FILTER_SIZE-1);
+     _filterStatsLock.unlock();
 
-             *y = (tempY[FILTER_SIZE/2] + tempY[FILTER_SIZE/2-1])/2;
-         }
+     f.hasLast = true;
+     f.inX = inX; f.inY = inY;
+     f.outX = *x; f.outY = *y;
 
+     if((st.count % FILTER_STATS_PERIOD) == 0)
+     {
+         qCDebug(lcFilter) << "position filter" << PositionFilter::typeName(type)
+                  << "reports" << st.count
+                  << "time us (mean/max)" << (st.timeSum_us / st.count) << st.timeMax_us
+                  << "jitter m (in/out)" << sqrt(st.inStepSq / qMax(st.steps, (quint64)1))
+                  << sqrt(st.outStepSq / qMax(st.steps, (quint64)1));
      }
-
-     //update the list entry
-     _tagList.replace(i, rp);
  }
 
 /**
-* @brief r95Sort()
-*        R95 sort used by the motion filter function above
+* @brief setMotionFilterWindow()
+*        Set the number of reports the median motion filter takes the median of (> 2), the filter restarts
 * */
-void r95Sort (double s[], int l, int r)
+void RTLSClient::setMotionFilterWindow(int window)
 {
-    int i,j;
-    double x;
-    if(l<r)
-    {
-        i = l;
-        j = r;
-        x = s[i];
-        while(i<j)
-        {
-            while (i<j&&s[j]>x) j--;
-            if (i<j) s[i++] = s[j];
-            while (i<j&&s[i]<x) i++;
-            if (i < j) s[j--] = s[i];
-        }
-        s[i] = x;
-        r95Sort(s, l, i-1);
-        r95Sort(s, i+1, r);
-    }
-
+    _tagList.setFilterWindow(window);
 }
 
+/**
+* @brief Slot_RangeLog_Generate()
+*        Start a session log of the range reports in ./Logs (see SessionFile.h), with the raw serial data
+*        recorded alongside
+* */
 void RTLSClient::Slot_RangeLog_Generate(void)
 {
-	qDebug() << "Slot_RangeLog_connect";
-	is_startLog = true;
-	time_t now ;
-	struct tm *tm_now ;
-	char buf[20] = {0};
-	time(&now) ;
-	tm_now = localtime(&now) ;
-	sprintf(buf,"./Logs/Tag %d-%d-%d.log", tm_now->tm_hour, tm_now->tm_min, tm_now->tm_sec);
-	file_T = fopen(buf,"w");
-}
-
-
-/*
- *	内容：打印log到控制平台即log日志
- *	形参：
- *	返参：
- *
- */
-void RTLSClient::_dbg_printf3(const char *format, ...)
-{
-    uint32_t length;
-    char _dbg_TXBuff[1024];
-    va_list args;
-
-    va_start(args, format);
-    length = vsnprintf((char*)_dbg_TXBuff, sizeof(_dbg_TXBuff), (char*)format, args);
-    va_end(args);
+    QString name = QString("Tag %1").arg(QTime::currentTime().toString("h-m-s"));
 
-    QDateTime now = QDateTime::currentDateTime();
+    qCDebug(lcSerial) << "Slot_RangeLog_connect" << name;
 
-    qDebug("打印时间:%s,%s",now.toString("yyyy-MM-dd hh:mm:ss").toLatin1().data(), _dbg_TXBuff);
+    _log.setRotation(SESSION_ROTATE_BYTES, 0);
 
-    if(is_startLog)
+    if(!_log.open("./Logs", name, LogWriter::Session))
     {
-        QDateTime now = QDateTime::currentDateTime();
-
-        qDebug("打印时间:%s,%s",now.toString("yyyy-MM-dd hh:mm:ss").toLatin1().data(), _dbg_TXBuff);
-        fprintf(file_T,"打印时间:%s,%s",now.toString("yyyy-MM-dd hh:mm:ss").toLatin1().data(), _dbg_TXBuff);
+        emit statusBarMessage(tr("Can't create the log ./Logs/%1").arg(name));
+        return;
     }
-}
-
 
+    //record the raw serial data alongside, so the session can be replayed (see ReplaySource)
+    _connection->startCapture(QString("./Logs/%1.cap").arg(name));
+}
@@ -14,8 +14,14 @@
 #define RTLSCLIENT_H
 
 #include <QObject>
+#include <QElapsedTimer>
+#include <QMutex>
 
 #include "SerialConnection.h"
+#include "TagRegistry.h"
+#include "LatencyMonitor.h"
+#include "SpscQueue.h"
+#include "LogWriter.h"
 #include <stdint.h>
 
 
@@ -36,16 +42,18 @@
  */
 
 
-class QFile;
-
-#define HIS_LENGTH 100
-#define FILTER_SIZE 25/*10*/  //NOTE: filter size needs to be > 2
-
 #define CALIB_IGNORE_LEN 200 //NOTE: If a node is started from "cold", it will take a number of ranges to come up to
                              // the operational temperature. This temperature drift will cause offset to drift during
                              // the initial number of ranges. Thus while doing calibration the 1st 200 ranges will be ignored.
 #define CALIB_HIS_LEN 200
 
+#define FILTER_STATS_PERIOD 1000 //reports between two position filter statistics in the debug output
+
+#define TAG_UPDATE_QUEUE_LEN 1024 //position updates waiting for the GUI, must be a power of 2
+
+#define KLIST_TIMEOUT_MS 1000 //wait for the known tag list after connecting
+#define KLIST_RETRIES    2
+
 
 
 typedef struct{
@@ -66,29 +74,21 @@ typedef struct{
 user_cmd_t;
 
 
+/**
+* @brief tag_update_t
+*        one processed range/PDOA report, as handed from the I/O thread to the GUI
+*/
 typedef struct
 {
-    double x_arr[HIS_LENGTH]; //array containing history of x coordinates
-    double y_arr[HIS_LENGTH]; //array containing history of y coordinates
-
     quint64 id64;
-    int     id16;
-    short   multFast;
-    short   multSlow;
-    short   Mode;
-
-    int arr_idx;
-    int count;
-    int filterReady;
-    bool ready;
-
-    //motion filter
-    bool motionFilterReady; //set to true when enough data accumulated in the filter array
-    int filterHisIdx;
-    double estXHis[FILTER_SIZE];
-    double estYHis[FILTER_SIZE];
-
-} tag_reports_t;
+    double  x, y;       //position for the GUI (y-axis increases downwards)
+    double  range;
+    int     angle;
+    int     mode;
+    int     accX, accY, accZ;
+    qint64  rxTime;     //LatencyMonitor::now() when the report arrived
+    qint64  filterTime; //LatencyMonitor::now() when it left the position filter
+} tag_update_t;
 
 typedef struct
 {
@@ -105,21 +105,19 @@ class RTLSClient : public QObject
     Q_OBJECT
 
 public:
-    explicit RTLSClient(QObject *parent = 0);
+    explicit RTLSClient(SerialConnection *connection, QObject *parent = 0);
 
     void updateTagStatistics(int i, double x, double y);
     void addTagToList(quint64 id64);
     void updateTagAddr16(quint64 id64, int id16);
     void addTagFromKList(short slot, quint64 id64, short id16,short mFast, short mSlow, short mode);
 
-    void enableMotionFilter(bool enabled);
-    void enablePhaseAndDistCalibration(quint64 id64, double distance);
-
     void phaseAndRangeCalibration(double phase, double range);
-    void motionFilter(double *x, double *y, int tid);
+    void motionFilter(double *x, double *y, int tid, int mode);
 
-    double getPhaseOffset(void);
-    double getRangeOffset(void);
+    //set on the I/O thread: from the GUI call them with a BlockingQueuedConnection, or use the *OffsetUpdated() signals
+    Q_INVOKABLE double getPhaseOffset(void);
+    Q_INVOKABLE double getRangeOffset(void);
 
     void processRangeAndPDOAReport(int tid, int seq,
                                     double range_m, double x_m, double y_m,
@@ -132,16 +130,37 @@ public:
 
     void removeTagFromList(quint64 id64);
 
-    void _dbg_printf3(const char *format, ...);
+    //GUI side of the position update queue (the reports are processed on the I/O thread)
+    bool takeUpdate(tag_update_t *update);
+    void rearmUpdates(void);
+    int updateQueueDepth(void) const;
+    int updateQueueMaxDepth(void) const;
+    int droppedUpdates(void) const;
+
+    //position filter statistics per PositionFilterType (updated on the I/O thread, a copy is returned)
+    filter_stats_t filterStats(int type) const;
+    void resetFilterStats(void);
+
+    //per stage latency from the serial port to the scene, recorded on both threads
+    LatencyMonitor *latency(void) { return &_latency; }
+
+    //log of the range reports, written on its own thread (see Slot_RangeLog_Generate())
+    LogWriter *rangeLog(void) { return &_log; }
+
+public slots:
+    void setAppVersion(const QString &version);
+    void enableMotionFilter(bool enabled);
+    void setMotionFilterWindow(int window);
+    void setDefaultFilter(int type);
+    void setTagFilter(quint64 id64, int type);
+    void enablePhaseAndDistCalibration(quint64 id64, double distance);
 
 signals:
 
     void clearTags();
-    void tagPos(quint64 tagId, double x, double y, int mode);
+    void updatesReady(void); //emitted when the update queue goes from empty to non-empty, see rearmUpdates()
     void nodePos(int nodeId, double x, double y);
-    void tagRange(quint64 tagID, double range, double x, double y, int angle, int mode,int Acc_x,int Acc_y, int Acc_z);
     void statusBarMessage(QString status);
-    void Signal_Uart_Recvdata(QByteArray data);
 
     void centerOnNodes();
 
@@ -154,7 +173,6 @@ signals:
     void rangeOffsetUpdated(double rangeOffset);
 
 protected slots:
-    void onReady();
     void onConnected(QString conf);
     void GetList();
     void save();
@@ -162,15 +180,20 @@ protected slots:
     void Slot_RangeLog_Generate(void);
 
 private slots:
-    void newData();
+    void reportFrame(const QByteArray &frame);
+    void binReportFrame(const QByteArray &frame);
+    void listFrame(const QByteArray &frame);
     void connectionStateChanged(SerialConnection::ConnectionState);
+    void commandReplied(const QByteArray &data, qint64 rtt);
+    void commandFailed(const QByteArray &data, int attempts);
 
 private:
     bool _first;
 
-    QList <tag_reports_t> _tagList;
+    TagRegistry _tagList;
 
-    SerialConnection *_serial;
+    SerialConnection *_serial;      //set while connected
+    SerialConnection *_connection;  //the serial connection the frames come from
 
     node_struct_t _nodeConfig[1]; //current demo has only 1 PDOA node
     int _nodeAdd;
@@ -178,7 +201,13 @@ private:
     QString _verNode;
     QString _verGUI;
 
-    bool _motionFilterOn;    //set to true when motion filter is running
+    QElapsedTimer _clock;   //time of the reports for the position filters
+    filter_stats_t _filterStats[FilterTypes];
+    mutable QMutex _filterStatsLock;    //only held to update or copy _filterStats
+
+    LatencyMonitor _latency;
+
+    LogWriter _log;
 
     int calibInx;
 
@@ -189,10 +218,13 @@ private:
     bool _calibrationDone;
     quint64 _calibrationTagID;
 
-    QByteArray _data;
+    SpscQueue<tag_update_t, TAG_UPDATE_QUEUE_LEN> _updates;
+    QAtomicInt _updatesSignalled;   //set when updatesReady() has been emitted and not yet re-armed by the GUI
+    QAtomicInt _updatesMaxDepth;
+    QAtomicInt _updatesDropped;
 
-};
+    void postUpdate(const tag_update_t &update);
 
-void r95Sort(double s[], int l, int r);
+};
 
 #endif // RTLSCLIENT_H
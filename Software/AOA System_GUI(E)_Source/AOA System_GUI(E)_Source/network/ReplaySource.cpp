@@ -0,0 +1,135 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: ReplaySource.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "ReplaySource.h"
+#include "LogCategories.h"
+
+#include <QFileInfo>
+#include <QDebug>
+
+ReplaySource::ReplaySource(SerialConnection *target, QObject *parent) :
+    QObject(parent),
+    _target(target),
+    _speed(1),
+    _chunkTime(0),
+    _havePending(false),
+    _chunks(0),
+    _bytes(0)
+{
+    _timer = new QTimer(this);
+    _timer->setSingleShot(true);
+    connect(_timer, SIGNAL(timeout()), this, SLOT(feed()));
+
+    //the user may disconnect in the middle of the replay
+    connect(_target, SIGNAL(connectionStateChanged(SerialConnection::ConnectionState)),
+            this, SLOT(connectionStateChanged(SerialConnection::ConnectionState)));
+}
+
+void ReplaySource::connectionStateChanged(SerialConnection::ConnectionState state)
+{
+    if(state == SerialConnection::Disconnected)
+    {
+        stop();
+    }
+}
+
+void ReplaySource::start(const QString &path, double speed)
+{
+    stop();
+
+    if(_target->serialPort()->isOpen())
+    {
+        qCWarning(lcSerial) << "replay: close the serial port first";
+        return;
+    }
+
+    if(!_reader.open(path))
+    {
+        return;
+    }
+
+    qCDebug(lcSerial) << "replay:" << path << "speed" << speed;
+
+    _speed = (speed > 0) ? speed : 0;
+    _havePending = false;
+    _chunks = 0;
+    _bytes = 0;
+
+    _target->openReplay(QFileInfo(path).fileName());
+
+    _clock.start();
+    _timer->start(0);
+}
+
+void ReplaySource::stop(void)
+{
+    if(!_reader.isOpen())
+    {
+        return;
+    }
+
+    _timer->stop();
+    _reader.close();
+
+    qCDebug(lcSerial) << "replay: done" << _chunks << "chunks" << _bytes << "bytes in" << _clock.elapsed() << "ms";
+
+    emit finished(_chunks, _bytes, _clock.elapsed());
+
+    _target->closeReplay();
+}
+
+/**
+* @brief feed()
+*        hand over the chunks which are due, then wait for the next one
+*        (as fast as possible: a batch at a time, so the queued display updates keep flowing)
+* */
+void ReplaySource::feed(void)
+{
+    int batch = 0;
+
+    while(_reader.isOpen())
+    {
+        if(!_havePending)
+        {
+            if(!_reader.next(&_chunkTime, &_chunk))
+            {
+                stop();
+                return;
+            }
+
+            _havePending = true;
+        }
+
+        if(_speed > 0)
+        {
+            qint64 due_ms = (qint64)(_chunkTime / (1000.0 * _speed));
+            qint64 now_ms = _clock.elapsed();
+
+            if(due_ms > now_ms)
+            {
+                _timer->start(due_ms - now_ms);
+                return;
+            }
+        }
+        else if(batch++ >= REPLAY_BATCH)
+        {
+            _timer->start(0);
+            return;
+        }
+
+        _havePending = false;
+        _chunks++;
+        _bytes += _chunk.size();
+
+        _target->ingest(_chunk.constData(), _chunk.size());
+    }
+}
@@ -0,0 +1,67 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: ReplaySource.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "CaptureFile.h"
+#include "SerialConnection.h"
+
+#define REPLAY_BATCH (256) //chunks fed in one go before going back to the event loop (as fast as possible mode)
+
+/**
+* @brief ReplaySource
+*        Feeds a capture (see CaptureFile.h) into the serial connection in place of the serial port, so a recorded
+*        session goes through the frame decoding, the RTLS client and the display as it did live.
+*        It must live in the same thread as the serial connection.
+*
+*        speed: 1 = real time, N = N times faster, 0 = as fast as possible
+*/
+class ReplaySource : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReplaySource(SerialConnection *target, QObject *parent = 0);
+
+    bool isRunning(void) const { return _reader.isOpen(); }
+
+public slots:
+    void start(const QString &path, double speed);
+    void stop(void);
+
+signals:
+    void finished(int chunks, qint64 bytes, qint64 elapsed_ms);
+
+private slots:
+    void feed(void);
+    void connectionStateChanged(SerialConnection::ConnectionState state);
+
+private:
+    SerialConnection *_target;
+    CaptureReader _reader;
+    QTimer *_timer;
+    QElapsedTimer _clock;
+    double _speed;
+
+    QByteArray _chunk;      //next chunk, waiting for its time
+    qint64 _chunkTime;      //its time in the capture, us
+    bool _havePending;
+
+    int _chunks;
+    qint64 _bytes;
+};
+
+#endif // REPLAYSOURCE_H
@@ -14,12 +14,14 @@
 
 #include <QDebug>
 #include <QSerialPortInfo>
-#include <QMessageBox>
+#include <QMetaMethod>
+#include <string.h>
 #include "json_utils.h"
-#include "windows.h"
+#include "LatencyMonitor.h"
+#include "LogCategories.h"
 
 #define INST_VERSION_LEN  (64)
-#define MIN_JSON_HEADER   (6)   //JS + 4 chars of length e.g. 'JSxxxx{.....}'
+#define CONSOLE_MAX_LEN   (9096) //drop an unterminated line once it gets this long
 
 
 SerialConnection::SerialConnection(QObject *parent) :
@@ -35,8 +37,16 @@ SerialConnection::SerialConnection(QObject *parent) :
     _timer = new QTimer(this);
     connect(_timer, SIGNAL(timeout()), this, SLOT(timerUpdateExpire()));
 
+    //the commands are written one at a time, when the previous one has been replied to or has timed out
+    _commands = new CommandScheduler(this);
+    connect(_commands, SIGNAL(write(QByteArray)), this, SLOT(writeData(QByteArray)));
+
     _processingData = true;
-    qDebug() << "------------SerialConnection 123------------";
+    _replaying = false;
+    _consoleChecked = 0;
+    _rxTime = 0;
+    _decodeTime = 0;
+    qCDebug(lcSerial) << "------------SerialConnection 123------------";
 
 }
 
@@ -62,7 +72,7 @@ void SerialConnection::findSerialDevices()
     //for (QSerialPortInfo port : QSerialPortInfo::availablePorts())
     {
         //Their is some sorting to do for just list the port I want, with vendor Id & product Id
-        qDebug() << port.portName() << port.vendorIdentifier() << port.productIdentifier()
+        qCDebug(lcSerial) << port.portName() << port.vendorIdentifier() << port.productIdentifier()
                  << port.hasProductIdentifier() << port.hasVendorIdentifier()
                  //<< port.isBusy()
                  << port.manufacturer() << port.description();
@@ -79,9 +89,32 @@ void SerialConnection::findSerialDevices()
 
 int SerialConnection::openSerialPort(QSerialPortInfo x)
 {
-    int error = 0;
     _serial->setPort(x);
 
+    return openSelectedPort();
+}
+
+/**
+* @brief openPort()
+*        open the serial port by its name or device path (e.g. /dev/ttyACM0 or a pseudo terminal),
+*        it does not need to be in the list of the discovered devices
+* */
+int SerialConnection::openPort(const QString &name)
+{
+    if(_serial->isOpen())
+    {
+        closeConnection(false);
+    }
+
+    _serial->setPortName(name);
+
+    return openSelectedPort();
+}
+
+int SerialConnection::openSelectedPort(void)
+{
+    int error = 0;
+
     if(!_serial->isOpen())
     {
         if (_serial->open(QIODevice::ReadWrite))
@@ -92,9 +125,9 @@ int SerialConnection::openSerialPort(QSerialPortInfo x)
             _serial->setStopBits(QSerialPort::OneStop/*p.stopBits*/);
             _serial->setFlowControl(QSerialPort::NoFlowControl /*p.flowControl*/);
 
-            emit statusBarMessage(tr("Connected to %1").arg(x.portName()));
+            emit statusBarMessage(tr("Connected to %1").arg(_serial->portName()));
 
-            connect(_serial, SIGNAL(readyRead()), this, SLOT(readData()));
+            connect(_serial, SIGNAL(readyRead()), this, SLOT(readData()), Qt::UniqueConnection);
 
 
             _serial->clear();
@@ -114,7 +147,7 @@ int SerialConnection::openSerialPort(QSerialPortInfo x)
             emit statusBarMessage(tr("打开失败"));
             //emit statusBarMessage(tr("Open error"));
 
-            qDebug() << "Serial error: " << _serial->error();
+            qCWarning(lcSerial) << "Serial error: " << _serial->error();
 
             _serial->close();
 
@@ -125,7 +158,7 @@ int SerialConnection::openSerialPort(QSerialPortInfo x)
     }
     else
     {
-        qDebug() << "port already open!";
+        qCDebug(lcSerial) << "port already open!";
 
         error = 0;
     }
@@ -148,13 +181,13 @@ int SerialConnection::openConnection(int index)
     //open port from list
     x = _portInfo.at(index);
 
-    qDebug() << "port is busy? "
+    qCDebug(lcSerial) << "port is busy? "
              //<< x.isBusy()
              << "index " << index << " = found " << foundit;
 
     //if(!open) return -1;
 
-    qDebug() << "open serial port " << index << x.portName();
+    qCDebug(lcSerial) << "open serial port " << index << x.portName();
 
     //open serial port
     return openSerialPort(x);
@@ -163,6 +196,7 @@ int SerialConnection::openConnection(int index)
 void SerialConnection::closeConnection(bool error)
 {
     _timer->stop();
+    _commands->clear();
 
 //    if(!error) //the serial port is closing gracefully (e.g. cable has not been unplugged)
 //        writeData("stop\r\n");
@@ -178,6 +212,12 @@ void SerialConnection::closeConnection(bool error)
     emit connectionStateChanged(Disconnected);
 
     _processingData = true;
+    _replaying = false;
+    _decoder.clear();
+    _console.clear();
+    _consoleChecked = 0;
+
+    stopCapture();
 }
 
 void SerialConnection::writeData(const QByteArray &data)
@@ -191,15 +231,37 @@ void SerialConnection::writeData(const QByteArray &data)
     }
     else
     {
-        qDebug() << "not open - can't write?";
+        qCWarning(lcSerial) << "not open - can't write?";
     }
 
-    qDebug() << "send:" << data.constData() << _serial->isOpen();
+    qCDebug(lcSerial) << "send:" << data.constData() << _serial->isOpen();
     //emit connectionStateChanged(Connected);
 }
 
+/**
+* @brief queueCommand()
+*        send \a data to the node once the commands before it are done, \a reply is the root element name of the
+*        node's reply to wait for (none: just pause for \a timeout ms), see CommandScheduler::queue()
+*        There is no node to send them to during a replay: they are dropped
+* */
+void SerialConnection::queueCommand(const QByteArray &data, const QByteArray &reply, int timeout, int retries)
+{
+    if(_replaying)
+    {
+        qCDebug(lcSerial) << "replay, not sent:" << data.trimmed();
+        return;
+    }
+
+    _commands->queue(data, reply, timeout, retries);
+}
+
 void SerialConnection::clear()
 {
+    if(_replaying)
+    {
+        return;
+    }
+
     _serial->clear();
 }
 
@@ -208,90 +270,397 @@ void SerialConnection::cancelConnection()
     emit connectionStateChanged(ConnectionFailed);
 }
 
-void SerialConnection::readData(void)
+/**
+* @brief frameType()
+*        classify a decoded JSON object by its root element name e.g. {"TWR": {...}}, binary frames are reports
+* */
+enum
 {
-    if(_processingData)
+    FrameInfo = 0,
+    FrameReport,
+    FrameBinReport,
+    FrameList
+};
+
+static int frameType(const js_frame_t &frame, const char **name, int *nameLength)
+{
+    const char *p = frame.data;
+    const char *end = frame.data + frame.length;
+
+    *name = NULL;
+    *nameLength = 0;
+
+    if(frame.type == JS_FRAME_BIN)
     {
-        QByteArray data = _serial->readAll();
-        QByteArray dataChunk;
+        return FrameBinReport;
+    }
 
-        int offset = 0;
+    //skip '{' and any white space up to the opening quote of the root element name
+    while((p < end) && (*p != '"'))
+    {
+        p++;
+    }
 
-        _data.append(data);
+    if(p == end)
+    {
+        return FrameList;
+    }
+
+    p++;
+
+    *name = p;
+
+    while((*nameLength < (end - p)) && (p[*nameLength] != '"'))
+    {
+        (*nameLength)++;
+    }
 
-        int length = _data.length();
+    if(((end - p) > 5) && (memcmp(p, "Info\"", 5) == 0))
+    {
+        return FrameInfo;
+    }
+
+    if((((end - p) > 4) && (memcmp(p, "TWR\"", 4) == 0)) ||
+       (((end - p) > 3) && (memcmp(p, "SN\"", 3) == 0)))
+    {
+        return FrameReport;
+    }
 
-        while(length > 1) // we have received a range report from the node
+    return FrameList;
+}
+
+/**
+* @brief readData()
+*        Read everything the port has received straight into the frame decoder, tap it for the serial console
+*        and dispatch the complete frames after each read: more than the decoder holds may be waiting
+*        (e.g. after a stall), and a full decoder drops the pending bytes whether they form frames or not.
+* */
+void SerialConnection::readData(void)
+{
+    qint64 available;
+
+    _rxTime = LatencyMonitor::now();
+
+    while((available = _serial->bytesAvailable()) > 0)
+    {
+        int space = 0;
+        char *ptr = _decoder.writePtr(&space);
+        qint64 length = _serial->read(ptr, qMin(available, (qint64)space));
+
+        if(length <= 0)
         {
-            QByteArray header = _data.mid(offset, 2);
+            break;
+        }
 
-            if(header.contains("JS")) //loop here until we reach header ("JS")
-            {
-			    //123456789....  : length
-			    //      12345... : jlength : JSON object length, including curly brackets
-			    //JS  xx{"TWR": {"a16":"2E5C","R":3,"T":8605,"D":343,"P":1695,"Xcm":165,"Ycm":165,"O":14,"V":1,"X":53015,"Y":60972,"Z":10797}}
-	            if(length > 6)
-                {
-                    bool ok = false;
-                    int jlength =  _data.mid(offset+2, 4).toInt(&ok,16);
+        _decoder.commit(length);
 
-                    if(ok && (length >= jlength+6))
-                    {
-                        //get the JSON object including curly brackets from the stream
-                        dataChunk = _data.mid(offset+MIN_JSON_HEADER, jlength);
+        _capture.write(ptr, length);
 
-                        qDebug() << "SerialConnection::readData" << jlength << "data" << dataChunk;
-                        {//awaiting for version object, no more
+        consoleTap(ptr, length);
 
-                            QString device, version;
+        dispatchFrames();
+    }
+}
 
-                            check_json_version(dataChunk, &device, &version );
+/**
+* @brief ingest()
+*        Same as readData() for bytes which do not come from the serial port (a replayed capture),
+*        fed in pieces of at most half the decoder so that the frames are dispatched before it is full
+* */
+void SerialConnection::ingest(const char *data, int length)
+{
+    _rxTime = LatencyMonitor::now();
 
-                            offset += (jlength+MIN_JSON_HEADER);
-                            length -= (jlength+MIN_JSON_HEADER);
+    while(length > 0)
+    {
+        int piece = qMin(length, _decoder.capacity() / 2);
 
-                            if(device.contains("Node"))
-                            {
-                                qDebug() << "Node version: " << version;
+        _decoder.append(data, piece);
 
-                                _connectionConfig = version.mid(0,10);
-                                _processingData = false;
-                                _gotKlist = false;
+        consoleTap(data, piece);
 
-                                _serial->clear();
+        dispatchFrames();
 
-								//久凌电子 处理数据槽函数 newdata()
-                                emit serialOpened(_connectionConfig);
+        data += piece;
+        length -= piece;
+    }
+}
 
-                                return;
-                            }
-                        }
-                    }
-                    else
+/**
+* @brief openReplay()
+*        Act as connected to a node for the replay of a capture: there is no handshake,
+*        the frames are dispatched straight away
+* */
+void SerialConnection::openReplay(const QString &name)
+{
+    _decoder.clear();
+    _console.clear();
+    _consoleChecked = 0;
+
+    _replaying = true;
+    _processingData = false;
+    _gotKlist = false;
+
+    emit statusBarMessage(tr("Replaying %1").arg(name));
+    emit connectionStateChanged(Connected);
+    emit serialOpened(tr("replay %1").arg(name));
+}
+
+void SerialConnection::closeReplay(void)
+{
+    if(_replaying)
+    {
+        closeConnection(false);
+    }
+}
+
+/**
+* @brief startCapture()
+*        Record the received bytes to a capture file (see CaptureFile.h) for a later replay.
+*        The known tag list is requested again so that it is part of the capture.
+* */
+bool SerialConnection::startCapture(const QString &path)
+{
+    if(!_capture.open(path))
+    {
+        return false;
+    }
+
+    qCDebug(lcSerial) << "capture:" << path;
+
+    if(_serial->isOpen() && !_processingData)
+    {
+        queueCommand("getKList\r\n", "KList");
+    }
+
+    return true;
+}
+
+void SerialConnection::stopCapture(void)
+{
+    _capture.close();
+}
+
+/**
+* @brief dispatchFrames()
+*        Until the node has replied to "deca$" only the "Info" object is of interest (the handshake),
+*        after that each frame is emitted once to the subscribers of its type.
+*        Binary reports are accepted whatever was negotiated, so a node left in the binary mode still works.
+* */
+void SerialConnection::dispatchFrames(void)
+{
+    js_frame_t frame;
+    const char *name;
+    int nameLength;
+
+    while(_decoder.next(&frame))
+    {
+        _decodeTime = LatencyMonitor::now();
+
+        const QByteArray dataChunk = QByteArray::fromRawData(frame.data, frame.length);
+
+        switch(frameType(frame, &name, &nameLength))
+        {
+            case FrameInfo:
+            {
+                if(_processingData) //awaiting for version object, no more
+                {
+                    QString device, version;
+                    int binReport = 0;
+
+                    qCDebug(lcSerial) << "SerialConnection::readData" << frame.length << "data" << dataChunk;
+
+                    check_json_version(dataChunk, &device, &version, &binReport);
+
+                    if(device.contains("Node"))
                     {
-                        break;
+                        qCDebug(lcSerial) << "Node version: " << version;
+
+                        _connectionConfig = version.mid(0,10);
+                        _processingData = false;
+                        _gotKlist = false;
+
+                        _decoder.clear();
+                        _serial->clear();
+
+                        //the node advertises the compact binary reports, switch to them (JSON stays the fallback)
+                        if(binReport == BIN_REPORT_VERSION)
+                        {
+                            qCDebug(lcSerial) << "Node supports binary reports";
+
+                            queueCommand(BIN_REPORT_CMD, QByteArray(), CMD_PAUSE_MS);
+                        }
+
+                        //久凌电子 处理数据槽函数 newdata()
+                        emit serialOpened(_connectionConfig);
+
+                        return;
                     }
                 }
-                else
+            }
+            break;
+
+            case FrameReport:
+            {
+                if(!_processingData)
                 {
-                    break;
+                    emit reportFrame(dataChunk);
                 }
             }
-            else
+            break;
+
+            case FrameBinReport:
             {
-                offset += 1;
-                length -= 1;
+                if(!_processingData)
+                {
+                    emit binReportFrame(dataChunk);
+                }
             }
+            break;
 
-        } //end of while
-        _data = _data.right(length);
+            case FrameList:
+            default:
+            {
+                if(!_processingData)
+                {
+                    emit listFrame(dataChunk);
+
+                    //a reply the command in flight was waiting for, send the next one
+                    _commands->replyReceived(name, nameLength);
+                }
+            }
+            break;
+        }
+    }
+
+    if(_processingData)
+    {
         writeData("deca$\r\n");
     }
 }
 
+/**
+* @brief consoleStripBin()
+*        Remove the binary report frames (FrameBinReport) from the console text, they are not text.
+*        Return the length of the text which is final: a 'JB' at the end may be a frame still coming in.
+* */
+int SerialConnection::consoleStripBin(void)
+{
+    int pos = _consoleChecked;
+
+    while((pos = _console.indexOf('J', pos)) != -1)
+    {
+        int remaining = _console.size() - pos;
+        int plength;
+        uint16_t crc;
+
+        if(remaining < JB_HEADER_LEN)
+        {
+            if((remaining == 1) || (_console.at(pos + 1) == 'B'))
+            {
+                return pos; //wait for the length
+            }
+
+            pos++;
+            continue;
+        }
+
+        if(_console.at(pos + 1) != 'B')
+        {
+            pos++;
+            continue;
+        }
+
+        plength = (uchar)_console.at(pos + 2);
+
+        if((plength == 0) || (plength > JB_MAX_PAYLOAD_LEN))
+        {
+            pos += 2;
+            continue;
+        }
+
+        if(remaining < (JB_HEADER_LEN + plength + JB_CRC_LEN))
+        {
+            return pos; //wait for the rest of the frame
+        }
+
+        crc = (uchar)_console.at(pos + JB_HEADER_LEN + plength) |
+              ((uchar)_console.at(pos + JB_HEADER_LEN + plength + 1) << 8);
+
+        if(crc == JsFrameDecoder::crc16(_console.constData() + pos + 2, plength + 1))
+        {
+            _console.remove(pos, JB_HEADER_LEN + plength + JB_CRC_LEN);
+        }
+        else
+        {
+            pos += 2;
+        }
+    }
+
+    return _console.size();
+}
+
+/**
+* @brief consoleTap()
+*        Collect the received text and pass it to the serial console one or more complete lines at a time,
+*        without the binary reports. Skipped when nobody is listening.
+* */
+void SerialConnection::consoleTap(const char *data, int length)
+{
+    static const QMetaMethod consoleSignal = QMetaMethod::fromSignal(&SerialConnection::consoleData);
+    int complete;
+    int end = -1;
+
+    if(!isSignalConnected(consoleSignal))
+    {
+        return;
+    }
+
+    _console.append(data, length);
+
+    complete = consoleStripBin();
+
+    //only whole lines in front of a binary frame which is still coming in
+    if(complete >= 2)
+    {
+        end = _console.lastIndexOf("\r\n", complete - 2);
+    }
+
+    if(end != -1)
+    {
+        end += 2;
+
+        if(end == _console.size()) //the usual case, hand over the whole buffer without copying it
+        {
+            emit consoleData(_console);
+            _console = QByteArray();
+        }
+        else
+        {
+            emit consoleData(_console.left(end));
+            _console.remove(0, end);
+        }
+
+        complete -= end;
+    }
+
+    _consoleChecked = complete;
+
+    if(_console.size() > CONSOLE_MAX_LEN)
+    {
+        _console.clear();
+        _consoleChecked = 0;
+    }
+}
+
 
 void SerialConnection::timerUpdateStart(int t)
 {
+    if(_replaying) //the tag lists are in the capture
+    {
+        return;
+    }
+
     _timer->start(t);
 }
 
@@ -299,10 +668,10 @@ void SerialConnection::timerUpdateStart(int t)
 void SerialConnection::timerUpdateExpire(void)
 {//send
 	//久凌电子
-    writeData("getDlist\r\n");   //get the list of discovered tags
+    queueCommand("getDlist\r\n", "DList");   //get the list of discovered tags
 
     if(!_gotKlist)
-        writeData("getKList\r\n");
+        queueCommand("getKList\r\n", "KList");
 
     _timer->setInterval(20000);
 }
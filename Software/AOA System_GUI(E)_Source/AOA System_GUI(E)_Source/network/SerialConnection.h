@@ -18,14 +18,38 @@
 #include <QStringList>
 #include <QTimer>
 
+#include "JsFrameDecoder.h"
+#include "CaptureFile.h"
+#include "CommandScheduler.h"
+
 #define DEVICE_STR_USB ("STMicroelectronics Virtual COM Port")
 #define DEVICE_STR_UART1 ("USB-SERIAL CH340")
 #define DEVICE_STR_UART2 ("Silicon Labs CP210x USB to UART Bridge")
 
+#define BIN_REPORT_VERSION  (1)                 //binary report format (jb_twr_t) this viewer understands
+#define BIN_REPORT_CMD      ("setbin 1\r\n")   //switch the node to the binary reports
+
 /**
 * @brief SerialConnection
 *        Constructor, it initialises the Serial Connection its parts
 *        it is used for managing the COM port connection.
+*
+*        It is also the single ingest stage for the bytes received from the node: the port is read once,
+*        the 'JSxxxx{...}' frames are decoded once and then fanned out to the subscribers by type:
+*        - serialOpened()  : "Info" reply to the "deca$" handshake
+*        - reportFrame()   : "TWR"/"SN" range and service reports
+*        - binReportFrame(): compact binary range reports (jb_twr_t), if the node supports them
+*        - listFrame()     : all other replies (KList, DList, NewTag, TagAdded, TagDeleted, Calibration)
+*        - consoleData()   : raw tap of the received text, split on "\r\n", for the serial console
+*
+*        The commands for the node are paced by a CommandScheduler (queueCommand()): each one is written when the
+*        reply to the previous one has been received or has timed out, the thread is never put to sleep.
+*
+*        The bytes can also be recorded to a capture file (startCapture()), and a capture can be fed back in place of
+*        the serial port (openReplay(), ingest(), closeReplay() - see ReplaySource).
+*
+*        reportFrame() and listFrame() pass a QByteArray which refers to the decoder's buffer, it is only
+*        valid during the call, so subscribers must use a direct connection and copy what they want to keep.
 */
 class SerialConnection : public QObject
 {
@@ -45,7 +69,7 @@ public:
     QSerialPort *_serial;
     
 
-    void findSerialDevices(); //find any tags or PDOA nodes that are connected to the PC
+    Q_INVOKABLE void findSerialDevices(); //find any tags or PDOA nodes that are connected to the PC
 
     int openSerialPort(QSerialPortInfo x); //open selected serial port
 
@@ -55,6 +79,22 @@ public:
 
     void timerUpdateStart(int);
 
+    //send a command through the command queue, see CommandScheduler::queue()
+    //(from the GUI thread: QMetaObject::invokeMethod() with all four arguments)
+    Q_INVOKABLE void queueCommand(const QByteArray &data, const QByteArray &reply = QByteArray(),
+                      int timeout = CMD_TIMEOUT_MS, int retries = 0);
+    CommandScheduler *commands(void) { return _commands; }
+
+    //replay of a capture in place of the serial port (see ReplaySource)
+    void openReplay(const QString &name);
+    void ingest(const char *data, int length);
+    void closeReplay(void);
+    bool isReplaying(void) const { return _replaying; }
+
+    //LatencyMonitor::now() stamps of the frame being dispatched (only valid in the frame signals' slots)
+    qint64 rxTime(void) const { return _rxTime; }           //readyRead (or replayed chunk) which completed the frame
+    qint64 decodeTime(void) const { return _decodeTime; }   //frame found by the decoder
+
 signals:
     void serialError(void);
     void getCfg(void);
@@ -64,10 +104,16 @@ signals:
     void connectionStateChanged(SerialConnection::ConnectionState);
     void serialOpened(QString);
 
+    void reportFrame(const QByteArray &frame);
+    void binReportFrame(const QByteArray &frame);
+    void listFrame(const QByteArray &frame);
+    void consoleData(QByteArray data);
+
 public slots:
     void closeConnection(bool);
     void cancelConnection();
     int  openConnection(int index);
+    int  openPort(const QString &name);
     void readData(void);
     void timerUpdateExpire(void);
     void writeData(const QByteArray &data);
@@ -75,15 +121,23 @@ public slots:
 
     void gotKlist(bool gotit);
 
+    bool startCapture(const QString &path);
+    void stopCapture(void);
+
 protected slots:
 
     void handleError(QSerialPort::SerialPortError error);
 
 private:
+    int  openSelectedPort(void);
+    void consoleTap(const char *data, int length);
+    int  consoleStripBin(void);
+    void dispatchFrames(void);
+
     QList<QSerialPortInfo>    _portInfo ;
     QStringList _ports;
 
-    QList<QByteArray> _cmdList ;
+    CommandScheduler *_commands;
 
     QString _connectionVersion;
     QString _connectionConfig;
@@ -91,7 +145,16 @@ private:
     bool _gotKlist;
 
     QTimer *_timer;
-    QByteArray _data;
+
+    JsFrameDecoder _decoder;
+    QByteArray _console;
+    int _consoleChecked;    //bytes of _console already searched for binary frames
+
+    CaptureWriter _capture;
+    bool _replaying;
+
+    qint64 _rxTime;
+    qint64 _decodeTime;
 };
 
 #endif // SERIALCONNECTION_H
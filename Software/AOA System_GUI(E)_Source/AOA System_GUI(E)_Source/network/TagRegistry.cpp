@@ -0,0 +1,163 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: TagRegistry.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "TagRegistry.h"
+
+#include <string.h>
+
+TagRegistry::TagRegistry() :
+    _filterType(FilterNone),
+    _filterWindow(FILTER_SIZE)
+{
+}
+
+int TagRegistry::insert(quint64 id64, int id16)
+{
+    int index = indexOf64(id64);
+
+    if(index == -1)
+    {
+        if(!_free.isEmpty())
+        {
+            index = _free.takeLast();
+        }
+        else
+        {
+            index = _info.size();
+            _info.resize(index + 1);
+            _history.resize(index + 1);
+            _filter.resize(index + 1);
+        }
+
+        _by64.insert(id64, index);
+    }
+    else
+    {
+        //the tag is known already, forget its old 16-bit address
+        setId16(index, -1);
+    }
+
+    memset(&_info[index], 0, sizeof(tag_info_t));
+    memset(&_history[index], 0, sizeof(tag_history_t));
+    setFilterType(index, _filterType);
+
+    _info[index].id64 = id64;
+    _info[index].id16 = -1;
+    _info[index].used = true;
+
+    setId16(index, id16);
+
+    return index;
+}
+
+/**
+* @brief setId16()
+*        same conflict handling as the node: the last tag given an address keeps it,
+*        any other tag with the same address is marked as not having an address (-1)
+* */
+void TagRegistry::setId16(int index, int id16)
+{
+    tag_info_t &tag = _info[index];
+    int other;
+
+    if(tag.id16 == id16)
+    {
+        return;
+    }
+
+    if(tag.id16 != -1)
+    {
+        _by16.remove(tag.id16);
+    }
+
+    tag.id16 = id16;
+
+    if(id16 == -1)
+    {
+        return;
+    }
+
+    //another tag with same 16 bit address
+    other = indexOf16(id16);
+
+    if(other != -1)
+    {
+        _info[other].id16 = -1;
+    }
+
+    _by16.insert(id16, index);
+}
+
+bool TagRegistry::remove(quint64 id64)
+{
+    int index = indexOf64(id64);
+
+    if(index == -1)
+    {
+        return false;
+    }
+
+    setId16(index, -1);
+
+    _by64.remove(id64);
+
+    _info[index].used = false;
+    _filter[index].filter.clear();
+    _free.append(index);
+
+    return true;
+}
+
+void TagRegistry::clear(void)
+{
+    _info.clear();
+    _history.clear();
+    _filter.clear();
+    _free.clear();
+    _by64.clear();
+    _by16.clear();
+}
+
+void TagRegistry::setFilterType(int index, int type)
+{
+    tag_filter_t &f = _filter[index];
+
+    f.filter = QSharedPointer<PositionFilter>(PositionFilter::create(type, _filterWindow));
+    f.hasLast = false;
+}
+
+void TagRegistry::setFilterType(int type)
+{
+    _filterType = type;
+
+    for(int i = 0; i < _info.size(); i++)
+    {
+        if(_info.at(i).used)
+        {
+            setFilterType(i, type);
+        }
+    }
+}
+
+void TagRegistry::setFilterWindow(int window)
+{
+    _filterWindow = window;
+
+    //re-create the median filters with the new window
+    for(int i = 0; i < _info.size(); i++)
+    {
+        if(_info.at(i).used && !_filter.at(i).filter.isNull() && (_filter.at(i).filter->type() == FilterMedian))
+        {
+            setFilterType(i, FilterMedian);
+        }
+    }
+}
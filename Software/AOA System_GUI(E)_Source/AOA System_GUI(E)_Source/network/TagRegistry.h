@@ -0,0 +1,150 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: TagRegistry.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef TAGREGISTRY_H
+#define TAGREGISTRY_H
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "PositionFilter.h"
+
+#define HIS_LENGTH 100
+#define FILTER_SIZE 25/*10*/  //default motion filter window, see setFilterWindow(); NOTE: filter size needs to be > 2
+
+/**
+* @brief tag_info_t
+*        the tag's addresses and its configuration in the node
+*/
+typedef struct
+{
+    quint64 id64;
+    int     id16;
+    short   multFast;
+    short   multSlow;
+    short   Mode;
+    bool    ready;
+    bool    used;   //the slot holds a tag
+} tag_info_t;
+
+/**
+* @brief tag_history_t
+*        the tag's location history
+*/
+typedef struct
+{
+    double x_arr[HIS_LENGTH]; //array containing history of x coordinates
+    double y_arr[HIS_LENGTH]; //array containing history of y coordinates
+
+    int arr_idx;
+    int count;
+    int filterReady;
+} tag_history_t;
+
+/**
+* @brief tag_filter_t
+*        the tag's position filter and its last input/output (for the jitter statistics)
+*/
+typedef struct
+{
+    QSharedPointer<PositionFilter> filter; //NULL if the position is not filtered
+
+    bool   hasLast;
+    double inX, inY;        //last reported position
+    double outX, outY;      //last filtered position
+} tag_filter_t;
+
+/**
+* @brief TagRegistry
+*        The RTLS client's list of tags, indexed by both the 64-bit and the 16-bit address so that the
+*        per-report lookup does not depend on the number of tags.
+*
+*        The per-tag state is kept as a structure of arrays (info, history, filter) indexed by the tag's slot,
+*        and is updated in place through the references returned by info(), history() and filter(),
+*        so a report only touches the parts it updates. A tag keeps its slot until it is removed,
+*        removed slots are reused by the next insert().
+*
+*        A 64-bit address is only held once: inserting a tag which is already known resets its slot.
+*        A 16-bit address is only held by one tag: the node may re-assign an address when it sees a conflict,
+*        so giving a tag an address already held by another tag clears the other tag's address (-1, unknown)
+*        until the node tells us its new one.
+*/
+class TagRegistry
+{
+public:
+    TagRegistry();
+
+    int count(void) const { return _by64.size(); } //number of tags
+
+    /**
+     * @return the slot of the tag with the given address, -1 if not known
+     */
+    int indexOf64(quint64 id64) const { return _by64.value(id64, -1); }
+    int indexOf16(int id16) const { return _by16.value(id16, -1); }
+
+    tag_info_t &info(int index) { return _info[index]; }
+    const tag_info_t &info(int index) const { return _info.at(index); }
+    tag_history_t &history(int index) { return _history[index]; }
+    tag_filter_t &filter(int index) { return _filter[index]; }
+
+    /**
+     * Add the tag with the given addresses, or reset the slot of the tag if it is known already.
+     * The history and the filter state are cleared, the rest of the info is left to the caller.
+     * @return the slot of the tag
+     */
+    int insert(quint64 id64, int id16);
+
+    /**
+     * Set the 16-bit address of the tag at \a index, clearing it from any other tag holding it.
+     */
+    void setId16(int index, int id16);
+
+    /**
+     * Remove the tag with the given 64-bit address.
+     * @return false if the tag is not known
+     */
+    bool remove(quint64 id64);
+
+    void clear(void);
+
+    /**
+     * Set the position filter (PositionFilterType) of the tag at \a index, this clears its filter state.
+     */
+    void setFilterType(int index, int type);
+
+    /**
+     * Set the position filter of all the tags, and of the tags added later.
+     */
+    void setFilterType(int type);
+    int filterType(void) const { return _filterType; }
+
+    /**
+     * Set the median filter window of all the tags (and of the tags added later), this clears their filter state.
+     */
+    void setFilterWindow(int window);
+    int filterWindow(void) const { return _filterWindow; }
+
+private:
+    QVector<tag_info_t>    _info;
+    QVector<tag_history_t> _history;
+    QVector<tag_filter_t>  _filter;
+    QVector<int>           _free;   //slots of removed tags
+
+    QHash<quint64, int>    _by64;   //64-bit address -> slot
+    QHash<int, int>        _by16;   //16-bit address -> slot, tags with id16 of -1 are not indexed
+
+    int _filterType;
+    int _filterWindow;
+};
+
+#endif // TAGREGISTRY_H
@@ -0,0 +1,379 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: AnchorSimulator.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "AnchorSimulator.h"
+
+#include "PtyPort.h"
+#include "JsFrameDecoder.h"
+
+#include <QStringList>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+AnchorSimulator::AnchorSimulator(PtyPort *port, const sim_config_t &config, QObject *parent) :
+    QObject(parent),
+    _port(port),
+    _config(config),
+    _random(config.seed),
+    _streaming(false),
+    _binary(false),
+    _due(0),
+    _next(0),
+    _frames(0),
+    _bytes(0),
+    _dropped(0),
+    _overruns(0)
+{
+    //spread the tags over the area in front of the node: X -4..4 m, Y 1..9 m
+    _tags.resize(qBound(1, _config.tags, SIM_MAX_TAGS));
+
+    for(int i = 0; i < _tags.size(); i++)
+    {
+        sim_tag_t &tag = _tags[i];
+
+        tag.id64 = 0xDECA000000000000ULL | (quint64)i;
+        tag.id16 = SIM_ADDR16_BASE + i;
+        tag.rangeNum = 0;
+        tag.cx = -4.0 + 8.0 * _random.generateDouble();
+        tag.cy = 1.0 + 8.0 * _random.generateDouble();
+        tag.radius = 0.5 + 1.5 * _random.generateDouble();
+        tag.speed = 0.5 + 1.0 * _random.generateDouble();
+        tag.phase = 2 * M_PI * _random.generateDouble();
+        tag.x = tag.cx;
+        tag.y = tag.cy;
+        tag.clockOffset = _random.bounded(-500, 500);
+    }
+
+    connect(_port, SIGNAL(dataReceived(QByteArray)), this, SLOT(dataReceived(QByteArray)));
+
+    _timer.setTimerType(Qt::PreciseTimer);
+    connect(&_timer, SIGNAL(timeout()), this, SLOT(tick()));
+    _timer.start(SIM_TICK_MS);
+
+    _statsClock.start();
+}
+
+/**
+* @brief pathType()
+*        return the SimPath of the name given on the command line, or -1
+* */
+int AnchorSimulator::pathType(const QString &name)
+{
+    return QStringList({"static", "circle", "line", "walk"}).indexOf(name);
+}
+
+/**
+* @brief gauss()
+*        normally distributed noise (Box-Muller)
+* */
+double AnchorSimulator::gauss(double sigma)
+{
+    double u1 = 1.0 - _random.generateDouble(); //(0, 1]
+    double u2 = _random.generateDouble();
+
+    if(sigma <= 0)
+    {
+        return 0;
+    }
+
+    return sigma * sqrt(-2.0 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+void AnchorSimulator::dataReceived(const QByteArray &data)
+{
+    for(int i = 0; i < data.size(); i++)
+    {
+        char c = data.at(i);
+
+        if((c == '\r') || (c == '\n'))
+        {
+            if(!_cmd.isEmpty())
+            {
+                command(_cmd.trimmed().toLower());
+                _cmd.clear();
+            }
+        }
+        else if(_cmd.size() < 256)
+        {
+            _cmd.append(c);
+        }
+    }
+}
+
+/**
+* @brief command()
+*        the commands the viewer sends, anything else (save, pdoaoff, rngoff, ...) is accepted and ignored
+* */
+void AnchorSimulator::command(const QByteArray &cmd)
+{
+    if(_config.verbose)
+    {
+        fprintf(stderr, "cmd: %s\n", cmd.constData());
+    }
+
+    if(cmd == "deca$")
+    {
+        _binary = false;
+        sendInfo();
+
+        if(!_streaming)
+        {
+            _streaming = true;
+            _due = 0;
+            _clock.start();
+        }
+    }
+    else if((cmd == "getklist") || (cmd == "getlist"))
+    {
+        sendKList();
+    }
+    else if(cmd == "getdlist")
+    {
+        sendDList();
+    }
+    else if(cmd.startsWith("setbin"))
+    {
+        _binary = _config.binary && (cmd.mid(6).trimmed().toInt() == SIM_BIN_VERSION);
+    }
+    else if(cmd == "stop")
+    {
+        _streaming = false;
+    }
+
+    flush();
+}
+
+void AnchorSimulator::sendFrame(const QByteArray &json)
+{
+    char header[JS_HEADER_LEN + 1];
+
+    snprintf(header, sizeof(header), "JS%04X", json.size());
+
+    _out.append(header, JS_HEADER_LEN);
+    _out.append(json);
+}
+
+void AnchorSimulator::sendInfo(void)
+{
+    QByteArray info = QString("{\"Info\":{\"Device\":\"PDOA Node\",\"Version\":\"%1\",\"Build\":\"%2\",\"Driver\":\"sim\"%3}}")
+                      .arg(SIM_VERSION)
+                      .arg(__DATE__)
+                      .arg(_config.binary ? QString(",\"Bin\":%1").arg(SIM_BIN_VERSION) : QString())
+                      .toLatin1();
+
+    sendFrame(info);
+}
+
+void AnchorSimulator::sendKList(void)
+{
+    for(int first = 0; first < _tags.size(); first += SIM_KLIST_BATCH)
+    {
+        QByteArray list = "{\"KList\":[";
+
+        for(int i = first; (i < _tags.size()) && (i < first + SIM_KLIST_BATCH); i++)
+        {
+            const sim_tag_t &tag = _tags.at(i);
+            char entry[128];
+
+            snprintf(entry, sizeof(entry), "%s{\"slot\":\"%04X\",\"a64\":\"%016llX\",\"a16\":\"%04X\",\"F\":\"1\",\"S\":\"10\",\"M\":\"%X\"}",
+                     (i != first) ? "," : "", i, (unsigned long long)tag.id64, tag.id16, (_config.path == PathStatic) ? 0 : 1);
+
+            list.append(entry);
+        }
+
+        list.append("]}");
+
+        sendFrame(list);
+    }
+}
+
+void AnchorSimulator::sendDList(void)
+{
+    //all the simulated tags are known, none is waiting to be added
+    sendFrame("{\"DList\":[]}");
+}
+
+/**
+* @brief report()
+*        the range report of \a tag at the time \a t (s), the node measures the range and the angle,
+*        so that is where the noise goes
+* */
+void AnchorSimulator::report(sim_tag_t &tag, double t)
+{
+    double x, y;
+
+    switch(_config.path)
+    {
+        case PathCircle:
+        {
+            double a = tag.phase + t * tag.speed / tag.radius;
+            x = tag.cx + tag.radius * cos(a);
+            y = tag.cy + tag.radius * sin(a);
+        }
+        break;
+
+        case PathLine:
+        {
+            //triangle wave of amplitude radius
+            double s = fmod(t * tag.speed / tag.radius + tag.phase, 4.0);
+            x = tag.cx + tag.radius * ((s < 2.0) ? (s - 1.0) : (3.0 - s));
+            y = tag.cy;
+        }
+        break;
+
+        case PathWalk:
+        {
+            double step = tag.speed / qMax(_config.rate, 0.1);
+            tag.x = qBound(-5.0, tag.x + gauss(step), 5.0);
+            tag.y = qBound(0.5, tag.y + gauss(step), 10.0);
+            x = tag.x;
+            y = tag.y;
+        }
+        break;
+
+        case PathStatic:
+        default:
+            x = tag.cx;
+            y = tag.cy;
+        break;
+    }
+
+    tag.rangeNum++;
+
+    if((_config.dropout > 0) && (_random.generateDouble() < _config.dropout))
+    {
+        _dropped++;
+        return;
+    }
+
+    if(_out.size() > SIM_OUT_MAX)
+    {
+        _overruns++;
+        return;
+    }
+
+    double range_cm = qMax(0.0, sqrt(x * x + y * y) * 100 + gauss(_config.noise_cm));
+    double aoa = atan2(x, y) + gauss(_config.noise_deg) * M_PI / 180;
+
+    jb_twr_t twr;
+
+    twr.type = JB_TYPE_TWR;
+    twr.addr16 = tag.id16;
+    twr.rangeNum = tag.rangeNum;
+    twr.resTime_us = (uint32_t)((qint64)(t * 1e6) % 100000);
+    twr.dist_cm = (int32_t)range_cm;
+    twr.pdoa_deg = (int16_t)(180 * sin(aoa)); //antennas half a wavelength apart
+    twr.xdist_cm = (int32_t)(range_cm * sin(aoa));
+    twr.ydist_cm = (int32_t)(range_cm * cos(aoa));
+    twr.clockOffset = tag.clockOffset;
+    twr.vData = (_config.path == PathStatic) ? 1 : 0; //bit 0: stationary
+    twr.accX = 0;
+    twr.accY = 0;
+    twr.accZ = 1000;
+
+    if(_binary)
+    {
+        char frame[JB_HEADER_LEN + sizeof(jb_twr_t) + JB_CRC_LEN];
+        uint16_t crc;
+
+        frame[0] = 'J';
+        frame[1] = 'B';
+        frame[2] = sizeof(jb_twr_t);
+        memcpy(frame + JB_HEADER_LEN, &twr, sizeof(jb_twr_t));
+
+        crc = JsFrameDecoder::crc16(frame + 2, sizeof(jb_twr_t) + 1);
+        frame[JB_HEADER_LEN + sizeof(jb_twr_t)] = crc & 0xFF;
+        frame[JB_HEADER_LEN + sizeof(jb_twr_t) + 1] = crc >> 8;
+
+        _out.append(frame, sizeof(frame));
+    }
+    else
+    {
+        char json[256];
+        int length = snprintf(json, sizeof(json),
+                              "{\"TWR\": {\"a16\":\"%04X\",\"R\":%u,\"T\":%u,\"D\":%d,\"P\":%d,\"Xcm\":%d,\"Ycm\":%d,"
+                              "\"O\":%d,\"V\":%u,\"X\":%d,\"Y\":%d,\"Z\":%d}}",
+                              twr.addr16, twr.rangeNum, twr.resTime_us, twr.dist_cm, twr.pdoa_deg,
+                              twr.xdist_cm, twr.ydist_cm, twr.clockOffset, twr.vData, twr.accX, twr.accY, twr.accZ);
+
+        sendFrame(QByteArray::fromRawData(json, length));
+    }
+
+    _frames++;
+}
+
+/**
+* @brief tick()
+*        generate the reports which are due since the last tick, round robin over the tags,
+*        so each tag reports at the configured rate
+* */
+void AnchorSimulator::tick(void)
+{
+    if(_streaming)
+    {
+        double t = _clock.nsecsElapsed() / 1e9;
+        quint64 due = (quint64)(t * _config.rate * _tags.size());
+
+        for(; _due < due; _due++)
+        {
+            report(_tags[_next], t);
+
+            if(++_next == _tags.size())
+            {
+                _next = 0;
+            }
+        }
+    }
+
+    flush();
+
+    if(_statsClock.elapsed() >= 1000)
+    {
+        printStats();
+    }
+}
+
+void AnchorSimulator::flush(void)
+{
+    while(!_out.isEmpty())
+    {
+        int written = _port->write(_out.constData(), _out.size());
+
+        if(written <= 0)
+        {
+            break;
+        }
+
+        _bytes += written;
+        _out.remove(0, written);
+    }
+}
+
+/**
+* @brief printStats()
+*        reports/s generated and kB/s taken by the viewer, reports lost to the dropout and to overruns
+* */
+void AnchorSimulator::printStats(void)
+{
+    double s = qMax((qint64)1, _statsClock.restart()) / 1000.0;
+
+    fprintf(stderr, "%d tags %s: %.0f reports/s %.1f kB/s dropout %llu overrun %llu pending %d bytes\n",
+            _tags.size(), _binary ? "bin" : "json",
+            _frames / s, _bytes / s / 1024,
+            (unsigned long long)_dropped, (unsigned long long)_overruns, _out.size());
+
+    _frames = 0;
+    _bytes = 0;
+    _dropped = 0;
+    _overruns = 0;
+}
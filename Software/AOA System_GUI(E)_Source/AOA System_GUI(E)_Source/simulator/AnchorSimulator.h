@@ -0,0 +1,121 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: AnchorSimulator.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef ANCHORSIMULATOR_H
+#define ANCHORSIMULATOR_H
+
+#include <QObject>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+class PtyPort;
+
+#define SIM_TICK_MS         (5)         //reports are generated in batches every tick
+#define SIM_OUT_MAX         (65536)     //bytes waiting for the viewer before new reports are dropped (overrun)
+#define SIM_KLIST_BATCH     (100)       //tags per KList frame, so a frame fits in the 4 hex digit length
+#define SIM_ADDR16_BASE     (0x1000)    //addr16 of the 1st tag (the viewer parses it as a signed short)
+#define SIM_MAX_TAGS        (0x7000)
+#define SIM_VERSION         ("3.1-sim")
+#define SIM_BIN_VERSION     (1)         //binary report format advertised (BIN_REPORT_VERSION of the viewer)
+
+enum SimPath
+{
+    PathStatic = 0,     //tags stay where they are (stationary bit set)
+    PathCircle,         //circles around their starting point
+    PathLine,           //back and forth along the X axis
+    PathWalk,           //random walk
+    PathTypes
+};
+
+typedef struct
+{
+    int     tags;
+    double  rate;       //reports per second per tag
+    double  noise_cm;   //range noise (standard deviation)
+    double  noise_deg;  //angle noise (standard deviation)
+    double  dropout;    //probability of a report being lost (0..1)
+    int     path;       //SimPath
+    bool    binary;     //advertise the binary reports in the Info object
+    quint32 seed;
+    bool    verbose;    //print the commands received from the viewer
+} sim_config_t;
+
+typedef struct
+{
+    quint64 id64;
+    quint16 id16;
+    quint16 rangeNum;
+    double  cx, cy;     //starting point w.r.t. the node, m
+    double  radius;     //m
+    double  speed;      //m/s
+    double  phase;      //rad
+    double  x, y;       //random walk position, m
+    int     clockOffset;//1/100 ppm
+} sim_tag_t;
+
+/**
+* @brief AnchorSimulator
+*        Plays the part of a PDOA node on a pseudo-terminal: answers "deca$" with the Info object, "getKList" and
+*        "getDlist" with the tag lists, and streams a TWR report per tag at the configured rate, in JSON ('JSxxxx{...}')
+*        or, once the viewer has sent "setbin 1", as binary 'JB' frames.
+*        The throughput (frames and bytes sent, reports lost to dropouts and to overruns) is printed once a second.
+*/
+class AnchorSimulator : public QObject
+{
+    Q_OBJECT
+public:
+    AnchorSimulator(PtyPort *port, const sim_config_t &config, QObject *parent = 0);
+
+    static int pathType(const QString &name);
+
+public slots:
+    void printStats(void);
+
+private slots:
+    void dataReceived(const QByteArray &data);
+    void tick(void);
+
+private:
+    void command(const QByteArray &cmd);
+    void sendFrame(const QByteArray &json);
+    void sendInfo(void);
+    void sendKList(void);
+    void sendDList(void);
+    void report(sim_tag_t &tag, double t);
+    void flush(void);
+    double gauss(double sigma);
+
+    PtyPort *_port;
+    sim_config_t _config;
+    QVector<sim_tag_t> _tags;
+    QRandomGenerator _random;
+
+    QByteArray _cmd;        //command being received
+    QByteArray _out;        //bytes the terminal has not taken yet
+
+    QTimer _timer;
+    QElapsedTimer _clock;
+    QElapsedTimer _statsClock;
+    bool _streaming;
+    bool _binary;           //the viewer has switched to the binary reports
+    quint64 _due;           //reports generated since streaming started
+    int _next;              //next tag to report (round robin)
+
+    quint64 _frames;        //since the last statistics
+    quint64 _bytes;
+    quint64 _dropped;       //dropout
+    quint64 _overruns;      //the viewer did not keep up
+};
+
+#endif // ANCHORSIMULATOR_H
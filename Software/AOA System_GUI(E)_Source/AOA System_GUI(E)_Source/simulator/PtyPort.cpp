@@ -0,0 +1,144 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: PtyPort.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "PtyPort.h"
+
+#include <QSocketNotifier>
+#include <QFile>
+#include <QDebug>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+PtyPort::PtyPort(QObject *parent) :
+    QObject(parent),
+    _master(-1),
+    _slave(-1),
+    _notifier(NULL)
+{
+}
+
+PtyPort::~PtyPort()
+{
+    close();
+}
+
+/**
+* @brief open()
+*        create the pseudo-terminal in raw mode, optionally with a symbolic link (e.g. /tmp/ttyDECA) to its slave
+* */
+bool PtyPort::open(const QString &link)
+{
+    struct termios tio;
+
+    close();
+
+    _master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if((_master < 0) || (grantpt(_master) != 0) || (unlockpt(_master) != 0))
+    {
+        qWarning() << "pty:" << strerror(errno);
+        close();
+        return false;
+    }
+
+    _slaveName = QString::fromLocal8Bit(ptsname(_master));
+    _slave = ::open(ptsname(_master), O_RDWR | O_NOCTTY);
+
+    if(_slave < 0)
+    {
+        qWarning() << "pty:" << _slaveName << strerror(errno);
+        close();
+        return false;
+    }
+
+    //no echo or line editing, the viewer's serial port would set the same
+    if(tcgetattr(_slave, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(_slave, TCSANOW, &tio);
+    }
+
+    fcntl(_master, F_SETFL, fcntl(_master, F_GETFL) | O_NONBLOCK);
+
+    if(!link.isEmpty())
+    {
+        QFile::remove(link);
+
+        if(QFile::link(_slaveName, link))
+        {
+            _link = link;
+        }
+        else
+        {
+            qWarning() << "pty: cannot create" << link;
+        }
+    }
+
+    _notifier = new QSocketNotifier(_master, QSocketNotifier::Read, this);
+    connect(_notifier, SIGNAL(activated(int)), this, SLOT(readData()));
+
+    return true;
+}
+
+void PtyPort::close(void)
+{
+    delete _notifier;
+    _notifier = NULL;
+
+    if(_slave >= 0)
+    {
+        ::close(_slave);
+        _slave = -1;
+    }
+
+    if(_master >= 0)
+    {
+        ::close(_master);
+        _master = -1;
+    }
+
+    if(!_link.isEmpty())
+    {
+        QFile::remove(_link);
+        _link.clear();
+    }
+}
+
+int PtyPort::write(const char *data, int length)
+{
+    ssize_t written;
+
+    if(_master < 0)
+    {
+        return 0;
+    }
+
+    written = ::write(_master, data, length);
+
+    return (written > 0) ? (int)written : 0;
+}
+
+void PtyPort::readData(void)
+{
+    char buf[256];
+    ssize_t length;
+
+    while((length = ::read(_master, buf, sizeof(buf))) > 0)
+    {
+        emit dataReceived(QByteArray(buf, (int)length));
+    }
+}
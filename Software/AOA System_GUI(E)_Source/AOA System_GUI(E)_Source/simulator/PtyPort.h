@@ -0,0 +1,55 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: PtyPort.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef PTYPORT_H
+#define PTYPORT_H
+
+#include <QObject>
+#include <QByteArray>
+
+class QSocketNotifier;
+
+/**
+* @brief PtyPort
+*        The master side of a pseudo-terminal, the viewer opens the slave side (slaveName()) as its serial port.
+*        The slave is kept open here too, so the master does not report errors while the viewer is not connected.
+*        Writes never block: write() returns how much the terminal has accepted.
+*/
+class PtyPort : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PtyPort(QObject *parent = 0);
+    ~PtyPort();
+
+    bool open(const QString &link = QString());
+    void close(void);
+
+    QString slaveName(void) const { return _slaveName; }
+
+    int write(const char *data, int length);
+
+signals:
+    void dataReceived(const QByteArray &data);
+
+private slots:
+    void readData(void);
+
+private:
+    int _master;
+    int _slave;
+    QString _slaveName;
+    QString _link;          //symbolic link to the slave, removed on close
+    QSocketNotifier *_notifier;
+};
+
+#endif // PTYPORT_H
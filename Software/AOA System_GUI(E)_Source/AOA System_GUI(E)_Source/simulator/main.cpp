@@ -0,0 +1,98 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: main.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "PtyPort.h"
+#include "AnchorSimulator.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTimer>
+#include <stdio.h>
+
+/**
+* @brief the simulator main entry point
+*        rtlssim --tags 500 --rate 10 --path circle --link /tmp/ttyDECA
+*        then connect the viewer (or rtlsheadless --port /tmp/ttyDECA) to the printed pseudo-terminal
+*        the viewer's CPU use (Diagnostics window) at rtlssim --tags 200 --rate 10, with and without
+*        "Coalesce per frame" (debug build), is the reference load of the frame paced tag updates
+*/
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    app.setApplicationName("rtlssim");
+
+    QCommandLineParser parser;
+    QCommandLineOption tagsOption("tags", "Number of simulated tags.", "n", "10");
+    QCommandLineOption rateOption("rate", "Reports per second per tag.", "hz", "10");
+    QCommandLineOption noiseOption("noise", "Range noise, standard deviation in cm.", "cm", "5");
+    QCommandLineOption angleNoiseOption("angle-noise", "Angle noise, standard deviation in degrees.", "deg", "2");
+    QCommandLineOption dropoutOption("dropout", "Probability of a report being lost (0..1).", "p", "0");
+    QCommandLineOption pathOption("path", "Motion path: static, circle, line or walk.", "path", "circle");
+    QCommandLineOption binaryOption("binary", "Advertise the binary reports, the viewer switches to them.");
+    QCommandLineOption seedOption("seed", "Random seed.", "n", "1");
+    QCommandLineOption linkOption("link", "Create a symbolic link to the pseudo-terminal (e.g. /tmp/ttyDECA).", "path");
+    QCommandLineOption durationOption("duration", "Quit after this many seconds (0 = run until killed).", "s", "0");
+    QCommandLineOption verboseOption("verbose", "Print the commands received from the viewer.");
+
+    parser.setApplicationDescription("Virtual PDOA node streaming TWR reports over a pseudo-terminal.");
+    parser.addHelpOption();
+    parser.addOption(tagsOption);
+    parser.addOption(rateOption);
+    parser.addOption(noiseOption);
+    parser.addOption(angleNoiseOption);
+    parser.addOption(dropoutOption);
+    parser.addOption(pathOption);
+    parser.addOption(binaryOption);
+    parser.addOption(seedOption);
+    parser.addOption(linkOption);
+    parser.addOption(durationOption);
+    parser.addOption(verboseOption);
+    parser.process(app);
+
+    sim_config_t config;
+
+    config.tags = parser.value(tagsOption).toInt();
+    config.rate = parser.value(rateOption).toDouble();
+    config.noise_cm = parser.value(noiseOption).toDouble();
+    config.noise_deg = parser.value(angleNoiseOption).toDouble();
+    config.dropout = parser.value(dropoutOption).toDouble();
+    config.path = AnchorSimulator::pathType(parser.value(pathOption));
+    config.binary = parser.isSet(binaryOption);
+    config.seed = parser.value(seedOption).toUInt();
+    config.verbose = parser.isSet(verboseOption);
+
+    if((config.tags < 1) || (config.tags > SIM_MAX_TAGS) || (config.rate <= 0) || (config.path < 0))
+    {
+        fprintf(stderr, "invalid --tags, --rate or --path\n");
+        parser.showHelp(1);
+    }
+
+    PtyPort port;
+
+    if(!port.open(parser.value(linkOption)))
+    {
+        return 1;
+    }
+
+    printf("%s\n", qPrintable(parser.isSet(linkOption) ? parser.value(linkOption) : port.slaveName()));
+    fflush(stdout);
+
+    AnchorSimulator simulator(&port, config);
+
+    if(parser.value(durationOption).toDouble() > 0)
+    {
+        QTimer::singleShot((int)(parser.value(durationOption).toDouble() * 1000), &app, SLOT(quit()));
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# Virtual PDOA node: answers the viewer's commands and streams simulated
+# TWR reports for any number of tags over a pseudo-terminal (Linux/macOS)
+#
+#-------------------------------------------------
+
+QT       = core
+
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TARGET = rtlssim
+TEMPLATE = app
+
+#the binary report layout and its CRC are shared with the viewer
+INCLUDEPATH += ../network
+
+SOURCES += main.cpp \
+    PtyPort.cpp \
+    AnchorSimulator.cpp \
+    ../network/JsFrameDecoder.cpp
+
+HEADERS += \
+    PtyPort.h \
+    AnchorSimulator.h \
+    ../network/JsFrameDecoder.h
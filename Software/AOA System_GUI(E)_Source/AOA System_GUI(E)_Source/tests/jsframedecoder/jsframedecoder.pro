@@ -0,0 +1,17 @@
+#-------------------------------------------------
+#
+# JsFrameDecoder unit tests: split, concatenated and corrupted JS/JB streams
+#
+#-------------------------------------------------
+
+QT       = core serialport testlib
+
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TARGET = tst_jsframedecoder
+TEMPLATE = app
+
+include(../../core.pri)
+
+SOURCES += tst_jsframedecoder.cpp
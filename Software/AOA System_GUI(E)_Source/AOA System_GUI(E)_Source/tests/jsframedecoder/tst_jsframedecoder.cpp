@@ -0,0 +1,443 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: tst_jsframedecoder.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "JsFrameDecoder.h"
+
+#include <QtTest>
+
+//a report as printed by the node
+#define TWR_OBJECT  "{\"TWR\": {\"a16\":\"2E5C\",\"R\":3,\"T\":8605,\"D\":343,\"P\":1695,\"Xcm\":165,\"Ycm\":165,\"O\":14,\"V\":1,\"X\":53015,\"Y\":60972,\"Z\":10797}}"
+
+/**
+* @brief jsFrame()
+*        'JSxxxx{...}' frame of the JSON object
+* */
+static QByteArray jsFrame(const QByteArray &object)
+{
+    return "JS" + QByteArray::number(object.size(), 16).rightJustified(4, '0').toUpper() + object;
+}
+
+/**
+* @brief jbFrame()
+*        'JBn...' frame of the payload with its CRC
+* */
+static QByteArray jbFrame(const QByteArray &payload)
+{
+    QByteArray frame = "JB";
+    uint16_t crc;
+
+    frame.append((char)payload.size());
+    frame.append(payload);
+
+    crc = JsFrameDecoder::crc16(frame.constData() + 2, payload.size() + 1);
+
+    frame.append((char)(crc & 0xFF));
+    frame.append((char)(crc >> 8));
+
+    return frame;
+}
+
+static QByteArray twrPayload(quint16 addr16, quint16 rangeNum)
+{
+    jb_twr_t twr;
+
+    memset(&twr, 0, sizeof(twr));
+    twr.type = JB_TYPE_TWR;
+    twr.addr16 = addr16;
+    twr.rangeNum = rangeNum;
+    twr.dist_cm = 343;
+    twr.pdoa_deg = -17;
+
+    return QByteArray((const char *)&twr, sizeof(twr));
+}
+
+/**
+* @brief drain()
+*        all the frames the decoder has, as "type:payload"
+* */
+static QList<QByteArray> drain(JsFrameDecoder *decoder)
+{
+    QList<QByteArray> frames;
+    js_frame_t frame;
+
+    while(decoder->next(&frame))
+    {
+        frames.append(QByteArray::number(frame.type) + ":" + QByteArray(frame.data, frame.length));
+    }
+
+    return frames;
+}
+
+static QByteArray json(const QByteArray &object)
+{
+    return QByteArray::number(JS_FRAME_JSON) + ":" + object;
+}
+
+static QByteArray bin(const QByteArray &payload)
+{
+    return QByteArray::number(JS_FRAME_BIN) + ":" + payload;
+}
+
+class TestJsFrameDecoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void singleFrame();
+    void splitAtEveryOffset();
+    void concatenatedFrames();
+    void garbageAndFalseHeaders();
+    void corruptLength();
+    void binaryBadCrc();
+    void compaction();
+    void bufferFull();
+    void burstLargerThanBuffer();
+    void twrReport();
+};
+
+void TestJsFrameDecoder::singleFrame()
+{
+    JsFrameDecoder decoder;
+
+    decoder.append(jsFrame(TWR_OBJECT).constData(), jsFrame(TWR_OBJECT).size());
+
+    QCOMPARE(drain(&decoder), QList<QByteArray>() << json(TWR_OBJECT));
+    QCOMPARE(decoder.pending(), 0);
+    QCOMPARE(decoder.skippedBytes(), 0u);
+}
+
+/**
+* @brief splitAtEveryOffset()
+*        a JSON and a binary frame in two reads, cut at every byte
+* */
+void TestJsFrameDecoder::splitAtEveryOffset()
+{
+    QByteArray payload = twrPayload(0x2E5C, 3);
+    QByteArray stream = jsFrame(TWR_OBJECT) + jbFrame(payload) + jsFrame("{\"a\":1}");
+    QList<QByteArray> expected;
+
+    expected << json(TWR_OBJECT) << bin(payload) << json("{\"a\":1}");
+
+    for(int cut = 0; cut <= stream.size(); cut++)
+    {
+        JsFrameDecoder decoder;
+        QList<QByteArray> frames;
+
+        decoder.append(stream.constData(), cut);
+        frames = drain(&decoder);
+        decoder.append(stream.constData() + cut, stream.size() - cut);
+        frames += drain(&decoder);
+
+        QVERIFY2(frames == expected, qPrintable(QString("cut at %1").arg(cut)));
+        QCOMPARE(decoder.pending(), 0);
+        QCOMPARE(decoder.skippedBytes(), 0u);
+    }
+
+    //and one byte at a time
+    JsFrameDecoder decoder;
+    QList<QByteArray> frames;
+
+    for(int i = 0; i < stream.size(); i++)
+    {
+        decoder.append(stream.constData() + i, 1);
+        frames += drain(&decoder);
+    }
+
+    QCOMPARE(frames, expected);
+}
+
+void TestJsFrameDecoder::concatenatedFrames()
+{
+    JsFrameDecoder decoder;
+    QByteArray stream;
+    QList<QByteArray> expected;
+
+    for(int i = 0; i < 50; i++)
+    {
+        QByteArray object = "{\"TWR\": {\"a16\":\"2E5C\",\"R\":" + QByteArray::number(i) + "}}";
+        QByteArray payload = twrPayload(0x1000 + i, i);
+
+        stream += jsFrame(object) + jbFrame(payload);
+        expected << json(object) << bin(payload);
+    }
+
+    decoder.append(stream.constData(), stream.size());
+
+    QCOMPARE(drain(&decoder), expected);
+    QCOMPARE(decoder.pending(), 0);
+}
+
+/**
+* @brief garbageAndFalseHeaders()
+*        bytes in front of the frame, and 'JS'/'JB' which are not frame headers
+* */
+void TestJsFrameDecoder::garbageAndFalseHeaders()
+{
+    JsFrameDecoder decoder;
+    QByteArray payload = twrPayload(0x2E5C, 3);
+    QByteArray garbage;
+
+    garbage += "node reset\r\n";        //no header at all
+    garbage += "JJ";                    //'J' followed by anything but 'S'/'B'
+    garbage += "JSzz12";                //length which is not hex
+    garbage += "JS0010x";               //object not starting with '{'
+    garbage += "JS0000{";               //empty object
+    garbage.append("JB\x00", 3);        //empty payload
+    garbage.append("JB\xFF", 3);        //payload longer than JB_MAX_PAYLOAD_LEN
+
+    QByteArray stream = garbage + jsFrame(TWR_OBJECT) + "trailing" + jbFrame(payload);
+
+    decoder.append(stream.constData(), stream.size());
+
+    QCOMPARE(drain(&decoder), QList<QByteArray>() << json(TWR_OBJECT) << bin(payload));
+    QCOMPARE(decoder.skippedBytes(), (uint32_t)(garbage.size() + 8));
+    QCOMPARE(decoder.crcErrors(), 0u);
+}
+
+/**
+* @brief corruptLength()
+*        a header whose length is far too big must not hold up the frames which follow it
+* */
+void TestJsFrameDecoder::corruptLength()
+{
+    JsFrameDecoder decoder;
+    QByteArray payload = twrPayload(0x2E5C, 3);
+    QByteArray stream = QByteArray("JSFFFF{\"TWR\": {\"a1") + jsFrame(TWR_OBJECT) + jbFrame(payload);
+
+    decoder.append(stream.constData(), stream.size());
+
+    QCOMPARE(drain(&decoder), QList<QByteArray>() << json(TWR_OBJECT) << bin(payload));
+    QCOMPARE(decoder.pending(), 0);
+
+    //the same, with the next header coming in byte by byte
+    decoder.clear();
+
+    QList<QByteArray> frames;
+    QByteArray slow = QByteArray("JSFFFF{") + jbFrame(payload) + jsFrame(TWR_OBJECT);
+
+    for(int i = 0; i < slow.size(); i++)
+    {
+        decoder.append(slow.constData() + i, 1);
+        frames += drain(&decoder);
+    }
+
+    QCOMPARE(frames, QList<QByteArray>() << bin(payload) << json(TWR_OBJECT));
+
+    //a header which does not fit into the buffer at all
+    JsFrameDecoder small(256);
+    QByteArray big = QByteArray("JS0200{") + jsFrame(TWR_OBJECT);
+
+    small.append(big.constData(), big.size());
+
+    QCOMPARE(drain(&small), QList<QByteArray>() << json(TWR_OBJECT));
+}
+
+void TestJsFrameDecoder::binaryBadCrc()
+{
+    JsFrameDecoder decoder;
+    QByteArray good = twrPayload(0x1111, 1);
+    QByteArray bad = jbFrame(twrPayload(0x2222, 2));
+    QByteArray badCrc = jbFrame(twrPayload(0x3333, 3));
+
+    bad[10] = bad[10] ^ 0x01;           //flip a bit of the payload
+    badCrc[badCrc.size() - 1] = badCrc[badCrc.size() - 1] ^ 0x80;
+
+    QByteArray stream = bad + jbFrame(good) + badCrc + jsFrame(TWR_OBJECT);
+
+    decoder.append(stream.constData(), stream.size());
+
+    QCOMPARE(drain(&decoder), QList<QByteArray>() << bin(good) << json(TWR_OBJECT));
+    QCOMPARE(decoder.crcErrors(), 2u);
+    QCOMPARE(decoder.pending(), 0);
+}
+
+/**
+* @brief compaction()
+*        a small buffer filled through writePtr()/commit() as the serial port does, the frames straddle the point
+*        where the pending bytes are moved to the front
+* */
+void TestJsFrameDecoder::compaction()
+{
+    JsFrameDecoder decoder(200);
+    QByteArray stream;
+    QList<QByteArray> expected;
+    QList<QByteArray> frames;
+    int pos = 0;
+
+    for(int i = 0; i < 40; i++)
+    {
+        QByteArray object = "{\"R\":" + QByteArray::number(i) + ",\"pad\":\"" + QByteArray(i % 23, 'x') + "\"}";
+        QByteArray payload = twrPayload(i, i);
+
+        stream += jsFrame(object) + jbFrame(payload);
+        expected << json(object) << bin(payload);
+    }
+
+    while(pos < stream.size())
+    {
+        int space;
+        char *ptr = decoder.writePtr(&space);
+        int length = qMin(qMin(space, 37), stream.size() - pos);
+
+        QVERIFY(space > 0);
+
+        memcpy(ptr, stream.constData() + pos, length);
+        decoder.commit(length);
+        pos += length;
+
+        frames += drain(&decoder);
+    }
+
+    QCOMPARE(frames, expected);
+    QCOMPARE(decoder.droppedBytes(), 0u);
+
+    //the same through append()
+    decoder.clear();
+    frames.clear();
+
+    for(pos = 0; pos < stream.size(); pos += 53)
+    {
+        QCOMPARE(decoder.append(stream.constData() + pos, qMin(53, stream.size() - pos)), 0);
+        frames += drain(&decoder);
+    }
+
+    QCOMPARE(frames, expected);
+    QCOMPARE(decoder.droppedBytes(), 0u);
+}
+
+/**
+* @brief bufferFull()
+*        more bytes than the buffer holds without a frame: the oldest are dropped and counted,
+*        the frames which follow are still found
+* */
+void TestJsFrameDecoder::bufferFull()
+{
+    JsFrameDecoder decoder(128);
+    QByteArray waiting = QByteArray("JS0070{") + QByteArray(60, 'y');      //waits for a 0x70 byte object
+    QByteArray frame = jsFrame("{\"a\":1}");
+    int space;
+
+    QCOMPARE(decoder.append(waiting.constData(), waiting.size()), 0);
+    QCOMPARE(drain(&decoder).size(), 0);
+
+    //does not fit next to the pending bytes, the oldest go
+    QCOMPARE(decoder.append(waiting.constData(), waiting.size()), 2 * waiting.size() - 128);
+    QCOMPARE(decoder.pending(), 128);
+    QCOMPARE(decoder.droppedBytes(), (uint32_t)(2 * waiting.size() - 128));
+
+    QCOMPARE(decoder.append(frame.constData(), frame.size()), frame.size());
+    QCOMPARE(drain(&decoder), QList<QByteArray>() << json("{\"a\":1}"));
+
+    //a full buffer read through writePtr() drops the older half
+    decoder.clear();
+    decoder.append(QByteArray(128, 'z').constData(), 128);
+    QCOMPARE(decoder.pending(), 128);
+
+    QCOMPARE(drain(&decoder).size(), 0);
+    QCOMPARE(decoder.pending(), 0);     //no 'J' at all, skipped
+
+    decoder.append(waiting.constData(), waiting.size());
+    decoder.append(QByteArray(128 - waiting.size(), 'y').constData(), 128 - waiting.size());
+    QCOMPARE(decoder.pending(), 128);
+
+    decoder.writePtr(&space);
+    QCOMPARE(space, 64);
+
+    memcpy(decoder.writePtr(&space), frame.constData(), frame.size());
+    decoder.commit(frame.size());
+
+    QCOMPARE(drain(&decoder), QList<QByteArray>() << json("{\"a\":1}"));
+}
+
+/**
+* @brief burstLargerThanBuffer()
+*        more than the buffer holds waiting at once (e.g. the serial port after a stall), read as
+*        SerialConnection::readData() does: as much as fits each time, then the frames are taken out.
+*        No frame is lost; taking them out only at the end drops complete frames.
+* */
+void TestJsFrameDecoder::burstLargerThanBuffer()
+{
+    JsFrameDecoder decoder;
+    QByteArray stream;
+    QList<QByteArray> expected;
+    QList<QByteArray> frames;
+    int pos = 0;
+
+    for(int i = 0; stream.size() < 3 * decoder.capacity(); i++)
+    {
+        QByteArray object = "{\"TWR\": {\"a16\":\"" + QByteArray::number(0x1000 + (i % 200), 16).toUpper() +
+                            "\",\"R\":" + QByteArray::number(i) + ",\"D\":343,\"P\":1695}}";
+        QByteArray payload = twrPayload(0x1000 + (i % 200), i);
+
+        stream += jsFrame(object) + jbFrame(payload);
+        expected << json(object) << bin(payload);
+    }
+
+    while(pos < stream.size())
+    {
+        int space;
+        char *ptr = decoder.writePtr(&space);
+        int length = qMin(space, stream.size() - pos);
+
+        memcpy(ptr, stream.constData() + pos, length);
+        decoder.commit(length);
+        pos += length;
+
+        frames += drain(&decoder);
+    }
+
+    QCOMPARE(frames.size(), expected.size());
+    QCOMPARE(frames, expected);
+    QCOMPARE(decoder.droppedBytes(), 0u);
+    QCOMPARE(decoder.pending(), 0);
+
+    //the frames only taken out once everything has been read
+    decoder.clear();
+    frames.clear();
+
+    for(pos = 0; pos < stream.size(); )
+    {
+        int space;
+        char *ptr = decoder.writePtr(&space);
+        int length = qMin(space, stream.size() - pos);
+
+        memcpy(ptr, stream.constData() + pos, length);
+        decoder.commit(length);
+        pos += length;
+    }
+
+    frames = drain(&decoder);
+
+    QVERIFY(decoder.droppedBytes() > 0);
+    QVERIFY(frames.size() < expected.size());
+}
+
+void TestJsFrameDecoder::twrReport()
+{
+    QByteArray payload = twrPayload(0x2E5C, 3);
+    jb_twr_t twr;
+
+    QVERIFY(JsFrameDecoder::twrReport(payload.constData(), payload.size(), &twr));
+    QCOMPARE(twr.addr16, (uint16_t)0x2E5C);
+    QCOMPARE(twr.rangeNum, (uint16_t)3);
+    QCOMPARE(twr.dist_cm, 343);
+    QCOMPARE(twr.pdoa_deg, (int16_t)-17);
+
+    QVERIFY(!JsFrameDecoder::twrReport(payload.constData(), payload.size() - 1, &twr));
+
+    payload[0] = 0x7F;
+    QVERIFY(!JsFrameDecoder::twrReport(payload.constData(), payload.size(), &twr));
+}
+
+QTEST_APPLESS_MAIN(TestJsFrameDecoder)
+
+#include "tst_jsframedecoder.moc"
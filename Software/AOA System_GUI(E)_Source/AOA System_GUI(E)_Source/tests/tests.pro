@@ -0,0 +1,11 @@
+#-------------------------------------------------
+#
+# Unit tests and benchmarks of the RTLS core (QtTest), run with "make check"
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    jsframedecoder \
+    twrparser
@@ -0,0 +1,304 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: tst_twrparser.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "json_utils.h"
+#include "JsFrameDecoder.h"
+
+#include <QtTest>
+
+//range reports of four tags as the node prints them (the JSON object of the 'JSxxxx' frames)
+static const char *twrFrames[] =
+{
+    "{\"TWR\": {\"a16\":\"2E5C\",\"R\":3,\"T\":8605,\"D\":343,\"P\":1695,\"Xcm\":165,\"Ycm\":165,\"O\":14,\"V\":1,\"X\":53015,\"Y\":60972,\"Z\":10797}}",
+    "{\"TWR\": {\"a16\":\"0F21\",\"R\":118,\"T\":18344,\"D\":512,\"P\":-2210,\"Xcm\":-197,\"Ycm\":472,\"O\":-31,\"V\":0,\"X\":-458,\"Y\":-83,\"Z\":876}}",
+    "{\"TWR\": {\"a16\":\"C4A0\",\"R\":254,\"T\":28112,\"D\":1290,\"P\":402,\"Xcm\":90,\"Ycm\":1286,\"O\":7,\"V\":1,\"X\":12,\"Y\":-4,\"Z\":1003}}",
+    "{\"TWR\": {\"a16\":\"7FFF\",\"R\":65535,\"T\":38077,\"D\":88,\"P\":0,\"Xcm\":0,\"Ycm\":88,\"O\":0,\"V\":0,\"X\":0,\"Y\":0,\"Z\":0}}",
+    "{\"TWR\": {\"a16\":\"2E5C\",\"R\":4,\"T\":108605,\"D\":347,\"P\":1702,\"Xcm\":168,\"Ycm\":166,\"O\":15,\"V\":1,\"X\":53011,\"Y\":60970,\"Z\":10801}}",
+    "{\"TWR\": {\"a16\":\"0F21\",\"R\":119,\"T\":118344,\"D\":509,\"P\":-2198,\"Xcm\":-194,\"Ycm\":470,\"O\":-30,\"V\":0,\"X\":-455,\"Y\":-80,\"Z\":879}}",
+    "{\"TWR\": {\"a16\":\"C4A0\",\"R\":255,\"T\":128112,\"D\":1287,\"P\":398,\"Xcm\":89,\"Ycm\":1283,\"O\":7,\"V\":1,\"X\":10,\"Y\":-6,\"Z\":1001}}",
+    "{\"TWR\": {\"a16\":\"7FFF\",\"R\":0,\"T\":138077,\"D\":91,\"P\":-12,\"Xcm\":-2,\"Ycm\":91,\"O\":-1,\"V\":0,\"X\":1,\"Y\":-1,\"Z\":2}}"
+};
+
+#define TWR_FRAMES  (int)(sizeof(twrFrames) / sizeof(twrFrames[0]))
+
+static QByteArray twr(const char *fields)
+{
+    return QByteArray("{\"TWR\": {") + fields + "}}";
+}
+
+class TestTwrParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void identical_data();
+    void identical();
+    void fallback_data();
+    void fallback();
+    void notTwr_data();
+    void notTwr();
+    void binary_data();
+    void binary();
+    void benchmark_data();
+    void benchmark();
+};
+
+/**
+* @brief identical_data()
+*        frames the scanner handles, the result has to be what the QJsonDocument path gives
+* */
+void TestTwrParser::identical_data()
+{
+    QTest::addColumn<QByteArray>("frame");
+
+    for(int i = 0; i < TWR_FRAMES; i++)
+    {
+        QTest::newRow(qPrintable(QString("recorded %1").arg(i))) << QByteArray(twrFrames[i]);
+    }
+
+    //addr16 converted as QString::toShort(&ok, 16): 0 above SHRT_MAX
+    QTest::newRow("a16 SHRT_MAX") << twr("\"a16\":\"7FFF\",\"R\":1");
+    QTest::newRow("a16 SHRT_MAX + 1") << twr("\"a16\":\"8000\",\"R\":1");
+    QTest::newRow("a16 FFFF") << twr("\"a16\":\"FFFF\",\"R\":1");
+    QTest::newRow("a16 lower case") << twr("\"a16\":\"2e5c\",\"R\":1");
+    QTest::newRow("a16 short") << twr("\"a16\":\"5\",\"R\":1");
+
+    //integers converted as QJsonValue::toInt(): 0 out of the int range, then truncated to the field
+    QTest::newRow("INT_MAX") << twr("\"a16\":\"0001\",\"X\":2147483647,\"Y\":-2147483648");
+    QTest::newRow("INT_MAX + 1") << twr("\"a16\":\"0001\",\"X\":2147483648,\"Y\":-2147483649,\"T\":4294967296");
+    QTest::newRow("uint16 overflow") << twr("\"a16\":\"0001\",\"R\":70000,\"V\":65536");
+    QTest::newRow("negative unsigned") << twr("\"a16\":\"0001\",\"R\":-1,\"T\":-1,\"V\":-2");
+    QTest::newRow("large distance") << twr("\"a16\":\"0001\",\"D\":999999999999999,\"Xcm\":-999999999999999");
+
+    QTest::newRow("missing keys") << twr("\"a16\":\"0001\",\"D\":250");
+    QTest::newRow("no a16") << twr("\"R\":3,\"D\":250");
+    QTest::newRow("other order") << twr("\"Z\":3,\"Y\":2,\"X\":1,\"D\":250,\"a16\":\"0002\"");
+    QTest::newRow("unknown keys") << twr("\"a16\":\"0002\",\"Q\":5,\"name\":\"x\",\"D\":250");
+    QTest::newRow("white space") << QByteArray(" {\r\n\"TWR\" :\t{ \"a16\" : \"0003\" ,\n\"D\" : 12 } }\r\n");
+}
+
+void TestTwrParser::identical()
+{
+    QFETCH(QByteArray, frame);
+    tag_data_t scan;
+    tag_data_t json;
+
+    memset(&scan, 0xA5, sizeof(scan));
+    memset(&json, 0x5A, sizeof(json));
+
+    QVERIFY(parse_twr_scan(frame, &scan));
+    QVERIFY(parse_twr_json(frame, &json));
+
+    QCOMPARE(scan.addr16, json.addr16);
+    QCOMPARE(scan.twr.rangeNum, json.twr.rangeNum);
+    QCOMPARE(scan.twr.resTime_us, json.twr.resTime_us);
+    QCOMPARE(scan.twr.pdoa_deg, json.twr.pdoa_deg);
+    QCOMPARE(scan.twr.dist_m, json.twr.dist_m);
+    QCOMPARE(scan.twr.xdist_m, json.twr.xdist_m);
+    QCOMPARE(scan.twr.ydist_m, json.twr.ydist_m);
+    QCOMPARE(scan.twr.clockOffset_ppm, json.twr.clockOffset_ppm);
+    QCOMPARE(scan.twr.vData, json.twr.vData);
+    QCOMPARE(scan.twr.accX, json.twr.accX);
+    QCOMPARE(scan.twr.accY, json.twr.accY);
+    QCOMPARE(scan.twr.accZ, json.twr.accZ);
+}
+
+/**
+* @brief fallback_data()
+*        TWR reports the scanner leaves to QJsonDocument
+* */
+void TestTwrParser::fallback_data()
+{
+    QTest::addColumn<QByteArray>("frame");
+
+    QTest::newRow("fraction") << twr("\"a16\":\"0001\",\"D\":343.5");
+    QTest::newRow("exponent") << twr("\"a16\":\"0001\",\"D\":3e2");
+    QTest::newRow("16 digits") << twr("\"a16\":\"0001\",\"D\":1000000000000000");
+    QTest::newRow("a16 number") << twr("\"a16\":11868,\"D\":343");
+    QTest::newRow("a16 5 digits") << twr("\"a16\":\"12345\",\"D\":343");
+    QTest::newRow("a16 not hex") << twr("\"a16\":\"-1\",\"D\":343");
+    QTest::newRow("a16 escaped") << twr("\"a16\":\"2E\\u0035C\",\"D\":343");
+    QTest::newRow("value as string") << twr("\"a16\":\"0001\",\"D\":\"343\"");
+    QTest::newRow("nested value") << twr("\"a16\":\"0001\",\"D\":[343]");
+    QTest::newRow("other root key") << QByteArray("{\"TWR\": {\"a16\":\"0001\",\"D\":343},\"SN\": {}}");
+}
+
+void TestTwrParser::fallback()
+{
+    QFETCH(QByteArray, frame);
+    tag_data_t tag;
+
+    QVERIFY(!parse_twr_scan(frame, &tag));
+    QVERIFY(parse_twr_json(frame, &tag));
+}
+
+/**
+* @brief notTwr_data()
+*        frames which are no range report for either parser
+* */
+void TestTwrParser::notTwr_data()
+{
+    QTest::addColumn<QByteArray>("frame");
+
+    QTest::newRow("SN") << QByteArray("{\"SN\": {\"a16\":\"0001\",\"V\":0,\"X\":-458,\"Y\":-83,\"Z\":876}}");
+    QTest::newRow("KList") << QByteArray("{\"KList\": []}");
+    QTest::newRow("empty TWR") << QByteArray("{\"TWR\": {}}");
+    QTest::newRow("truncated") << QByteArray("{\"TWR\": {\"a16\":\"0001\",\"D\":34");
+    QTest::newRow("leading zero") << twr("\"a16\":\"0001\",\"D\":034");
+    QTest::newRow("empty") << QByteArray();
+}
+
+void TestTwrParser::notTwr()
+{
+    QFETCH(QByteArray, frame);
+    tag_data_t tag;
+
+    QVERIFY(!parse_twr_scan(frame, &tag));
+    QVERIFY(!parse_twr_json(frame, &tag));
+}
+
+/**
+* @brief benchmark()
+*        cost of parsing the recorded frames, with each parser
+* */
+/**
+* @brief binary_data()
+*        the same report in the compact binary form and as the JSON the node prints,
+*        including the 16-bit addresses above SHRT_MAX which the tag lists give as 0
+* */
+void TestTwrParser::binary_data()
+{
+    QTest::addColumn<QByteArray>("payload");
+    QTest::addColumn<QByteArray>("frame");
+    QTest::addColumn<quint16>("addr16");
+
+    const struct
+    {
+        quint16 addr16;
+        quint16 rangeNum;
+        quint32 resTime;
+        int     dist;
+        int     pdoa;
+        int     xdist;
+        int     ydist;
+        int     clockOffset;
+        quint16 vData;
+        int     acc[3];
+    } reports[] =
+    {
+        { 0x2E5C, 3, 8605, 343, 1695, 165, 165, 14, 1, { 53015, 60972, 10797 } },
+        { 0x0F21, 118, 18344, 512, -2210, -197, 472, -31, 0, { -458, -83, 876 } },
+        { 0x7FFF, 65535, 38077, 88, 0, 0, 88, 0, 0, { 0, 0, 0 } },
+        { 0x8000, 1, 100, 250, 12, -3, 250, 5, 1, { 1, 2, 3 } },
+        { 0xC4A0, 254, 28112, 1290, 402, 90, 1286, 7, 1, { 12, -4, 1003 } },
+        { 0xFFFF, 2, 200, 99, -90, -99, 0, -1, 0, { -1, -2, -3 } }
+    };
+
+    for(unsigned int i = 0; i < sizeof(reports) / sizeof(reports[0]); i++)
+    {
+        jb_twr_t twr;
+        QByteArray frame;
+
+        memset(&twr, 0, sizeof(twr));
+        twr.type = JB_TYPE_TWR;
+        twr.addr16 = reports[i].addr16;
+        twr.rangeNum = reports[i].rangeNum;
+        twr.resTime_us = reports[i].resTime;
+        twr.dist_cm = reports[i].dist;
+        twr.pdoa_deg = reports[i].pdoa;
+        twr.xdist_cm = reports[i].xdist;
+        twr.ydist_cm = reports[i].ydist;
+        twr.clockOffset = reports[i].clockOffset;
+        twr.vData = reports[i].vData;
+        twr.accX = reports[i].acc[0];
+        twr.accY = reports[i].acc[1];
+        twr.accZ = reports[i].acc[2];
+
+        frame = QString("{\"TWR\": {\"a16\":\"%1\",\"R\":%2,\"T\":%3,\"D\":%4,\"P\":%5,\"Xcm\":%6,\"Ycm\":%7,"
+                        "\"O\":%8,\"V\":%9,\"X\":%10,\"Y\":%11,\"Z\":%12}}")
+                .arg(QString::number(reports[i].addr16, 16).rightJustified(4, '0').toUpper()).arg(reports[i].rangeNum).arg(reports[i].resTime)
+                .arg(reports[i].dist).arg(reports[i].pdoa).arg(reports[i].xdist).arg(reports[i].ydist)
+                .arg(reports[i].clockOffset).arg(reports[i].vData)
+                .arg(reports[i].acc[0]).arg(reports[i].acc[1]).arg(reports[i].acc[2]).toLatin1();
+
+        QTest::newRow(qPrintable(QString("a16 %1").arg(reports[i].addr16, 4, 16, QChar('0'))))
+                << QByteArray((const char *)&twr, sizeof(twr)) << frame
+                << (quint16)((reports[i].addr16 > 0x7FFF) ? 0 : reports[i].addr16);
+    }
+}
+
+void TestTwrParser::binary()
+{
+    QFETCH(QByteArray, payload);
+    QFETCH(QByteArray, frame);
+    QFETCH(quint16, addr16);
+    tag_data_t bin;
+    tag_data_t json;
+
+    memset(&bin, 0xA5, sizeof(bin));
+    memset(&json, 0x5A, sizeof(json));
+
+    QVERIFY(parse_twr_bin(payload, &bin));
+    QVERIFY(parse_twr_json(frame, &json));
+
+    QCOMPARE(bin.addr16, json.addr16);
+    QCOMPARE(bin.twr.rangeNum, json.twr.rangeNum);
+    QCOMPARE(bin.twr.resTime_us, json.twr.resTime_us);
+    QCOMPARE(bin.twr.pdoa_deg, json.twr.pdoa_deg);
+    QCOMPARE(bin.twr.dist_m, json.twr.dist_m);
+    QCOMPARE(bin.twr.xdist_m, json.twr.xdist_m);
+    QCOMPARE(bin.twr.ydist_m, json.twr.ydist_m);
+    QCOMPARE(bin.twr.clockOffset_ppm, json.twr.clockOffset_ppm);
+    QCOMPARE(bin.twr.vData, json.twr.vData);
+    QCOMPARE(bin.twr.accX, json.twr.accX);
+    QCOMPARE(bin.twr.accY, json.twr.accY);
+    QCOMPARE(bin.twr.accZ, json.twr.accZ);
+
+    //a tag above SHRT_MAX is 0 in the KList as well, it has to be the same tag
+    QCOMPARE(bin.addr16, addr16);
+    QVERIFY(!parse_twr_bin(payload.left(payload.size() - 1), &bin));
+}
+
+void TestTwrParser::benchmark_data()
+{
+    QTest::addColumn<bool>("scanner");
+
+    QTest::newRow("scanner") << true;
+    QTest::newRow("QJsonDocument") << false;
+}
+
+void TestTwrParser::benchmark()
+{
+    QFETCH(bool, scanner);
+    QList<QByteArray> frames;
+    tag_data_t tag;
+    int parsed = 0;
+
+    for(int i = 0; i < TWR_FRAMES; i++)
+    {
+        frames.append(QByteArray(twrFrames[i]));
+    }
+
+    QBENCHMARK
+    {
+        for(int i = 0; i < frames.size(); i++)
+        {
+            parsed += scanner ? parse_twr_scan(frames.at(i), &tag) : parse_twr_json(frames.at(i), &tag);
+        }
+    }
+
+    QVERIFY(parsed > 0);
+}
+
+QTEST_APPLESS_MAIN(TestTwrParser)
+
+#include "tst_twrparser.moc"
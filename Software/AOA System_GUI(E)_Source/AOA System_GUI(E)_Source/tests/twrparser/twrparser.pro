@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# TWR report parsing: the single pass scanner against QJsonDocument,
+# same tag_data_t for the same frames, and the cost of each (QBENCHMARK)
+#
+#-------------------------------------------------
+
+QT       = core serialport testlib
+
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TARGET = tst_twrparser
+TEMPLATE = app
+
+include(../../core.pri)
+
+SOURCES += tst_twrparser.cpp
@@ -0,0 +1,162 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: LatencyHistogram.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "LatencyHistogram.h"
+
+#include <string.h>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::reset(void)
+{
+    memset(_buckets, 0, sizeof(_buckets));
+    _count = 0;
+    _sum = 0;
+    _min = 0;
+    _max = 0;
+}
+
+/**
+* @brief bucketOf()
+*        values below LAT_SUB_COUNT have a bucket each, above that the bucket is given by the position of the
+*        top bit and the LAT_SUB_BITS - 1 bits following it
+* */
+int LatencyHistogram::bucketOf(qint64 ns)
+{
+    quint64 v = (ns > 0) ? (quint64)ns : 0;
+    int msb = 0;
+
+    if(v < LAT_SUB_COUNT)
+    {
+        return (int)v;
+    }
+
+    while((v >> (msb + 1)) != 0)
+    {
+        msb++;
+    }
+
+    if(msb > LAT_MAX_BIT)
+    {
+        return LAT_BUCKETS - 1;
+    }
+
+    //v >> (msb - LAT_SUB_BITS + 1) is in [LAT_HALF_COUNT, LAT_SUB_COUNT)
+    return LAT_SUB_COUNT + (msb - LAT_SUB_BITS) * LAT_HALF_COUNT
+           + (int)(v >> (msb - LAT_SUB_BITS + 1)) - LAT_HALF_COUNT;
+}
+
+qint64 LatencyHistogram::bucketLow(int bucket)
+{
+    int k, msb;
+
+    if(bucket < LAT_SUB_COUNT)
+    {
+        return bucket;
+    }
+
+    k = bucket - LAT_SUB_COUNT;
+    msb = k / LAT_HALF_COUNT + LAT_SUB_BITS;
+
+    return (qint64)(k % LAT_HALF_COUNT + LAT_HALF_COUNT) << (msb - LAT_SUB_BITS + 1);
+}
+
+qint64 LatencyHistogram::bucketHigh(int bucket)
+{
+    if(bucket < LAT_SUB_COUNT)
+    {
+        return bucket;
+    }
+
+    return bucketLow(bucket + 1) - 1;
+}
+
+void LatencyHistogram::record(qint64 ns)
+{
+    if(ns < 0)
+    {
+        ns = 0;
+    }
+
+    _buckets[bucketOf(ns)]++;
+
+    if((_count == 0) || (ns < _min))
+    {
+        _min = ns;
+    }
+
+    if(ns > _max)
+    {
+        _max = ns;
+    }
+
+    _count++;
+    _sum += ns;
+}
+
+void LatencyHistogram::add(const LatencyHistogram &other)
+{
+    if(other._count == 0)
+    {
+        return;
+    }
+
+    for(int i = 0; i < LAT_BUCKETS; i++)
+    {
+        _buckets[i] += other._buckets[i];
+    }
+
+    if((_count == 0) || (other._min < _min))
+    {
+        _min = other._min;
+    }
+
+    if(other._max > _max)
+    {
+        _max = other._max;
+    }
+
+    _count += other._count;
+    _sum += other._sum;
+}
+
+qint64 LatencyHistogram::percentile(double percent) const
+{
+    quint64 target, seen = 0;
+
+    if(_count == 0)
+    {
+        return 0;
+    }
+
+    target = (quint64)(_count * percent / 100.0 + 0.5);
+
+    if(target < 1)
+    {
+        target = 1;
+    }
+
+    for(int i = 0; i < LAT_BUCKETS; i++)
+    {
+        seen += _buckets[i];
+
+        if(seen >= target)
+        {
+            return qMin(bucketHigh(i), _max);
+        }
+    }
+
+    return _max;
+}
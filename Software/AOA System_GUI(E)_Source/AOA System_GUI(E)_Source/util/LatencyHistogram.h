@@ -0,0 +1,63 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: LatencyHistogram.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+
+#define LAT_SUB_BITS        (5)                         //16 buckets per power of 2, each at most 1/16 wide
+#define LAT_SUB_COUNT       (1 << LAT_SUB_BITS)
+#define LAT_HALF_COUNT      (LAT_SUB_COUNT / 2)
+#define LAT_MAX_BIT         (40)                        //values up to 2^41 ns (~36 min)
+#define LAT_BUCKETS         (LAT_SUB_COUNT + (LAT_MAX_BIT - LAT_SUB_BITS + 1) * LAT_HALF_COUNT)
+
+/**
+ * The LatencyHistogram class records durations (ns) in HDR style log-linear buckets: exact below 32 ns,
+ * then 16 buckets for each power of 2, so any value is known to within 6% whatever its magnitude.
+ * record() is O(1) and never allocates; the percentiles are read back from the bucket counts.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(qint64 ns);
+    void reset(void);
+    void add(const LatencyHistogram &other);
+
+    quint64 count(void) const { return _count; }
+    qint64  min(void) const { return _count ? _min : 0; }
+    qint64  max(void) const { return _max; }
+    qint64  sum(void) const { return _sum; }
+    double  mean(void) const { return _count ? (double)_sum / _count : 0; }
+
+    /**
+     * @return the value below which \a percent % of the recorded values are (the upper end of its bucket)
+     */
+    qint64 percentile(double percent) const;
+
+    //the buckets, for dumping the whole distribution
+    static int bucketOf(qint64 ns);
+    static qint64 bucketLow(int bucket);
+    static qint64 bucketHigh(int bucket);
+    quint32 bucketCount(int bucket) const { return _buckets[bucket]; }
+
+private:
+    quint32 _buckets[LAT_BUCKETS];
+    quint64 _count;
+    qint64  _sum;
+    qint64  _min;
+    qint64  _max;
+};
+
+#endif // LATENCYHISTOGRAM_H
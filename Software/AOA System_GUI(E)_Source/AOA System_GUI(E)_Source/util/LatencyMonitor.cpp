@@ -0,0 +1,126 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: LatencyMonitor.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "LatencyMonitor.h"
+#include "LogCategories.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+static const char *latencyStageNames[LatencyStages] =
+{
+    "decode",
+    "parse",
+    "filter",
+    "queue",
+    "scene",
+    "total",
+    "command"
+};
+
+static QElapsedTimer startedTimer(void)
+{
+    QElapsedTimer timer;
+
+    timer.start();
+
+    return timer;
+}
+
+LatencyMonitor::LatencyMonitor()
+{
+}
+
+qint64 LatencyMonitor::now(void)
+{
+    //started on the first use, from whichever thread that is
+    static const QElapsedTimer clock = startedTimer();
+
+    return clock.nsecsElapsed();
+}
+
+const char *LatencyMonitor::stageName(int stage)
+{
+    return ((stage >= 0) && (stage < LatencyStages)) ? latencyStageNames[stage] : "";
+}
+
+void LatencyMonitor::record(int stage, qint64 ns)
+{
+    QMutexLocker locker(&_lock);
+
+    _histograms[stage].record(ns);
+}
+
+void LatencyMonitor::snapshot(LatencyHistogram *histograms)
+{
+    QMutexLocker locker(&_lock);
+
+    for(int i = 0; i < LatencyStages; i++)
+    {
+        histograms[i] = _histograms[i];
+    }
+}
+
+void LatencyMonitor::reset(void)
+{
+    QMutexLocker locker(&_lock);
+
+    for(int i = 0; i < LatencyStages; i++)
+    {
+        _histograms[i].reset();
+    }
+}
+
+bool LatencyMonitor::writeCsv(const QString &path)
+{
+    LatencyHistogram h[LatencyStages];
+    QFile file(path);
+
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        qCWarning(lcFile) << "latency: cannot write" << path;
+        return false;
+    }
+
+    snapshot(h);
+
+    QTextStream out(&file);
+
+    out << "stage,count,min_us,mean_us,p50_us,p90_us,p99_us,p99.9_us,max_us\n";
+
+    for(int i = 0; i < LatencyStages; i++)
+    {
+        out << stageName(i) << ',' << h[i].count() << ','
+            << h[i].min() / 1000.0 << ',' << h[i].mean() / 1000.0 << ','
+            << h[i].percentile(50) / 1000.0 << ',' << h[i].percentile(90) / 1000.0 << ','
+            << h[i].percentile(99) / 1000.0 << ',' << h[i].percentile(99.9) / 1000.0 << ','
+            << h[i].max() / 1000.0 << '\n';
+    }
+
+    out << "\nstage,low_ns,high_ns,count\n";
+
+    for(int i = 0; i < LatencyStages; i++)
+    {
+        for(int b = 0; b < LAT_BUCKETS; b++)
+        {
+            if(h[i].bucketCount(b))
+            {
+                out << stageName(i) << ',' << LatencyHistogram::bucketLow(b) << ','
+                    << LatencyHistogram::bucketHigh(b) << ',' << h[i].bucketCount(b) << '\n';
+            }
+        }
+    }
+
+    return true;
+}
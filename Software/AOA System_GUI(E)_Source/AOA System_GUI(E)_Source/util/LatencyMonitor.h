@@ -0,0 +1,73 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: LatencyMonitor.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef LATENCYMONITOR_H
+#define LATENCYMONITOR_H
+
+#include <QMutex>
+#include <QString>
+
+#include "LatencyHistogram.h"
+
+/**
+* @brief LatencyStage
+*        the stages of a range report, from the serial port to the scene
+*/
+enum LatencyStage
+{
+    LatencyDecode = 0,  //readyRead -> frame decoded (I/O thread)
+    LatencyParse,       //frame decoded -> report parsed (I/O thread)
+    LatencyFilter,      //report parsed -> position filter output (I/O thread)
+    LatencyQueue,       //filter output -> taken by the GUI thread
+    LatencyScene,       //time to move the tag in the scene and update its table row
+    LatencyTotal,       //readyRead -> tag moved in the scene (including the wait for the display frame)
+    LatencyCommand,     //command written to the node -> its reply decoded (round trip, I/O thread)
+    LatencyStages
+};
+
+/**
+ * The LatencyMonitor class collects a LatencyHistogram per LatencyStage.
+ *
+ * The stages are recorded on the I/O and on the GUI thread, with the time stamps taken from now(), a monotonic
+ * clock common to both. The histograms are guarded by a mutex, it is only ever held for a record() or a copy.
+ */
+class LatencyMonitor
+{
+public:
+    LatencyMonitor();
+
+    /**
+     * @return the monotonic time in ns, used for all the stamps
+     */
+    static qint64 now(void);
+
+    static const char *stageName(int stage);
+
+    void record(int stage, qint64 ns);
+
+    /**
+     * Copy the histograms to \a histograms (LatencyStages of them).
+     */
+    void snapshot(LatencyHistogram *histograms);
+    void reset(void);
+
+    /**
+     * Write the per-stage percentiles (us), then the non-empty buckets of each stage, to a CSV file.
+     */
+    bool writeCsv(const QString &path);
+
+private:
+    QMutex _lock;
+    LatencyHistogram _histograms[LatencyStages];
+};
+
+#endif // LATENCYMONITOR_H
@@ -0,0 +1,94 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: LogCategories.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "LogCategories.h"
+
+#include <string.h>
+
+Q_LOGGING_CATEGORY(lcSerial, "rtls.serial", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcParse, "rtls.parse", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcFilter, "rtls.filter", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcScene, "rtls.scene", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcTable, "rtls.table", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcGeofence, "rtls.geofence", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcFile, "rtls.file", QtInfoMsg)
+
+const QLoggingCategory &logCategory(int category)
+{
+    switch(category)
+    {
+        case LogParse:
+            return lcParse();
+        case LogFilter:
+            return lcFilter();
+        case LogScene:
+            return lcScene();
+        case LogTable:
+            return lcTable();
+        case LogGeofence:
+            return lcGeofence();
+        case LogFile:
+            return lcFile();
+        case LogSerial:
+        default:
+            return lcSerial();
+    }
+}
+
+//the filter runs while the categories are being constructed: they are matched by name, not with logCategory()
+static const char *s_names[LogCategories] = { "rtls.serial", "rtls.parse", "rtls.filter",
+                                              "rtls.scene", "rtls.table", "rtls.geofence", "rtls.file" };
+static int s_debug[LogCategories] = { -1, -1, -1, -1, -1, -1, -1 }; //set from the UI: -1 not set, 0 off, 1 on
+static QLoggingCategory::CategoryFilter s_defaultFilter = NULL;
+
+/**
+ * @brief categoryFilter()
+ *        the default filter (QT_LOGGING_RULES, setFilterRules()) first, then the debug output set from the UI
+ * */
+static void categoryFilter(QLoggingCategory *category)
+{
+    if(s_defaultFilter)
+    {
+        s_defaultFilter(category);
+    }
+
+    for(int i = 0; i < LogCategories; i++)
+    {
+        if((s_debug[i] >= 0) && (strcmp(category->categoryName(), s_names[i]) == 0))
+        {
+            category->setEnabled(QtDebugMsg, s_debug[i] != 0);
+            break;
+        }
+    }
+}
+
+void setLogCategoryEnabled(int category, bool enabled)
+{
+    static bool installed = false;
+
+    if((category < 0) || (category >= LogCategories))
+    {
+        return;
+    }
+
+    s_debug[category] = enabled ? 1 : 0;
+
+    //the default filter is only known once ours is installed
+    if(!installed)
+    {
+        s_defaultFilter = QLoggingCategory::installFilter(categoryFilter);
+        installed = true;
+    }
+
+    //installing the filter applies it to all the categories again
+    QLoggingCategory::installFilter(categoryFilter);
+}
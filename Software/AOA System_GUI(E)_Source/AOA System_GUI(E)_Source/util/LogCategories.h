@@ -0,0 +1,55 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: LogCategories.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef LOGCATEGORIES_H
+#define LOGCATEGORIES_H
+
+#include <QLoggingCategory>
+
+/*
+ * Debug output categories of the viewer, use qCDebug(lcSerial) << ... instead of qDebug() << ...
+ * When a category's debug output is off, qCDebug() is a single flag test: its arguments are not even evaluated,
+ * so the hot paths (every report, every command, every table refresh) can keep their traces.
+ *
+ * The debug output is off by default (warnings are always on). It can be switched on:
+ * - from the environment, e.g. QT_LOGGING_RULES="rtls.serial.debug=true;rtls.table.debug=true"
+ * - at run time with setLogCategoryEnabled() (the Diagnostics window), this is applied after the rules
+ *   from the environment, so it overrides them
+ */
+Q_DECLARE_LOGGING_CATEGORY(lcSerial)    //"rtls.serial"   : serial port, commands sent to the node and their replies
+Q_DECLARE_LOGGING_CATEGORY(lcParse)     //"rtls.parse"    : JSON/binary frames from the node
+Q_DECLARE_LOGGING_CATEGORY(lcFilter)    //"rtls.filter"   : position filters
+Q_DECLARE_LOGGING_CATEGORY(lcScene)     //"rtls.scene"    : tags and nodes in the scene, position updates
+Q_DECLARE_LOGGING_CATEGORY(lcTable)     //"rtls.table"    : tag table and tag expiry
+Q_DECLARE_LOGGING_CATEGORY(lcGeofence)  //"rtls.geofence" : geo-fencing zone and alarms
+Q_DECLARE_LOGGING_CATEGORY(lcFile)      //"rtls.file"     : range log, session, capture and latency files
+
+enum LogCategory
+{
+    LogSerial = 0,
+    LogParse,
+    LogFilter,
+    LogScene,
+    LogTable,
+    LogGeofence,
+    LogFile,
+    LogCategories
+};
+
+const QLoggingCategory &logCategory(int category);
+
+/**
+ * Switch the debug output of \a category on or off (installs a category filter, see QLoggingCategory::installFilter()).
+ */
+void setLogCategoryEnabled(int category, bool enabled);
+
+#endif // LOGCATEGORIES_H
@@ -0,0 +1,249 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: LogWriter.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "LogWriter.h"
+#include "LogCategories.h"
+#include "SessionFile.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QtEndian>
+#include <stdio.h>
+
+LogWriter::LogWriter() :
+    _format(Csv),
+    _rotateBytes(LOG_ROTATE_BYTES),
+    _rotateSecs(LOG_ROTATE_SECS),
+    _opened(0)
+{
+    _queue = new SpscQueue<range_log_t, LOG_QUEUE_LEN>();
+    _session = new SessionWriter();
+}
+
+LogWriter::~LogWriter()
+{
+    close();
+
+    delete _queue;
+    delete _session;
+}
+
+void LogWriter::setRotation(qint64 bytes, int secs)
+{
+    _rotateBytes = bytes;
+    _rotateSecs = secs;
+}
+
+bool LogWriter::open(const QString &dir, const QString &name, Format format)
+{
+    close();
+
+    if(!QDir().mkpath(dir))
+    {
+        qCWarning(lcFile) << "log: can't create" << dir;
+        return false;
+    }
+
+    _dir = dir;
+    _name = name;
+    _format = format;
+    _files.storeRelaxed(0);
+    _written.storeRelaxed(0);
+    _dropped.storeRelaxed(0);
+
+    //records from before this log are not part of it
+    range_log_t stale;
+    while(_queue->pop(&stale))
+    {
+    }
+
+    if(!openFile())
+    {
+        return false;
+    }
+
+    _stop.storeRelaxed(0);
+    _open.storeRelaxed(1);
+
+    start(QThread::LowPriority);
+
+    return true;
+}
+
+void LogWriter::close(void)
+{
+    //the writer thread may also have stopped by itself, if a new file could not be created
+    _open.storeRelaxed(0);
+    _stop.storeRelaxed(1);
+
+    wait();
+
+    if(_file.isOpen() || _session->isOpen())
+    {
+        _file.close();
+        _session->close();
+
+        qCDebug(lcFile) << "log:" << written() << "records in" << files() << "files," << dropped() << "dropped";
+    }
+}
+
+/**
+* @brief openFile()
+*        the next file of the log: <name>.csv, then <name>_1.csv...
+* */
+bool LogWriter::openFile(void)
+{
+    int n = _files.loadRelaxed();
+    QString path = _dir + "/" + _name;
+
+    if(n > 0)
+    {
+        path += QString("_%1").arg(n);
+    }
+
+    if(_format == Session)
+    {
+        if(!_session->open(path + ".ses"))
+        {
+            return false;
+        }
+
+        _opened = QDateTime::currentMSecsSinceEpoch();
+        _files.fetchAndAddRelaxed(1);
+
+        return true;
+    }
+
+    path += (_format == Binary) ? ".bin" : ".csv";
+
+    _file.setFileName(path);
+
+    if(!_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCWarning(lcFile) << "log: can't create" << path << _file.errorString();
+        return false;
+    }
+
+    if(_format == Binary)
+    {
+        _file.write(LOG_BIN_MAGIC, LOG_BIN_MAGIC_LEN);
+    }
+    else
+    {
+        _file.write("time,tag,seq,x,y,range,angle\n");
+    }
+
+    _opened = QDateTime::currentMSecsSinceEpoch();
+    _files.fetchAndAddRelaxed(1);
+
+    return true;
+}
+
+void LogWriter::rotate(void)
+{
+    _file.close();
+    _session->close();
+
+    if(!openFile())
+    {
+        //nothing more can be written, the records are dropped from now on
+        _open.storeRelaxed(0);
+        _stop.storeRelaxed(1);
+    }
+}
+
+/**
+* @brief run()
+*        the writer thread: drain the queue every LOG_DRAIN_MS, and once more when asked to stop
+* */
+void LogWriter::run()
+{
+    while(!_stop.loadRelaxed())
+    {
+        msleep(LOG_DRAIN_MS);
+
+        drain();
+    }
+
+    drain();
+}
+
+/**
+* @brief drain()
+*        format all the queued records into one batch, write it and start a new file if needed
+* */
+void LogWriter::drain(void)
+{
+    range_log_t r;
+    int count = 0;
+
+    if(!_file.isOpen() && !_session->isOpen())
+    {
+        return;
+    }
+
+    _batch.clear();
+
+    while(_queue->pop(&r))
+    {
+        if(_format == Session)
+        {
+            _session->append(r);
+        }
+        else if(_format == Binary)
+        {
+            uchar record[LOG_BIN_RECORD_LEN];
+
+            qToLittleEndian<qint64>(r.time, record);
+            qToLittleEndian<quint16>(r.addr16, record + 8);
+            qToLittleEndian<quint16>(r.seq, record + 10);
+            qToLittleEndian<qint32>(qRound(r.x * 1000), record + 12);
+            qToLittleEndian<qint32>(qRound(r.y * 1000), record + 16);
+            qToLittleEndian<qint32>(qRound(r.range * 1000), record + 20);
+            qToLittleEndian<qint16>(r.angle, record + 24);
+
+            _batch.append((const char *)record, LOG_BIN_RECORD_LEN);
+        }
+        else
+        {
+            char line[128];
+            int length = snprintf(line, sizeof(line), "%04X,%d,%.3f,%.3f,%.3f,%d\n",
+                                  r.addr16, r.seq, r.x, r.y, r.range, r.angle);
+
+            _batch.append(QDateTime::fromMSecsSinceEpoch(r.time).toString("yyyy-MM-dd hh:mm:ss.zzz").toLatin1());
+            _batch.append(',');
+            _batch.append(line, qMin(length, (int)sizeof(line) - 1));
+        }
+
+        count++;
+    }
+
+    if(count == 0)
+    {
+        return;
+    }
+
+    if(_format != Session)
+    {
+        _file.write(_batch);
+        _file.flush();
+    }
+
+    _written.fetchAndAddRelaxed(count);
+
+    if(((_rotateBytes > 0) && (((_format == Session) ? _session->size() : _file.size()) >= _rotateBytes)) ||
+       ((_rotateSecs > 0) && ((QDateTime::currentMSecsSinceEpoch() - _opened) >= (qint64)_rotateSecs * 1000)))
+    {
+        rotate();
+    }
+}
@@ -0,0 +1,146 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: LogWriter.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QFile>
+#include <QString>
+
+#include "SpscQueue.h"
+
+#define LOG_QUEUE_LEN       (4096)              //records waiting for the writer thread, must be a power of 2
+#define LOG_DRAIN_MS        (100)               //the writer thread drains the queue this often
+#define LOG_ROTATE_BYTES    (16 * 1024 * 1024)  //default size at which a new file is started
+#define LOG_ROTATE_SECS     (60 * 60)           //default age at which a new file is started
+
+/*
+ * Binary range log (LogWriter::Binary):
+ *
+ * file   : LOG_BIN_MAGIC, then one record per range report
+ * record : time in ms since the epoch (qint64), tag addr16 (quint16), seq (quint16), x (qint32 mm), y (qint32 mm),
+ *          range (qint32 mm), angle (qint16 deg) (all little endian)
+ */
+#define LOG_BIN_MAGIC       ("DWLOG001")
+#define LOG_BIN_MAGIC_LEN   (8)
+#define LOG_BIN_RECORD_LEN  (26)
+
+class SessionWriter;
+
+/**
+* @brief range_log_t
+*        one range report as it is logged
+*/
+typedef struct
+{
+    qint64  time;   //QDateTime::currentMSecsSinceEpoch() of the report
+    int     addr16;
+    int     seq;
+    double  x, y;   //m, as reported by the node
+    double  range;  //m
+    int     angle;  //deg
+    int     mode;   //mode and battery bits
+    int     accX, accY, accZ;
+} range_log_t;
+
+/**
+* @brief LogWriter
+*        Writes the range log on its own thread.
+*
+*        The thread which processes the reports only copies a record into a lock-free queue with append(), the
+*        formatting and the file writes are done by the writer thread, which drains the queue every LOG_DRAIN_MS.
+*        The queue has a fixed size, if the writer falls behind the records are dropped and counted, so the memory
+*        used is bounded whatever the report rate.
+*
+*        The records are written as CSV, in the binary format above, or as a columnar session file (see
+*        SessionFile.h) which can be memory mapped and filtered by tag and time. A new file is started when the current one
+*        reaches the rotation size or age: <name>.csv, <name>_1.csv, <name>_2.csv... (.bin, .ses)
+*
+*        append() may only be called from one thread (the producer), open() and close() from that same thread.
+*/
+class LogWriter : public QThread
+{
+public:
+    enum Format
+    {
+        Csv = 0,
+        Binary,
+        Session
+    };
+
+    LogWriter();
+    ~LogWriter();
+
+    /**
+     * Create the first file \a name in \a dir (created if needed) and start the writer thread.
+     * @return false if the file could not be created
+     */
+    bool open(const QString &dir, const QString &name, Format format);
+
+    /**
+     * Stop the writer thread once it has written all the queued records, and close the file.
+     */
+    void close(void);
+
+    bool isOpen(void) const { return _open.loadRelaxed(); }
+
+    /**
+     * Start a new file when the current one reaches \a bytes or \a secs (0: no limit), set before open().
+     */
+    void setRotation(qint64 bytes, int secs);
+
+    /**
+     * Producer side: queue \a record for the writer thread, it is dropped if the queue is full.
+     */
+    void append(const range_log_t &record)
+    {
+        if(!_queue->push(record))
+        {
+            _dropped.fetchAndAddRelaxed(1);
+        }
+    }
+
+    int written(void) const { return _written.loadRelaxed(); }
+    int dropped(void) const { return _dropped.loadRelaxed(); }
+    int files(void) const { return _files.loadRelaxed(); }
+
+protected:
+    void run();
+
+private:
+    bool openFile(void);
+    void drain(void);
+    void rotate(void);
+
+    SpscQueue<range_log_t, LOG_QUEUE_LEN> *_queue;
+
+    QFile _file;
+    SessionWriter *_session;    //used instead of _file for the Session format
+    QString _dir;
+    QString _name;
+    Format _format;
+    qint64 _rotateBytes;
+    int _rotateSecs;
+    qint64 _opened;         //QDateTime::currentMSecsSinceEpoch() when the current file was opened
+
+    QByteArray _batch;      //the records of one drain, written at once
+
+    QAtomicInt _open;
+    QAtomicInt _stop;
+    QAtomicInt _written;
+    QAtomicInt _dropped;
+    QAtomicInt _files;
+};
+
+#endif // LOGWRITER_H
@@ -0,0 +1,331 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: SessionFile.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "SessionFile.h"
+#include "LogCategories.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QtEndian>
+#include <string.h>
+
+static const int sessionColumnWidth[SessionColumns] =
+{
+    8,          //SessionTime
+    4, 4, 4,    //SessionRange, SessionX, SessionY
+    2, 2, 2, 2, //SessionAddr16, SessionSeq, SessionAngle, SessionMode
+    2, 2, 2     //SessionAccX, SessionAccY, SessionAccZ
+};
+
+//chunk header fields
+#define CHUNK_ROWS_OFFSET   (0)
+#define CHUNK_TAGS_OFFSET   (4)
+#define CHUNK_TMIN_OFFSET   (8)
+#define CHUNK_TMAX_OFFSET   (16)
+
+int SessionWriter::columnWidth(int column)
+{
+    return sessionColumnWidth[column];
+}
+
+int SessionWriter::columnOffset(int column)
+{
+    int offset = SESSION_CHUNK_HEADER_LEN + SESSION_TAG_INDEX_LEN;
+
+    for(int i = 0; i < column; i++)
+    {
+        offset += sessionColumnWidth[i] * SESSION_CHUNK_ROWS;
+    }
+
+    return offset;
+}
+
+int SessionWriter::chunkLength(void)
+{
+    return columnOffset(SessionColumns);
+}
+
+SessionWriter::SessionWriter() :
+    _rows(0),
+    _tags(0)
+{
+}
+
+bool SessionWriter::open(const QString &path)
+{
+    uchar header[SESSION_HEADER_LEN];
+
+    close();
+
+    _file.setFileName(path);
+
+    if(!_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCWarning(lcFile) << "session: can't create" << path << _file.errorString();
+        return false;
+    }
+
+    memset(header, 0, sizeof(header));
+    memcpy(header, SESSION_MAGIC, SESSION_MAGIC_LEN);
+    qToLittleEndian<quint32>(SESSION_VERSION, header + 8);
+    qToLittleEndian<quint32>(SESSION_CHUNK_ROWS, header + 12);
+    qToLittleEndian<quint32>(chunkLength(), header + 16);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 24);
+
+    _file.write((const char *)header, SESSION_HEADER_LEN);
+
+    _chunk.fill(0, chunkLength());
+    _rows = 0;
+    _tags = 0;
+
+    return true;
+}
+
+void SessionWriter::close(void)
+{
+    if(_file.isOpen())
+    {
+        writeChunk();
+        _file.close();
+    }
+
+    _chunk.clear();
+}
+
+qint64 SessionWriter::size(void) const
+{
+    return _file.size() + ((_rows > 0) ? chunkLength() : 0);
+}
+
+/**
+* @brief append()
+*        the report goes straight into its row of the chunk's columns
+* */
+void SessionWriter::append(const range_log_t &record)
+{
+    if(!_file.isOpen())
+    {
+        return;
+    }
+
+    uchar *c = (uchar *)_chunk.data();
+    int row = _rows;
+    quint16 addr16 = record.addr16;
+    uchar *bit = c + SESSION_CHUNK_HEADER_LEN + (addr16 >> 3);
+
+    if(!(*bit & (1 << (addr16 & 7))))
+    {
+        *bit |= (1 << (addr16 & 7));
+        _tags++;
+    }
+
+    if((row == 0) || (record.time < qFromLittleEndian<qint64>(c + CHUNK_TMIN_OFFSET)))
+    {
+        qToLittleEndian<qint64>(record.time, c + CHUNK_TMIN_OFFSET);
+    }
+
+    if((row == 0) || (record.time > qFromLittleEndian<qint64>(c + CHUNK_TMAX_OFFSET)))
+    {
+        qToLittleEndian<qint64>(record.time, c + CHUNK_TMAX_OFFSET);
+    }
+
+    qToLittleEndian<qint64>(record.time, c + columnOffset(SessionTime) + row * 8);
+    qToLittleEndian<qint32>(qRound(record.range * 1000), c + columnOffset(SessionRange) + row * 4);
+    qToLittleEndian<qint32>(qRound(record.x * 1000), c + columnOffset(SessionX) + row * 4);
+    qToLittleEndian<qint32>(qRound(record.y * 1000), c + columnOffset(SessionY) + row * 4);
+    qToLittleEndian<quint16>(addr16, c + columnOffset(SessionAddr16) + row * 2);
+    qToLittleEndian<quint16>(record.seq, c + columnOffset(SessionSeq) + row * 2);
+    qToLittleEndian<qint16>(record.angle, c + columnOffset(SessionAngle) + row * 2);
+    qToLittleEndian<quint16>(record.mode, c + columnOffset(SessionMode) + row * 2);
+    qToLittleEndian<qint16>(record.accX, c + columnOffset(SessionAccX) + row * 2);
+    qToLittleEndian<qint16>(record.accY, c + columnOffset(SessionAccY) + row * 2);
+    qToLittleEndian<qint16>(record.accZ, c + columnOffset(SessionAccZ) + row * 2);
+
+    _rows++;
+
+    if(_rows == SESSION_CHUNK_ROWS)
+    {
+        writeChunk();
+    }
+}
+
+void SessionWriter::writeChunk(void)
+{
+    if(_rows == 0)
+    {
+        return;
+    }
+
+    qToLittleEndian<quint32>(_rows, (uchar *)_chunk.data() + CHUNK_ROWS_OFFSET);
+    qToLittleEndian<quint32>(_tags, (uchar *)_chunk.data() + CHUNK_TAGS_OFFSET);
+
+    _file.write(_chunk);
+    _file.flush();
+
+    _chunk.fill(0);
+    _rows = 0;
+    _tags = 0;
+}
+
+SessionReader::SessionReader() :
+    _data(NULL),
+    _chunks(0)
+{
+}
+
+SessionReader::~SessionReader()
+{
+    close();
+}
+
+bool SessionReader::open(const QString &path)
+{
+    close();
+
+    _file.setFileName(path);
+
+    if(!_file.open(QIODevice::ReadOnly))
+    {
+        qCWarning(lcFile) << "session: can't open" << path << _file.errorString();
+        return false;
+    }
+
+    if(_file.size() < SESSION_HEADER_LEN)
+    {
+        qCWarning(lcFile) << "session:" << path << "is not a session file";
+        close();
+        return false;
+    }
+
+    _data = _file.map(0, _file.size());
+
+    if(_data == NULL)
+    {
+        qCWarning(lcFile) << "session: can't map" << path << _file.errorString();
+        close();
+        return false;
+    }
+
+    if((memcmp(_data, SESSION_MAGIC, SESSION_MAGIC_LEN) != 0) ||
+       (qFromLittleEndian<quint32>(_data + 8) != SESSION_VERSION) ||
+       (qFromLittleEndian<quint32>(_data + 12) != SESSION_CHUNK_ROWS) ||
+       (qFromLittleEndian<quint32>(_data + 16) != (quint32)SessionWriter::chunkLength()))
+    {
+        qCWarning(lcFile) << "session:" << path << "is not a session file of this version";
+        close();
+        return false;
+    }
+
+    _chunks = (_file.size() - SESSION_HEADER_LEN) / SessionWriter::chunkLength();
+
+    return true;
+}
+
+void SessionReader::close(void)
+{
+    if(_data != NULL)
+    {
+        _file.unmap((uchar *)_data);
+        _data = NULL;
+    }
+
+    _file.close();
+    _chunks = 0;
+}
+
+const uchar *SessionReader::chunk(int i) const
+{
+    return _data + SESSION_HEADER_LEN + (qint64)i * SessionWriter::chunkLength();
+}
+
+qint64 SessionReader::rows(void) const
+{
+    qint64 n = 0;
+
+    for(int i = 0; i < _chunks; i++)
+    {
+        n += qFromLittleEndian<quint32>(chunk(i) + CHUNK_ROWS_OFFSET);
+    }
+
+    return n;
+}
+
+qint64 SessionReader::startTime(void) const
+{
+    return (_chunks > 0) ? qFromLittleEndian<qint64>(chunk(0) + CHUNK_TMIN_OFFSET) : 0;
+}
+
+qint64 SessionReader::endTime(void) const
+{
+    return (_chunks > 0) ? qFromLittleEndian<qint64>(chunk(_chunks - 1) + CHUNK_TMAX_OFFSET) : 0;
+}
+
+int SessionReader::select(int addr16, qint64 from, qint64 to, QVector<range_log_t> *records) const
+{
+    int count = 0;
+
+    for(int i = 0; i < _chunks; i++)
+    {
+        const uchar *c = chunk(i);
+        int rows = qMin<quint32>(qFromLittleEndian<quint32>(c + CHUNK_ROWS_OFFSET), SESSION_CHUNK_ROWS);
+
+        //the chunk index: time range and tags
+        if((qFromLittleEndian<qint64>(c + CHUNK_TMAX_OFFSET) < from) ||
+           (qFromLittleEndian<qint64>(c + CHUNK_TMIN_OFFSET) > to))
+        {
+            continue;
+        }
+
+        if((addr16 >= 0) &&
+           !(c[SESSION_CHUNK_HEADER_LEN + ((addr16 & 0xFFFF) >> 3)] & (1 << (addr16 & 7))))
+        {
+            continue;
+        }
+
+        const uchar *time = c + SessionWriter::columnOffset(SessionTime);
+        const uchar *id = c + SessionWriter::columnOffset(SessionAddr16);
+
+        for(int row = 0; row < rows; row++)
+        {
+            qint64 t = qFromLittleEndian<qint64>(time + row * 8);
+
+            if((t < from) || (t > to))
+            {
+                continue;
+            }
+
+            if((addr16 >= 0) && (qFromLittleEndian<quint16>(id + row * 2) != addr16))
+            {
+                continue;
+            }
+
+            range_log_t r;
+
+            r.time = t;
+            r.addr16 = qFromLittleEndian<quint16>(id + row * 2);
+            r.seq = qFromLittleEndian<quint16>(c + SessionWriter::columnOffset(SessionSeq) + row * 2);
+            r.range = qFromLittleEndian<qint32>(c + SessionWriter::columnOffset(SessionRange) + row * 4) / 1000.0;
+            r.x = qFromLittleEndian<qint32>(c + SessionWriter::columnOffset(SessionX) + row * 4) / 1000.0;
+            r.y = qFromLittleEndian<qint32>(c + SessionWriter::columnOffset(SessionY) + row * 4) / 1000.0;
+            r.angle = qFromLittleEndian<qint16>(c + SessionWriter::columnOffset(SessionAngle) + row * 2);
+            r.mode = qFromLittleEndian<quint16>(c + SessionWriter::columnOffset(SessionMode) + row * 2);
+            r.accX = qFromLittleEndian<qint16>(c + SessionWriter::columnOffset(SessionAccX) + row * 2);
+            r.accY = qFromLittleEndian<qint16>(c + SessionWriter::columnOffset(SessionAccY) + row * 2);
+            r.accZ = qFromLittleEndian<qint16>(c + SessionWriter::columnOffset(SessionAccZ) + row * 2);
+
+            records->append(r);
+            count++;
+        }
+    }
+
+    return count;
+}
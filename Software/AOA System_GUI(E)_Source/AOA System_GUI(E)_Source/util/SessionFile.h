@@ -0,0 +1,134 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: SessionFile.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef SESSIONFILE_H
+#define SESSIONFILE_H
+
+#include <QFile>
+#include <QVector>
+
+#include "LogWriter.h"
+
+/*
+ * Columnar session file of the range reports, made to be memory mapped and filtered without parsing.
+ *
+ * file   : header (SESSION_HEADER_LEN), then fixed size chunks of SESSION_CHUNK_ROWS reports
+ * header : SESSION_MAGIC, version (quint32), rows per chunk (quint32), chunk size in bytes (quint32),
+ *          creation time in ms since the epoch (qint64), zero padding
+ * chunk  : chunk header (SESSION_CHUNK_HEADER_LEN): rows used (quint32), number of tags (quint32),
+ *                                                   first and last time in ms (qint64, qint64), zero padding
+ *          tag index (SESSION_TAG_INDEX_LEN): one bit per addr16, set if the chunk has reports of that tag
+ *          the columns, one after the other, each SESSION_CHUNK_ROWS wide (see SessionColumn)
+ *
+ * All values are little endian. Every column starts at a multiple of 8 bytes from the start of the file, so the
+ * columns of a mapped file can be read in place. Only whole chunks are ever written, the last one may be partly
+ * used; a file which does not end on a chunk boundary (e.g. an interrupted write) is read up to its last whole chunk.
+ */
+#define SESSION_MAGIC               ("DWSES001")
+#define SESSION_MAGIC_LEN           (8)
+#define SESSION_VERSION             (1)
+#define SESSION_HEADER_LEN          (64)
+#define SESSION_CHUNK_ROWS          (4096)
+#define SESSION_CHUNK_HEADER_LEN    (32)
+#define SESSION_TAG_INDEX_LEN       (65536 / 8)
+
+#define SESSION_ROTATE_BYTES        (512 * 1024 * 1024)     //keeps a file mappable in a 32-bit process
+
+/**
+* @brief SessionColumn
+*        the columns of a chunk, in file order (the widest first, to keep them aligned)
+*/
+enum SessionColumn
+{
+    SessionTime = 0,    //qint64, ms since the epoch
+    SessionRange,       //qint32, mm
+    SessionX,           //qint32, mm
+    SessionY,           //qint32, mm
+    SessionAddr16,      //quint16
+    SessionSeq,         //quint16
+    SessionAngle,       //qint16, deg
+    SessionMode,        //quint16, mode and battery bits as reported (see user_cmd_t)
+    SessionAccX,        //qint16
+    SessionAccY,        //qint16
+    SessionAccZ,        //qint16
+    SessionColumns
+};
+
+/**
+* @brief SessionWriter
+*        fills one chunk in memory and writes it when it is full (or when the file is closed)
+*/
+class SessionWriter
+{
+public:
+    SessionWriter();
+
+    bool open(const QString &path);
+    void close(void);
+    bool isOpen(void) const { return _file.isOpen(); }
+
+    void append(const range_log_t &record);
+
+    /**
+     * @return the size the file will have once the current chunk is written
+     */
+    qint64 size(void) const;
+
+    static int columnWidth(int column);
+    static int columnOffset(int column);    //from the start of the chunk
+    static int chunkLength(void);
+
+private:
+    void writeChunk(void);
+
+    QFile _file;
+    QByteArray _chunk;
+    int _rows;
+    int _tags;
+};
+
+/**
+* @brief SessionReader
+*        maps a session file and selects the reports by tag and time, only the chunks whose time range and tag
+*        index match are looked at, and in those only the time and addr16 columns are scanned
+*/
+class SessionReader
+{
+public:
+    SessionReader();
+    ~SessionReader();
+
+    bool open(const QString &path);
+    void close(void);
+    bool isOpen(void) const { return _data != NULL; }
+
+    int chunks(void) const { return _chunks; }
+    qint64 rows(void) const;
+    qint64 startTime(void) const;
+    qint64 endTime(void) const;
+
+    /**
+     * Append to \a records the reports of the tag \a addr16 (-1: all tags) with \a from <= time <= \a to,
+     * in the order they were recorded.
+     * @return the number of reports appended
+     */
+    int select(int addr16, qint64 from, qint64 to, QVector<range_log_t> *records) const;
+
+private:
+    const uchar *chunk(int i) const;
+
+    QFile _file;
+    const uchar *_data;
+    int _chunks;
+};
+
+#endif // SESSIONFILE_H
@@ -0,0 +1,189 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: SlidingMedian.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "SlidingMedian.h"
+
+#include <algorithm>
+
+SlidingMedian::SlidingMedian(int window) :
+    _window(0),
+    _next(0),
+    _samples(0)
+{
+    setWindow(window);
+}
+
+void SlidingMedian::setWindow(int window)
+{
+    if(window < 3)
+    {
+        window = 3;
+    }
+
+    _window = window;
+
+    _values.resize(window);
+    _pos.resize(window);
+    _order.resize(window);
+    _lo.resize(window / 2);
+    _hi.resize(window - (window / 2));
+
+    clear();
+}
+
+void SlidingMedian::clear(void)
+{
+    _next = 0;
+    _samples = 0;
+}
+
+/**
+* @brief place()
+*        put \a slot at position \a i of the heap and record where it is
+* */
+void SlidingMedian::place(QVector<int> &heap, int i, int slot, bool lo)
+{
+    heap[i] = slot;
+    _pos[slot] = lo ? i : -(i + 1);
+}
+
+void SlidingMedian::siftUp(QVector<int> &heap, int i, bool lo)
+{
+    int slot = heap.at(i);
+
+    while(i > 0)
+    {
+        int parent = (i - 1) / 2;
+
+        if(!before(slot, heap.at(parent), lo))
+        {
+            break;
+        }
+
+        place(heap, i, heap.at(parent), lo);
+        i = parent;
+    }
+
+    place(heap, i, slot, lo);
+}
+
+void SlidingMedian::siftDown(QVector<int> &heap, int i, bool lo)
+{
+    int slot = heap.at(i);
+    int size = heap.size();
+
+    for(;;)
+    {
+        int child = 2 * i + 1;
+
+        if(child >= size)
+        {
+            break;
+        }
+
+        if(((child + 1) < size) && before(heap.at(child + 1), heap.at(child), lo))
+        {
+            child++;
+        }
+
+        if(!before(heap.at(child), slot, lo))
+        {
+            break;
+        }
+
+        place(heap, i, heap.at(child), lo);
+        i = child;
+    }
+
+    place(heap, i, slot, lo);
+}
+
+/**
+* @brief build()
+*        the window has just been filled: split the sorted samples between the two heaps
+*        (ascending order is a valid min-heap, descending a valid max-heap)
+* */
+void SlidingMedian::build(void)
+{
+    int k = _lo.size();
+
+    for(int i = 0; i < _window; i++)
+    {
+        _order[i] = i;
+    }
+
+    std::sort(_order.begin(), _order.end(), [this](int a, int b) { return _values.at(a) < _values.at(b); });
+
+    for(int i = 0; i < k; i++)
+    {
+        place(_lo, i, _order.at(k - 1 - i), true);
+    }
+
+    for(int i = k; i < _window; i++)
+    {
+        place(_hi, i - k, _order.at(i), false);
+    }
+}
+
+void SlidingMedian::add(double value)
+{
+    int slot = _next;
+    int p;
+
+    _next = (_next + 1) % _window;
+    _values[slot] = value;
+
+    if(_samples < _window)
+    {
+        if(++_samples == _window)
+        {
+            build();
+        }
+
+        return;
+    }
+
+    _samples = _window + 1;
+
+    //the new sample replaces the oldest one in its heap
+    p = _pos.at(slot);
+
+    if(p >= 0)
+    {
+        siftUp(_lo, p, true);
+        siftDown(_lo, _pos.at(slot), true);
+    }
+    else
+    {
+        p = -p - 1;
+        siftUp(_hi, p, false);
+        siftDown(_hi, -_pos.at(slot) - 1, false);
+    }
+
+    //only one sample changed, so at most one pair is on the wrong side
+    if(_values.at(_lo.at(0)) > _values.at(_hi.at(0)))
+    {
+        int loTop = _lo.at(0);
+        int hiTop = _hi.at(0);
+
+        place(_lo, 0, hiTop, true);
+        place(_hi, 0, loTop, false);
+
+        siftDown(_lo, 0, true);
+        siftDown(_hi, 0, false);
+    }
+}
+
+double SlidingMedian::median(void) const
+{
+    return (_values.at(_lo.at(0)) + _values.at(_hi.at(0))) / 2;
+}
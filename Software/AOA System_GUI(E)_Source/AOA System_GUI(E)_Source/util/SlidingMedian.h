@@ -0,0 +1,73 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: SlidingMedian.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef SLIDINGMEDIAN_H
+#define SLIDINGMEDIAN_H
+
+#include <QVector>
+
+/**
+ * The SlidingMedian class gives the median of the last \a window samples, updated in O(log N) per sample.
+ *
+ * The window is split in two heaps indexed by the sample's slot in the ring of samples: a max-heap holding the
+ * window/2 smallest samples and a min-heap holding the rest. A new sample overwrites the oldest one in place
+ * and is sifted within its heap, then the heap tops are swapped if they are out of order.
+ * No memory is allocated after setWindow(), not even when the window refills after clear() (a copy of a
+ * SlidingMedian shares the vectors, it gets its own on its first add()).
+ *
+ * median() is the mean of the two middle samples, (s[N/2] + s[N/2-1]) / 2 of the sorted window,
+ * as the motion filter has always used.
+ */
+class SlidingMedian
+{
+public:
+    explicit SlidingMedian(int window = 25);
+
+    /**
+     * Set the window size (must be > 2), this clears the samples.
+     */
+    void setWindow(int window);
+    int window(void) const { return _window; }
+
+    void clear(void);
+
+    void add(double value);
+
+    /**
+     * @return true once the window has been filled and one more sample added
+     *         (when the motion filter has always started to filter)
+     */
+    bool ready(void) const { return _samples > _window; }
+
+    double median(void) const;
+
+private:
+    void build(void);
+    void place(QVector<int> &heap, int i, int slot, bool lo);
+    void siftUp(QVector<int> &heap, int i, bool lo);
+    void siftDown(QVector<int> &heap, int i, bool lo);
+
+    //heap order: for the max-heap (lo) the parent is not smaller, for the min-heap (hi) not bigger
+    bool before(int a, int b, bool lo) const { return lo ? (_values.at(a) > _values.at(b)) : (_values.at(a) < _values.at(b)); }
+
+    QVector<double> _values;    //ring of samples, by slot
+    QVector<int>    _lo;        //max-heap of the slots of the window/2 smallest samples
+    QVector<int>    _hi;        //min-heap of the slots of the other samples
+    QVector<int>    _pos;       //slot -> position in its heap, >= 0 in _lo, -(position + 1) in _hi
+    QVector<int>    _order;     //slots sorted by value, only used by build()
+
+    int _window;
+    int _next;      //slot of the oldest sample, overwritten by the next one
+    int _samples;   //samples added, stops counting at _window + 1
+};
+
+#endif // SLIDINGMEDIAN_H
@@ -0,0 +1,93 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: SpscQueue.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QAtomicInt>
+
+/**
+ * The SpscQueue class is a fixed size, lock-free, single producer / single consumer queue.
+ *
+ * push() may only be called from one thread and pop() from one (other) thread.
+ * The items are copied in and out, so \a T should be a small POD structure.
+ * \a N must be a power of 2. One slot is kept free to tell a full queue from an empty one.
+ */
+template <typename T, int N>
+class SpscQueue
+{
+public:
+    SpscQueue() : _head(0), _tail(0) {}
+
+    /**
+     * Producer side: add \a item at the tail.
+     * @return false if the queue is full (the item is not added)
+     */
+    bool push(const T &item)
+    {
+        int tail = _tail.loadRelaxed();
+        int next = (tail + 1) & (N - 1);
+
+        if(next == _head.loadAcquire())
+        {
+            return false;
+        }
+
+        _items[tail] = item;
+        _tail.storeRelease(next);
+
+        return true;
+    }
+
+    /**
+     * Consumer side: take the item at the head.
+     * @return false if the queue is empty
+     */
+    bool pop(T *item)
+    {
+        int head = _head.loadRelaxed();
+
+        if(head == _tail.loadAcquire())
+        {
+            return false;
+        }
+
+        *item = _items[head];
+        _head.storeRelease((head + 1) & (N - 1));
+
+        return true;
+    }
+
+    /**
+     * @return the number of items in the queue (a snapshot, may be called from either thread)
+     */
+    int size() const
+    {
+        return (_tail.loadAcquire() - _head.loadAcquire()) & (N - 1);
+    }
+
+    int capacity() const { return N - 1; }
+
+private:
+    Q_STATIC_ASSERT_X((N & (N - 1)) == 0, "SpscQueue size must be a power of 2");
+
+    T _items[N];
+
+    //keep the consumer and producer indexes on separate cache lines
+    char _pad0[64];
+    QAtomicInt _head; //next item to pop, written by the consumer
+    char _pad1[64];
+    QAtomicInt _tail; //next free slot, written by the producer
+    char _pad2[64];
+};
+
+#endif // SPSCQUEUE_H
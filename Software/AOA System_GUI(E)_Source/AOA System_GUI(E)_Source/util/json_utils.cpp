@@ -1,32 +1,11 @@
 
-#include "RTLSDisplayApplication.h"
 #include "RTLSClient.h"
+#include "JsFrameDecoder.h"
 #include <json_utils.h>
+#include "LogCategories.h"
 
-typedef struct
-{
-    int                 slot;
-    unsigned long long  addr64;
-    unsigned short      addr16;
-    unsigned short      multFast;
-    unsigned short      multSlow;
-    unsigned short      mode;
-
-    struct{
-        uint16_t    rangeNum;           //number from Tag Poll and Final messages indicates the current range number
-        uint32_t    resTime_us;         //reseption time of Final wrt to SuperFrame start
-        double      pdoa_deg;           //phase differences in degrees
-        double      dist_m;             //distance, m
-        double      xdist_m;            //X distance, m
-        double      ydist_m;            //Y distance, m
-        double      clockOffset_ppm;    //clock offset in ppm
-        uint16_t    vData;              //service message data from the tag: (stationary, etc)
-        int         accX;               //accelerometer X data
-        int         accY;               //accelerometer Y data
-        int         accZ;               //accelerometer Z data
-
-    }twr;
-}tag_data_t;
+#include <limits.h>
+#include <string.h>
 
 typedef struct
 {
@@ -91,7 +70,296 @@ void fromObjToTagData(QJsonObject *pJobj, tag_data_t* tag)
 }
 
 
-int check_json_stream(const QByteArray st)
+/* Fast path for the "TWR" report.
+ *
+ * The TWR object has a fixed, firmware defined, flat key set, so it is scanned in a single pass
+ * straight from the received bytes into tag_data_t, without building a QJsonDocument (no heap allocation).
+ * Only what the firmware emits is accepted: integer numbers and a hex "a16" string.
+ * Anything else (fractions, exponents, escapes, nested values, other root keys, malformed input)
+ * makes the scanner give up, and the frame is parsed by QJsonDocument as before.
+ * The values are converted the same way as fromTwrObjToTagData() does.
+ */
+static inline const char *skipWhitespace(const char *p, const char *end)
+{
+    while((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')))
+    {
+        p++;
+    }
+
+    return p;
+}
+
+/* p points at the opening quote, returns the position after the closing quote or NULL */
+static const char *scanString(const char *p, const char *end, const char **str, int *len)
+{
+    const char *s = ++p;
+
+    while((p < end) && (*p != '"'))
+    {
+        if(*p == '\\')
+        {
+            return NULL; //escapes are left to QJsonDocument
+        }
+        p++;
+    }
+
+    if(p >= end)
+    {
+        return NULL;
+    }
+
+    *str = s;
+    *len = p - s;
+
+    return p + 1;
+}
+
+/* integer number, returns the position after it or NULL */
+static const char *scanInteger(const char *p, const char *end, long long *value)
+{
+    const char *first;
+    long long v = 0;
+    bool negative = false;
+
+    if((p < end) && (*p == '-'))
+    {
+        negative = true;
+        p++;
+    }
+
+    first = p;
+
+    while((p < end) && (*p >= '0') && (*p <= '9'))
+    {
+        if((p - first) >= 15) //keep it exact as a double
+        {
+            return NULL;
+        }
+        v = v * 10 + (*p - '0');
+        p++;
+    }
+
+    if((p == first) || ((*first == '0') && ((p - first) > 1)))
+    {
+        return NULL; //no digits or leading zero
+    }
+
+    if((p < end) && ((*p == '.') || (*p == 'e') || (*p == 'E')))
+    {
+        return NULL; //fractions are left to QJsonDocument
+    }
+
+    *value = negative ? -v : v;
+
+    return p;
+}
+
+/* same as QJsonValue::toInt(): 0 if it does not fit */
+static inline int twrInt(long long v)
+{
+    return ((v >= INT_MIN) && (v <= INT_MAX)) ? (int)v : 0;
+}
+
+unsigned short twr_addr16(unsigned int value)
+{
+    return (value > SHRT_MAX) ? 0 : value;
+}
+
+/* same as QString::toShort(&ok, 16): 0 if it does not fit */
+static bool twrAddr16(const char *s, int len, unsigned short *addr16)
+{
+    int v = 0;
+
+    if((len < 1) || (len > 4))
+    {
+        return false;
+    }
+
+    for(int i = 0; i < len; i++)
+    {
+        char c = s[i];
+
+        if((c >= '0') && (c <= '9'))      v = (v << 4) | (c - '0');
+        else if((c >= 'A') && (c <= 'F')) v = (v << 4) | (c - 'A' + 10);
+        else if((c >= 'a') && (c <= 'f')) v = (v << 4) | (c - 'a' + 10);
+        else return false;
+    }
+
+    *addr16 = twr_addr16(v);
+
+    return true;
+}
+
+static bool setTwrValue(tag_data_t *tag, const char *key, int klen, long long v)
+{
+    if(klen == 1)
+    {
+        switch(key[0])
+        {
+        case 'R': tag->twr.rangeNum = twrInt(v); break;
+        case 'T': tag->twr.resTime_us = twrInt(v); break;
+        case 'D': tag->twr.dist_m = (double)v /100; break;
+        case 'P': tag->twr.pdoa_deg = (double)v; break;
+        case 'O': tag->twr.clockOffset_ppm = (double)v /100; break;
+        case 'V': tag->twr.vData = twrInt(v); break;
+        case 'X': tag->twr.accX = twrInt(v); break;
+        case 'Y': tag->twr.accY = twrInt(v); break;
+        case 'Z': tag->twr.accZ = twrInt(v); break;
+        default: break;
+        }
+    }
+    else if(klen == 3)
+    {
+        if(memcmp(key, "Xcm", 3) == 0)      tag->twr.xdist_m = (double)v /100;
+        else if(memcmp(key, "Ycm", 3) == 0) tag->twr.ydist_m = (double)v /100;
+        else if(memcmp(key, "a16", 3) == 0) return false; //expected as a string
+    }
+
+    return true;
+}
+
+static bool isTwrKey(const char *key, int klen)
+{
+    return ((klen == 1) && (strchr("RTDPOVXYZ", key[0]) != NULL)) ||
+           ((klen == 3) && ((memcmp(key, "Xcm", 3) == 0) || (memcmp(key, "Ycm", 3) == 0)));
+}
+
+/* 'JSxxxx{"TWR": {"a16":"2E5C","R":3,"T":8605,"D":343,"P":1695,"Xcm":165,"Ycm":165,"O":14,"V":1,"X":53015,"Y":60972,"Z":10797}}'
+ * return true if the frame was a TWR report and tag has been filled in
+ */
+static bool fromTwrFrameToTagData(const char *p, int length, tag_data_t *tag)
+{
+    const char *end = p + length;
+    const char *key;
+    int klen;
+
+    p = skipWhitespace(p, end);
+    if((p >= end) || (*p != '{')) return false;
+
+    p = skipWhitespace(p + 1, end);
+    if((p >= end) || (*p != '"')) return false;
+
+    p = scanString(p, end, &key, &klen);
+    if((p == NULL) || (klen != 3) || (memcmp(key, "TWR", 3) != 0)) return false;
+
+    p = skipWhitespace(p, end);
+    if((p >= end) || (*p != ':')) return false;
+
+    p = skipWhitespace(p + 1, end);
+    if((p >= end) || (*p != '{')) return false;
+
+    p = skipWhitespace(p + 1, end);
+    if((p >= end) || (*p == '}')) return false; //an empty TWR object is ignored by check_json_stream()
+
+    memset(&tag->twr, 0, sizeof(tag->twr));
+    tag->addr16 = 0;
+
+    for(;;)
+    {
+        if((p >= end) || (*p != '"')) return false;
+
+        p = scanString(p, end, &key, &klen);
+        if(p == NULL) return false;
+
+        p = skipWhitespace(p, end);
+        if((p >= end) || (*p != ':')) return false;
+
+        p = skipWhitespace(p + 1, end);
+        if(p >= end) return false;
+
+        if(*p == '"')
+        {
+            const char *str;
+            int slen;
+
+            p = scanString(p, end, &str, &slen);
+            if(p == NULL) return false;
+
+            if((klen == 3) && (memcmp(key, "a16", 3) == 0))
+            {
+                if(!twrAddr16(str, slen, &tag->addr16)) return false;
+            }
+            else if(isTwrKey(key, klen))
+            {
+                return false; //expected as a number
+            }
+        }
+        else
+        {
+            long long v;
+
+            p = scanInteger(p, end, &v);
+            if(p == NULL) return false;
+
+            if(!setTwrValue(tag, key, klen, v)) return false;
+        }
+
+        p = skipWhitespace(p, end);
+        if(p >= end) return false;
+
+        if(*p == '}') break;
+        if(*p != ',') return false;
+
+        p = skipWhitespace(p + 1, end);
+    }
+
+    //nothing else is expected after the TWR object
+    p = skipWhitespace(p + 1, end);
+    if((p >= end) || (*p != '}')) return false;
+
+    p = skipWhitespace(p + 1, end);
+
+    return (p == end);
+}
+
+bool parse_twr_scan(const QByteArray &st, tag_data_t *tag)
+{
+    return fromTwrFrameToTagData(st.constData(), st.size(), tag);
+}
+
+bool parse_twr_json(const QByteArray &st, tag_data_t *tag)
+{
+    QString s = QString::fromLatin1(st);
+    QJsonObject TWR = QJsonDocument::fromJson(s.toUtf8()).object().value("TWR").toObject();
+
+    if(TWR.size() == 0)
+    {
+        return false;
+    }
+
+    fromTwrObjToTagData(&TWR, tag);
+
+    return true;
+}
+
+bool parse_twr_bin(const QByteArray &payload, tag_data_t *tag)
+{
+    jb_twr_t twr;
+
+    if(!JsFrameDecoder::twrReport(payload.constData(), payload.size(), &twr))
+    {
+        return false;
+    }
+
+    //same conversions as fromTwrObjToTagData()
+    tag->addr16 = twr_addr16(twr.addr16);
+
+    tag->twr.rangeNum = twr.rangeNum;
+    tag->twr.resTime_us = twr.resTime_us;
+    tag->twr.clockOffset_ppm = (double)twr.clockOffset /100;
+    tag->twr.dist_m = (double)twr.dist_cm /100;
+    tag->twr.pdoa_deg = twr.pdoa_deg;
+    tag->twr.xdist_m = (double)twr.xdist_cm /100;
+    tag->twr.ydist_m = (double)twr.ydist_cm /100;
+    tag->twr.vData = twr.vData;
+    tag->twr.accX = twr.accX;
+    tag->twr.accY = twr.accY;
+    tag->twr.accZ = twr.accZ;
+
+    return true;
+}
+
+int check_json_stream(const QByteArray st, RTLSClient *client)
 {
 /* JSON reporting:
  *
@@ -170,6 +438,33 @@ int check_json_stream(const QByteArray st)
    //JS0035{"SN": {"a16":"0001","V":0,"X":-458,"Y":-83,"Z":876}}
 */
 
+    /* the range reports are by far the most frequent frames, try the fast path first */
+    {
+        tag_data_t tag;
+
+        if(fromTwrFrameToTagData(st.constData(), st.size(), &tag))
+        {
+            client->processRangeAndPDOAReport(
+                                                   tag.addr16,
+                                                   tag.twr.rangeNum,
+                                                   tag.twr.dist_m,
+                                                   tag.twr.xdist_m,
+                                                   tag.twr.ydist_m,
+                                                   tag.twr.pdoa_deg,
+                                                   tag.twr.vData,
+                                                   tag.twr.accX,
+                                                   tag.twr.accY,
+                                                   tag.twr.accZ);
+            return (0);
+        }
+
+        //the service message (SN) is not used, no need to parse it
+        if((st.size() > 5) && (memcmp(st.constData(), "{\"SN\"", 5) == 0))
+        {
+            return (0);
+        }
+    }
+
     QString s = QString::fromLatin1(st);    //this is input from COM-port : JSON string
     QJsonDocument json = QJsonDocument::fromJson(s.toUtf8());
     QJsonObject   obj = json.object();
@@ -190,12 +485,12 @@ int check_json_stream(const QByteArray st)
 
     if(SysCalib.size()>0)
     {
-        qDebug() << QString("Node response: Calibration\r\n") << st;
+        qCDebug(lcParse) << QString("Node response: Calibration\r\n") << st;
 
         calib_data_t  calib;
         fromObjToCalibData(&SysCalib, &calib);
 
-        RTLSDisplayApplication::client()->updatePDOAandRangeOffset(calib.pdoaOffset, calib.distOffset);
+        client->updatePDOAandRangeOffset(calib.pdoaOffset, calib.distOffset);
     }
 
     /* extract data from TWR object */
@@ -204,7 +499,7 @@ int check_json_stream(const QByteArray st)
         tag_data_t tag;
         fromTwrObjToTagData(&TWR, &tag);
 
-        RTLSDisplayApplication::client()->processRangeAndPDOAReport(
+        client->processRangeAndPDOAReport(
                                                tag.addr16,
                                                tag.twr.rangeNum,
                                                tag.twr.dist_m,
@@ -220,7 +515,7 @@ int check_json_stream(const QByteArray st)
 
     if(tagDeleted.size()>0)
     {
-        qDebug() << "Node response: TagDeleted\r\n";
+        qCDebug(lcParse) << "Node response: TagDeleted\r\n";
     }
 
     if(tagAdded.size()>0)
@@ -228,9 +523,9 @@ int check_json_stream(const QByteArray st)
         tag_data_t tag;
         fromObjToTagData(&tagAdded, &tag);
 
-        RTLSDisplayApplication::client()->updateTagAddr16(tag.addr64, tag.addr16);
+        client->updateTagAddr16(tag.addr64, tag.addr16);
 
-        qDebug() << QString("Node response: TagAdded\r\n");
+        qCDebug(lcParse) << QString("Node response: TagAdded\r\n");
     }
 
     if(newAddr64.size()>0)
@@ -238,16 +533,16 @@ int check_json_stream(const QByteArray st)
         bool ok;
         quint64 addr64  = newAddr64.toULongLong(&ok, 16);
 
-        qDebug() << "11111111111111111111111" << newAddr64 << addr64;
+        qCDebug(lcParse) << "Node response: NewTag" << newAddr64 << addr64;
 
         //add new tag into the tag list 64/16 bit address pair
-        RTLSDisplayApplication::client()->addTagToList(addr64);
+        client->addTagToList(addr64);
 
     }
 
     if(!DList.empty())
     {
-        qDebug() << QString("Node response: DList\r\n");
+        qCDebug(lcParse) << QString("Node response: DList\r\n");
 
         for (int i=0; i< DList.size(); i++)
         {
@@ -255,13 +550,13 @@ int check_json_stream(const QByteArray st)
             quint64 addr64  = DList[i].toString().toULongLong(&ok, 16);
 
             //add new tag into the tag list 64/16 bit address pair
-            RTLSDisplayApplication::client()->addTagToList(addr64);
+            client->addTagToList(addr64);
         }
     }
 
     if(!KList.empty())
     {
-        qDebug() << QString("Node response: KList\r\n");
+        qCDebug(lcParse) << QString("Node response: KList\r\n");
 
         for(int i=0; i< KList.size(); i++)
         {
@@ -269,7 +564,7 @@ int check_json_stream(const QByteArray st)
             tag_data_t  tag;
 
             fromObjToTagData(&tobj, &tag);
-            RTLSDisplayApplication::client()->addTagFromKList(tag.slot,
+            client->addTagFromKList(tag.slot,
                                                                  tag.addr64, tag.addr16,
                                                                  tag.multFast, tag.multSlow,
                                                                  tag.mode);
@@ -282,16 +577,17 @@ int check_json_stream(const QByteArray st)
 /* brief
  *      handles input from COM-port : JSON string
  *      and extracts from Info object deviced and version parameters
+ *      and, if asked for, the binary report format the node supports ("Bin", 0 if not present)
  *
  */
-void check_json_version(const QByteArray st, QString *device, QString *version)
+void check_json_version(const QByteArray st, QString *device, QString *version, int *binReport)
 {
     QString s = QString::fromLatin1(st);
     QJsonDocument json = QJsonDocument::fromJson(s.toUtf8());
     QJsonObject   obj = json.object();
     QJsonObject   Info  = obj.value("Info").toObject();
 
-    qDebug() << QString("Node response: Info:\r\n");
+    qCDebug(lcParse) << QString("Node response: Info:\r\n");
 
     QString tmp = Info.value("Version").toString();
     if(tmp.length())
@@ -303,4 +599,9 @@ void check_json_version(const QByteArray st, QString *device, QString *version)
     {
         *device = tmp;
     }
+
+    if(binReport)
+    {
+        *binReport = Info.value("Bin").toInt();
+    }
 }
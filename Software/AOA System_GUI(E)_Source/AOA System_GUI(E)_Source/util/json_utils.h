@@ -14,6 +14,7 @@
 #define __JSON_UTILS_H__
 
 #include "stdio.h"
+#include <stdint.h>
 
 #include <QDebug>
 #include <QString>
@@ -21,7 +22,48 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 
-int  check_json_stream(const QByteArray pd);
-void check_json_version(const QByteArray st, QString *device, QString *version);
+class RTLSClient;
+
+typedef struct
+{
+    int                 slot;
+    unsigned long long  addr64;
+    unsigned short      addr16;
+    unsigned short      multFast;
+    unsigned short      multSlow;
+    unsigned short      mode;
+
+    struct{
+        uint16_t    rangeNum;           //number from Tag Poll and Final messages indicates the current range number
+        uint32_t    resTime_us;         //reseption time of Final wrt to SuperFrame start
+        double      pdoa_deg;           //phase differences in degrees
+        double      dist_m;             //distance, m
+        double      xdist_m;            //X distance, m
+        double      ydist_m;            //Y distance, m
+        double      clockOffset_ppm;    //clock offset in ppm
+        uint16_t    vData;              //service message data from the tag: (stationary, etc)
+        int         accX;               //accelerometer X data
+        int         accY;               //accelerometer Y data
+        int         accZ;               //accelerometer Z data
+
+    }twr;
+}tag_data_t;
+
+//parse the JSON object received from the node and pass its content to the client
+int  check_json_stream(const QByteArray pd, RTLSClient *client);
+void check_json_version(const QByteArray st, QString *device, QString *version, int *binReport = NULL);
+
+//the two ways check_json_stream() parses a "TWR" range report into tag (addr16 and twr), exposed for the tests:
+//the single pass scanner (false if the frame is not a TWR report in the firmware's format, it then falls back)
+//and QJsonDocument (false if the frame has no TWR object)
+bool parse_twr_scan(const QByteArray &st, tag_data_t *tag);
+bool parse_twr_json(const QByteArray &st, tag_data_t *tag);
+
+//the compact binary report (payload of a 'JB' frame) into tag, same units and addr16 as the JSON report
+//(false if it is not a TWR report)
+bool parse_twr_bin(const QByteArray &payload, tag_data_t *tag);
+
+//the 16-bit address as the JSON reports and the tag lists give it: QString::toShort(&ok, 16), i.e. 0 above SHRT_MAX
+unsigned short twr_addr16(unsigned int value);
 
 #endif
@@ -0,0 +1,319 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: DiagnosticsWidget.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "DiagnosticsWidget.h"
+
+#include "RTLSDisplayApplication.h"
+#include "RTLSClient.h"
+#include "LatencyMonitor.h"
+#include "GraphicsWidget.h"
+#include "LogCategories.h"
+#include "PositionFilter.h"
+
+#include <QTableWidget>
+#include <QCheckBox>
+#include <QLabel>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFileDialog>
+#include <QDateTime>
+#include <QTimer>
+#include <math.h>
+
+#ifdef Q_OS_WIN
+#ifndef NOMINMAX
+#define NOMINMAX //LatencyHistogram::min()/max()
+#endif
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+DiagnosticsWidget::DiagnosticsWidget(QWidget *parent) :
+    QWidget(parent)
+{
+    QStringList columns;
+    QStringList filterColumns;
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    QHBoxLayout *buttons = new QHBoxLayout();
+    QHBoxLayout *categories = new QHBoxLayout();
+    QPushButton *reset = new QPushButton(tr("Reset"), this);
+    QPushButton *save = new QPushButton(tr("Save CSV..."), this);
+
+    columns << tr("Count") << tr("Min") << tr("Mean") << tr("P50") << tr("P90") << tr("P99") << tr("P99.9") << tr("Max");
+
+    _table = new QTableWidget(LatencyStages, columns.size(), this);
+    _table->setHorizontalHeaderLabels(columns);
+    _table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _table->setSelectionMode(QAbstractItemView::NoSelection);
+    _table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    _table->setToolTip(tr("Latency of each stage of the range reports in us, "
+                          "from the serial port (readyRead) to the tag moving in the scene"));
+
+    for(int i = 0; i < LatencyStages; i++)
+    {
+        _table->setVerticalHeaderItem(i, new QTableWidgetItem(LatencyMonitor::stageName(i)));
+
+        for(int j = 0; j < columns.size(); j++)
+        {
+            QTableWidgetItem *item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            _table->setItem(i, j, item);
+        }
+    }
+
+    filterColumns << tr("Reports") << tr("Mean (us)") << tr("Max (us)") << tr("Jitter in (cm)") << tr("Jitter out (cm)");
+
+    _filters = new QTableWidget(FilterTypes, filterColumns.size(), this);
+    _filters->setHorizontalHeaderLabels(filterColumns);
+    _filters->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    _filters->setSelectionMode(QAbstractItemView::NoSelection);
+    _filters->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    _filters->setToolTip(tr("Position filters, over all the tags using them (selected from the tag table's context menu): "
+                            "processing time per report, and RMS step between consecutive positions of a tag "
+                            "before and after the filter"));
+
+    for(int i = 0; i < FilterTypes; i++)
+    {
+        _filters->setVerticalHeaderItem(i, new QTableWidgetItem(PositionFilter::typeName(i)));
+
+        for(int j = 0; j < filterColumns.size(); j++)
+        {
+            QTableWidgetItem *item = new QTableWidgetItem();
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            _filters->setItem(i, j, item);
+        }
+    }
+
+    _cpu = new QLabel(this);
+    _cpu->setToolTip(tr("Over the last refresh: CPU time of the viewer (all threads) per second of wall time, "
+                        "time spent moving the tags in the scene and updating their table rows, "
+                        "and the tag updates applied to the scene"));
+
+    //debug builds only: switch the frame pacing off to measure what it saves
+    _coalesce = NULL;
+#ifndef QT_NO_DEBUG
+    _coalesce = new QCheckBox(tr("Coalesce per frame"), this);
+    _coalesce->setChecked(true);
+    _coalesce->setToolTip(tr("Apply the tag updates once per display frame, only the latest of each tag "
+                             "(unchecked: each update is applied as it comes)"));
+#endif
+
+    _updates = new QLabel(this);
+    _updates->setToolTip(tr("Dropped: the GUI fell behind and the client's update queue was full. "
+                            "Merged: a newer update of the same tag arrived before the next display frame."));
+
+    buttons->addWidget(_updates);
+    buttons->addStretch();
+    buttons->addWidget(_cpu);
+    if(_coalesce)
+    {
+        buttons->addWidget(_coalesce);
+        connect(_coalesce, SIGNAL(toggled(bool)), this, SLOT(coalesceToggled(bool)));
+    }
+    buttons->addWidget(reset);
+    buttons->addWidget(save);
+
+    categories->addWidget(new QLabel(tr("Debug output:"), this));
+
+    for(int i = 0; i < LogCategories; i++)
+    {
+        QCheckBox *check = new QCheckBox(QString(logCategory(i).categoryName()).section('.', 1), this);
+
+        check->setProperty("category", i);
+        check->setToolTip(tr("qDebug output of the %1 category").arg(logCategory(i).categoryName()));
+        connect(check, SIGNAL(toggled(bool)), this, SLOT(logCategoryToggled(bool)));
+
+        categories->addWidget(check);
+        _logCategories.append(check);
+    }
+
+    categories->addStretch();
+
+    layout->addWidget(_table);
+    layout->addWidget(_filters);
+    layout->addLayout(buttons);
+    layout->addLayout(categories);
+
+    _timer = new QTimer(this);
+    _timer->setInterval(DIAG_REFRESH_MS);
+
+    connect(_timer, SIGNAL(timeout()), this, SLOT(refresh()));
+    connect(reset, SIGNAL(clicked()), this, SLOT(resetClicked()));
+    connect(save, SIGNAL(clicked()), this, SLOT(saveClicked()));
+
+    _lastCpu_us = 0;
+    _lastScene_ns = 0;
+    _lastSceneCount = 0;
+}
+
+/**
+ * @brief processCpuTime()
+ *        user + system time of the process, in us
+ * */
+static qint64 processCpuTime(void)
+{
+#ifdef Q_OS_WIN
+    FILETIME creation, exited, kernel, user;
+
+    if(!GetProcessTimes(GetCurrentProcess(), &creation, &exited, &kernel, &user))
+    {
+        return 0;
+    }
+
+    //100 ns units
+    return ((((qint64)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime) +
+            (((qint64)user.dwHighDateTime << 32) | user.dwLowDateTime)) / 10;
+#else
+    struct rusage usage;
+
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+
+    return (qint64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+void DiagnosticsWidget::showEvent(QShowEvent *event)
+{
+    //the categories may also have been set from the environment (QT_LOGGING_RULES)
+    for(int i = 0; i < _logCategories.size(); i++)
+    {
+        _logCategories.at(i)->blockSignals(true);
+        _logCategories.at(i)->setChecked(logCategory(i).isDebugEnabled());
+        _logCategories.at(i)->blockSignals(false);
+    }
+
+    if(_coalesce)
+    {
+        _coalesce->blockSignals(true);
+        _coalesce->setChecked(RTLSDisplayApplication::graphicsWidget()->coalesceUpdates());
+        _coalesce->blockSignals(false);
+    }
+
+    //the first refresh only starts the CPU measurement interval
+    _interval.invalidate();
+
+    refresh();
+    _timer->start();
+
+    QWidget::showEvent(event);
+}
+
+void DiagnosticsWidget::hideEvent(QHideEvent *event)
+{
+    _timer->stop();
+
+    QWidget::hideEvent(event);
+}
+
+void DiagnosticsWidget::refresh(void)
+{
+    LatencyHistogram h[LatencyStages];
+
+    RTLSDisplayApplication::client()->latency()->snapshot(h);
+
+    for(int i = 0; i < LatencyStages; i++)
+    {
+        double values[] = { h[i].min() / 1000.0, h[i].mean() / 1000.0,
+                            h[i].percentile(50) / 1000.0, h[i].percentile(90) / 1000.0,
+                            h[i].percentile(99) / 1000.0, h[i].percentile(99.9) / 1000.0,
+                            h[i].max() / 1000.0 };
+
+        _table->item(i, 0)->setText(QString::number(h[i].count()));
+
+        for(int j = 0; j < 7; j++)
+        {
+            _table->item(i, j + 1)->setText(QString::number(values[j], 'f', 1));
+        }
+    }
+
+    for(int i = 0; i < FilterTypes; i++)
+    {
+        filter_stats_t st = RTLSDisplayApplication::client()->filterStats(i);
+        quint64 steps = qMax(st.steps, (quint64)1);
+
+        _filters->item(i, 0)->setText(QString::number(st.count));
+        _filters->item(i, 1)->setText(QString::number((st.count > 0) ? (st.timeSum_us / st.count) : 0, 'f', 2));
+        _filters->item(i, 2)->setText(QString::number(st.timeMax_us, 'f', 1));
+        _filters->item(i, 3)->setText(QString::number(sqrt(st.inStepSq / steps) * 100, 'f', 1));
+        _filters->item(i, 4)->setText(QString::number(sqrt(st.outStepSq / steps) * 100, 'f', 1));
+    }
+
+    {
+        RTLSClient *client = RTLSDisplayApplication::client();
+        GraphicsWidget *graphics = RTLSDisplayApplication::graphicsWidget();
+
+        _updates->setText(tr("Updates dropped: %1 (max queue depth %2/%3), merged: %4, early frames: %5")
+                          .arg(client->droppedUpdates())
+                          .arg(client->updateQueueMaxDepth())
+                          .arg(TAG_UPDATE_QUEUE_LEN - 1)
+                          .arg(graphics->mergedUpdates())
+                          .arg(graphics->earlyFrames()));
+    }
+
+    {
+        qint64 cpu = processCpuTime();
+        qint64 scene = h[LatencyScene].sum();
+        quint64 count = h[LatencyScene].count();
+
+        if(_interval.isValid() && (_interval.elapsed() > 0) && (count >= _lastSceneCount))
+        {
+            double ms = _interval.elapsed();
+
+            _cpu->setText(tr("CPU: %1%, scene: %2 ms/s, %3 updates/s")
+                          .arg(100.0 * (cpu - _lastCpu_us) / (ms * 1000), 0, 'f', 1)
+                          .arg((scene - _lastScene_ns) / (ms * 1000), 0, 'f', 1)
+                          .arg((count - _lastSceneCount) * 1000 / ms, 0, 'f', 0));
+        }
+
+        _interval.start();
+        _lastCpu_us = cpu;
+        _lastScene_ns = scene;
+        _lastSceneCount = count;
+    }
+}
+
+void DiagnosticsWidget::resetClicked(void)
+{
+    RTLSDisplayApplication::client()->latency()->reset();
+    RTLSDisplayApplication::client()->resetFilterStats();
+
+    refresh();
+}
+
+void DiagnosticsWidget::coalesceToggled(bool enabled)
+{
+    RTLSDisplayApplication::graphicsWidget()->setCoalesceUpdates(enabled);
+}
+
+void DiagnosticsWidget::saveClicked(void)
+{
+    QString path = QFileDialog::getSaveFileName(this, tr("Save latency histograms"),
+                                                QString("Latency_%1.csv").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")),
+                                                tr("CSV files (*.csv)"));
+
+    if(!path.isEmpty())
+    {
+        RTLSDisplayApplication::client()->latency()->writeCsv(path);
+    }
+}
+
+void DiagnosticsWidget::logCategoryToggled(bool enabled)
+{
+    setLogCategoryEnabled(sender()->property("category").toInt(), enabled);
+}
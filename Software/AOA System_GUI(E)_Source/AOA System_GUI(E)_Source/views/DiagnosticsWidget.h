@@ -0,0 +1,73 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: DiagnosticsWidget.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef DIAGNOSTICSWIDGET_H
+#define DIAGNOSTICSWIDGET_H
+
+#include <QWidget>
+#include <QList>
+#include <QElapsedTimer>
+
+class QCheckBox;
+class QTableWidget;
+class QLabel;
+class QTimer;
+
+#define DIAG_REFRESH_MS     (1000)  //refresh period while the panel is visible
+
+/**
+ * The DiagnosticsWidget class shows the latency of each stage of the range reports (see LatencyMonitor):
+ * count, min, mean, percentiles and max in us, refreshed once a second while it is visible,
+ * and how many position updates were dropped by the client or merged before they were shown.
+ * Below it, for each position filter type: the reports it filtered, its processing time, and the jitter
+ * (RMS step between consecutive positions of a tag) of the reported and of the filtered positions.
+ * The CPU use of the process, the time spent moving the tags in the scene and the tag updates per second are
+ * shown for the last refresh interval. In debug builds, applying the updates once per display frame can be
+ * switched off to compare them with each update applied as it comes (e.g. rtlssim --tags 200 --rate 10).
+ * The histograms can be reset (e.g. before a test run) and saved to a CSV file.
+ * The debug output of each log category (see LogCategories.h) can be switched on and off.
+ */
+class DiagnosticsWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticsWidget(QWidget *parent = 0);
+
+protected:
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+
+protected slots:
+    void refresh(void);
+    void resetClicked(void);
+    void saveClicked(void);
+    void logCategoryToggled(bool enabled);
+    void coalesceToggled(bool enabled);
+
+private:
+    QTableWidget *_table;
+    QTableWidget *_filters;
+    QLabel *_updates;
+    QLabel *_cpu;
+    QCheckBox *_coalesce;   //debug builds only, NULL otherwise
+    QList<QCheckBox *> _logCategories;
+    QTimer *_timer;
+
+    //CPU use of the process and time spent in the scene stage since the last refresh
+    QElapsedTimer _interval;
+    qint64 _lastCpu_us;
+    qint64 _lastScene_ns;
+    quint64 _lastSceneCount;
+};
+
+#endif // DIAGNOSTICSWIDGET_H
@@ -0,0 +1,64 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: EllipseItemPool.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "EllipseItemPool.h"
+
+#include <QGraphicsScene>
+#include <QGraphicsEllipseItem>
+#include <QBrush>
+#include <QPen>
+
+EllipseItemPool::EllipseItemPool(QGraphicsScene *scene) :
+    _scene(scene),
+    _created(0)
+{
+}
+
+QGraphicsEllipseItem *EllipseItemPool::acquire(const QRectF &rect)
+{
+    QGraphicsEllipseItem *item;
+
+    if(_free.isEmpty())
+    {
+        _created++;
+        return _scene->addEllipse(rect, QPen(Qt::NoPen));
+    }
+
+    item = _free.takeLast();
+
+    //reset whatever the previous user changed
+    if(item->rect() != rect)
+    {
+        item->setRect(rect);
+    }
+    item->setPen(Qt::NoPen);
+    item->setBrush(Qt::NoBrush);
+    item->setOpacity(1);
+    item->setToolTip(QString());
+    item->setVisible(true);
+
+    return item;
+}
+
+void EllipseItemPool::release(QGraphicsEllipseItem *item)
+{
+    if(item)
+    {
+        item->setVisible(false);
+        _free.append(item);
+    }
+}
+
+void EllipseItemPool::clear(void)
+{
+    _free.clear();
+}
@@ -0,0 +1,60 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: EllipseItemPool.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef ELLIPSEITEMPOOL_H
+#define ELLIPSEITEMPOOL_H
+
+#include <QVector>
+#include <QRectF>
+
+class QGraphicsScene;
+class QGraphicsEllipseItem;
+
+/**
+ * The EllipseItemPool class recycles the ellipse items of a scene (the tag markers and history points).
+ *
+ * A released item is only hidden: it stays in the scene and in its index, and the next acquire() moves it
+ * back into use. Adding, removing and deleting items on every history reset or lost tag is what makes
+ * QGraphicsScene rebuild its BSP tree, the pool keeps the set of items in the scene stable instead.
+ * All the pooled items are owned by the scene.
+ */
+class EllipseItemPool
+{
+public:
+    explicit EllipseItemPool(QGraphicsScene *scene);
+
+    /**
+     * Take a visible item with the given \a rect, opacity 1, no pen, no brush and no tool tip.
+     * A new item is only added to the scene if there is no free one.
+     */
+    QGraphicsEllipseItem *acquire(const QRectF &rect);
+
+    /**
+     * Hide \a item and keep it for the next acquire(). NULL is ignored.
+     */
+    void release(QGraphicsEllipseItem *item);
+
+    /**
+     * Forget the free items without touching them, e.g. when the scene which owns them is going to be deleted.
+     */
+    void clear(void);
+
+    int created(void) const { return _created; }
+    int available(void) const { return _free.size(); }
+
+private:
+    QGraphicsScene *_scene;
+    QVector<QGraphicsEllipseItem *> _free;
+    int _created;   //items added to the scene by the pool so far
+};
+
+#endif // ELLIPSEITEMPOOL_H
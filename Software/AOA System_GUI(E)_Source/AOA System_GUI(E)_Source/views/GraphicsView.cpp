@@ -21,6 +21,8 @@
 #include <QDebug>
 #include <QWheelEvent>
 #include <QScrollBar>
+#include <QGraphicsPixmapItem>
+#include <QPainter>
 #include <qmath.h>
 
 #define SNAP_TO_Y_COORD (0.5)  //used to fix the botom ("top") of the visible rectangle
@@ -28,6 +30,8 @@
 GraphicsView::GraphicsView(QWidget *parent) :
     QGraphicsView(parent),
     _tool(NULL),
+    _tiles(BG_CACHE_KB),
+    _originItem(NULL),
     _mouseContext(DefaultMouseContext)
 {
     setMouseTracking(true);
@@ -51,6 +55,9 @@ GraphicsView::GraphicsView(QWidget *parent) :
 void GraphicsView::onReady()
 {
     QObject::connect(RTLSDisplayApplication::viewSettings(), SIGNAL(floorplanChanged()), this, SLOT(floorplanChanged()));
+    QObject::connect(RTLSDisplayApplication::viewSettings(), SIGNAL(showGO(bool, bool)), this, SLOT(showOriginGrid(bool, bool)));
+
+    updateOriginItem();
 
 
    // QObject::connect(this, SIGNAL(scaleNode(qreal, qreal)), RTLSDisplayApplication::graphicsWidget(), SLOT(scaleNode(qreal, qreal)));
@@ -304,37 +311,33 @@ void GraphicsView::drawOrigin(QPainter *painter)
     QPointF p(0, 0);
     painter->setPen(QPen(QBrush(Qt::red), 0));
     painter->drawEllipse(p, 0.05, 0.05);
+}
+
+/**
+* @brief updateOriginItem()
+*        the node icon at the origin is an item of the scene: add it once and only show/hide it afterwards
+*        (it used to be added again by every repaint of the background)
+* */
+void GraphicsView::updateOriginItem(void)
+{
+    bool show = RTLSDisplayApplication::viewSettings()->originShow();
+
+    if(!_originItem && show && this->scene())
     {
         QPixmap pm(":/node.png");
-        //QPixmap pm1 = pm.scaledToHeight(10, Qt::FastTransformation);
-
-        QGraphicsPixmapItem *pixmap;
-        //pm.setZValue(1);
-        //pm.setOpacity(1);
-        //pm.setFlag(QGraphicsItem::ItemIgnoresTransformations);
-        //painter->save();
-        //painter->drawPixmap(0,0,pm) ;
-        //painter->drawPixmap(-10,-10,pm1) ;
-        //painter->drawRect(0, 0, pm.width(), pm.height());
-        //painter->restore();
-
-#if 1
-    {
-        //QPixmap pm(":/node.png");
-        pixmap = this->scene()->addPixmap(pm) ;
-        pixmap->setZValue(1);
-        pixmap->setOpacity(1);
-        pixmap->setFlag(QGraphicsItem::ItemIgnoresTransformations);
-
-        //pixmap->setPos((pixmap->boundingRect().height()/2)*0.1, (-pixmap->boundingRect().width()/2)*0.1);
-        //QRectF r=pixmap->boundingRect();
-        //pixmap->setPos(0-r.width()/2,0-r.height()/2);
-        QRectF pixRect = pixmap->boundingRect();
-        pixmap->setPos(-(pixRect.width()/2)*0.01, pixRect.height()*0.01);
-
-        //qDebug() << pixmap->x() << pixmap->boundingRect().width() ;
+
+        _originItem = this->scene()->addPixmap(pm);
+        _originItem->setZValue(1);
+        _originItem->setOpacity(1);
+        _originItem->setFlag(QGraphicsItem::ItemIgnoresTransformations);
+
+        QRectF pixRect = _originItem->boundingRect();
+        _originItem->setPos(-(pixRect.width()/2)*0.01, pixRect.height()*0.01);
     }
-#endif
+
+    if(_originItem)
+    {
+        _originItem->setVisible(show);
     }
 }
 
@@ -373,16 +376,17 @@ void GraphicsView::drawGrid(QPainter *painter, const QRectF &rect)
 
 void GraphicsView::drawFloorplan(QPainter *painter, const QRectF &rect)
 {
-    Q_UNUSED(rect)
+    FloorplanPyramid &fp = RTLSDisplayApplication::viewSettings()->floorplan();
 
-    const QPixmap & pm = RTLSDisplayApplication::viewSettings()->floorplanPixmap();
-    if (!pm.isNull())
+    if (!fp.isNull())
     {
+        QTransform t = RTLSDisplayApplication::viewSettings()->floorplanTransform();
+
         painter->save();
-        painter->setTransform(RTLSDisplayApplication::viewSettings()->floorplanTransform(), true);
+        painter->setTransform(t, true);
         painter->setPen(QPen(QBrush(Qt::black), 1));
-        painter->drawPixmap(0, 0, pm);
-        painter->drawRect(0, 0, pm.width(), pm.height());
+        fp.draw(painter, t.inverted().mapRect(rect)); //only the tiles in rect, at the level of the current zoom
+        painter->drawRect(0, 0, fp.width(), fp.height());
         painter->restore();
     }
 }
@@ -397,20 +401,130 @@ void GraphicsView::drawForeground(QPainter *painter, const QRectF &rect)
 
 void GraphicsView::drawBackground(QPainter *painter, const QRectF &rect)
 {
+    ViewSettings *settings = RTLSDisplayApplication::viewSettings();
+    int contents = 0;
+
     QGraphicsView::drawBackground(painter, rect);
 
-    if(RTLSDisplayApplication::viewSettings()->getFloorplanShow())
+    if(settings->getFloorplanShow() && !settings->floorplan().isNull())
+    {
+        contents |= BG_FLOORPLAN;
+    }
+
+    if(settings->gridShow()) //draw grip if show grid is set
     {
-        drawFloorplan(painter, rect);
+        contents |= BG_GRID;
     }
 
-    if(RTLSDisplayApplication::viewSettings()->gridShow()) //draw grip if show grid is set
-        drawGrid(painter, rect);
+    //not a plain scale and translation (e.g. rendering to a printer): draw it directly
+    if(contents && !drawBackgroundTiles(painter, rect, contents))
+    {
+        if(contents & BG_FLOORPLAN)
+            drawFloorplan(painter, rect);
+
+        if(contents & BG_GRID)
+            drawGrid(painter, rect);
+    }
 
-    if(RTLSDisplayApplication::viewSettings()->originShow()) //draw origin if show origin is set
+    if(settings->originShow()) //draw origin if show origin is set
         drawOrigin(painter);
 }
 
+/**
+* @brief drawBackgroundTiles()
+*        blit the cached tiles covering \a rect, rendering the missing ones.
+*        The tiles are laid out in device pixels without the view's translation, so panning reuses them.
+*        return false if the painter's transform is not a scale and translation
+* */
+bool GraphicsView::drawBackgroundTiles(QPainter *painter, const QRectF &rect, int contents)
+{
+    QTransform t = painter->worldTransform();
+
+    if(t.type() > QTransform::TxScale)
+    {
+        return false;
+    }
+
+    qreal zoomX = t.m11();
+    qreal zoomY = t.m22();
+    QPoint offset(qRound(t.dx()), qRound(t.dy()));
+    QRectF device = QRectF(t.mapRect(rect)).translated(-t.dx(), -t.dy());
+    int i0 = qFloor(device.left() / BG_TILE_SIZE);
+    int i1 = qFloor(device.right() / BG_TILE_SIZE);
+    int j0 = qFloor(device.top() / BG_TILE_SIZE);
+    int j1 = qFloor(device.bottom() / BG_TILE_SIZE);
+    BackgroundTileKey key;
+
+    key.zoomX = qRound64(zoomX * BG_ZOOM_KEY);
+    key.zoomY = qRound64(zoomY * BG_ZOOM_KEY);
+    key.contents = contents;
+    key.dpr = qRound(devicePixelRatioF() * 100);
+
+    painter->save();
+    painter->resetTransform();
+
+    for(int i = i0; i <= i1; i++)
+    {
+        for(int j = j0; j <= j1; j++)
+        {
+            QPixmap *cached;
+
+            key.i = i;
+            key.j = j;
+
+            cached = _tiles.object(key);
+
+            if(cached)
+            {
+                painter->drawPixmap(offset + QPoint(i * BG_TILE_SIZE, j * BG_TILE_SIZE), *cached);
+            }
+            else
+            {
+                QPixmap tile = renderBackgroundTile(i, j, zoomX, zoomY, contents, painter->renderHints());
+                int cost = (tile.width() * tile.height() * tile.depth() / 8) / 1024;
+
+                painter->drawPixmap(offset + QPoint(i * BG_TILE_SIZE, j * BG_TILE_SIZE), tile);
+
+                _tiles.insert(key, new QPixmap(tile), cost);
+            }
+        }
+    }
+
+    painter->restore();
+
+    return true;
+}
+
+/**
+* @brief renderBackgroundTile()
+*        draw the floorplan and/or grid of tile (\a i, \a j) at the given zoom into a transparent pixmap
+* */
+QPixmap GraphicsView::renderBackgroundTile(int i, int j, qreal zoomX, qreal zoomY, int contents, QPainter::RenderHints hints)
+{
+    qreal dpr = devicePixelRatioF();
+    QPixmap tile(qCeil(BG_TILE_SIZE * dpr), qCeil(BG_TILE_SIZE * dpr));
+    QTransform t(zoomX, 0, 0, zoomY, -i * BG_TILE_SIZE, -j * BG_TILE_SIZE); //scene -> tile
+    QRectF rect = t.inverted().mapRect(QRectF(0, 0, BG_TILE_SIZE, BG_TILE_SIZE));
+
+    tile.setDevicePixelRatio(dpr);
+    tile.fill(Qt::transparent);
+
+    {
+        QPainter painter(&tile);
+
+        painter.setRenderHints(hints);
+        painter.setTransform(t);
+
+        if(contents & BG_FLOORPLAN)
+            drawFloorplan(&painter, rect);
+
+        if(contents & BG_GRID)
+            drawGrid(&painter, rect);
+    }
+
+    return tile;
+}
+
 void GraphicsView::setTool(AbstractTool *tool)
 {
     if (_tool)
@@ -432,6 +546,21 @@ void GraphicsView::setTool(AbstractTool *tool)
 
 void GraphicsView::floorplanChanged()
 {
+    //the floorplan, its transform or the grid has changed
+    _tiles.clear();
+
+    if (this->scene())
+        this->scene()->update();
+}
+
+void GraphicsView::showOriginGrid(bool origin, bool grid)
+{
+    Q_UNUSED(origin)
+    Q_UNUSED(grid)
+
+    _tiles.clear();
+    updateOriginItem();
+
     if (this->scene())
         this->scene()->update();
 }
@@ -14,10 +14,47 @@
 #define GRAPHICSVIEW_H
 
 #include <QGraphicsView>
+#include <QCache>
+#include <QPixmap>
 
 class QGestureEvent;
+class QGraphicsPixmapItem;
 class AbstractTool;
 
+#define BG_TILE_SIZE        (256)           //size of a background tile in (device independent) pixels
+#define BG_CACHE_KB         (32 * 1024)     //memory limit of the background tile cache
+#define BG_ZOOM_KEY         (10000.0)       //the zoom of a tile is keyed in 1/BG_ZOOM_KEY pixels per metre
+
+#define BG_FLOORPLAN        (0x1)           //contents of a tile
+#define BG_GRID             (0x2)
+
+/**
+ * @brief BackgroundTileKey
+ *        identifies a cached background tile: the zoom level (pixels per metre in x and y, the y is negative
+ *        as the view is flipped), the tile column/row and what was drawn into it
+ */
+struct BackgroundTileKey
+{
+    qint64 zoomX;
+    qint64 zoomY;
+    int i;
+    int j;
+    int contents;   //BG_FLOORPLAN | BG_GRID
+    int dpr;        //device pixel ratio * 100
+};
+
+inline bool operator==(const BackgroundTileKey &a, const BackgroundTileKey &b)
+{
+    return (a.zoomX == b.zoomX) && (a.zoomY == b.zoomY) && (a.i == b.i) && (a.j == b.j) &&
+           (a.contents == b.contents) && (a.dpr == b.dpr);
+}
+
+inline uint qHash(const BackgroundTileKey &key, uint seed = 0)
+{
+    return qHash(key.zoomX, seed) ^ qHash(key.zoomY, seed) ^ qHash((key.i << 16) ^ key.j, seed) ^
+           (uint)(key.contents << 28) ^ (uint)key.dpr;
+}
+
 /**
  * The GraphicsView class draws the scene and provides user interaction using the mouse.
  *
@@ -48,6 +85,14 @@ class AbstractTool;
  * Whenever the visible rectangle changes, for any reason, the visibleRectChanged() signal is called.
  * @endparblock
  *
+ * @par Background
+ * @parblock
+ * The floorplan and the grid are rendered into tiles of BG_TILE_SIZE pixels, laid out at the current zoom level
+ * and kept in a cache, so a repaint (e.g. because a tag moved, or the view was panned) only blits the tiles.
+ * The tiles are rendered again after a zoom, and the cache is cleared by ViewSettings::floorplanChanged()
+ * (floorplan, its transform, grid size or grid shown) and ViewSettings::showGO().
+ * @endparblock
+ *
  * @par Tool
  * Tools allow simple interaction inside the scene. A new tool can be set using setTool(). The tool then remains active until it's AbstractTool::done() signal is emitted. \n
  * When ESC button or right click is pressed, the view attempts to cancel the tool by calling AbstractTool::cancel().
@@ -114,6 +159,7 @@ protected slots:
     void onReady();
 
     void floorplanChanged();
+    void showOriginGrid(bool origin, bool grid);
 
     void toolDone();
     void toolDestroyed();
@@ -137,6 +183,9 @@ protected:
     void drawGrid(QPainter *painter, const QRectF &rect);
     void drawOrigin(QPainter *painter);
     void drawFloorplan(QPainter *painter, const QRectF &rect);
+    bool drawBackgroundTiles(QPainter *painter, const QRectF &rect, int contents);
+    QPixmap renderBackgroundTile(int i, int j, qreal zoomX, qreal zoomY, int contents, QPainter::RenderHints hints);
+    void updateOriginItem(void);
     virtual void drawForeground(QPainter *painter, const QRectF &rect);
     virtual void drawBackground(QPainter *painter, const QRectF &rect);
 
@@ -149,6 +198,9 @@ private:
 
     bool _ignoreContextMenu;
 
+    QCache<BackgroundTileKey, QPixmap> _tiles;  //cost is in KB
+    QGraphicsPixmapItem *_originItem;           //node icon at the origin
+
     /**
      * @brief The MouseContext enum represents the possible states of mouse interaction.
      * Depending on the context, the mouse events will be handled differently.
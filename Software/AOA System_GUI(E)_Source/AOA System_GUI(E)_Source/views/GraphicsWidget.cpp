@@ -15,6 +15,9 @@
 
 #include "RTLSDisplayApplication.h"
 #include "ViewSettings.h"
+#include "EllipseItemPool.h"
+#include "TrailItem.h"
+#include "LogCategories.h"
 
 #include <QDomDocument>
 #include <QGraphicsScene>
@@ -28,10 +31,13 @@
 #include <QGuiApplication>
 #include <QScreen>
 #include <QComboBox>
+#include <QMenu>
 
 #define PEN_WIDTH (0.05)
 #define NODE_SIZE (100) // area to cover has a diameter of 100m ....
 #define FONT_SIZE (10)
+#define FRAME_PERIOD_MS (16) //the tag updates are applied to the scene at most once per display frame (~60 Hz)
+#define FRAME_PENDING_MAX (256) //tags waiting for the next frame, a new tag beyond this applies the frame early
 
 GraphicsWidget::GraphicsWidget(QWidget *parent) :
     QWidget(parent),
@@ -46,41 +52,36 @@ GraphicsWidget::GraphicsWidget(QWidget *parent) :
     ui->setupUi(this);
 
     this->_scene = new QGraphicsScene(this);
+    _itemPool = new EllipseItemPool(_scene);
 
     ui->graphicsView->setScene(this->_scene);
     ui->graphicsView->scale(1, -1);
     ui->graphicsView->setBaseSize(this->height()*0.75, this->width());
 
     //tagTable
-    //Tag ID, x, y, range, ...
-    QStringList tableHeader;
-	tableHeader << "Tag ID/Label" << "Joined" << "X\n(m)" << "Y\n(m)" << "Range (m)" << "Angle (°)"
-				<< "SOS Alarm" << "Battery (V)" << "CHG"
-				<< "Acc X" << "Acc Y" << "Acc Z"
-				<< "Cali Dist" << "Cali Angle";
-
-
-    ui->tagTable->setHorizontalHeaderLabels(tableHeader);
-
-    ui->tagTable->setColumnWidth(ColumnID,170);    	//ID
-    ui->tagTable->setColumnWidth(ColumnJoin,70); 	//join
-    ui->tagTable->setColumnWidth(ColumnX,55); 		//x
-    ui->tagTable->setColumnWidth(ColumnY,55); 		//y
-    ui->tagTable->setColumnWidth(ColumnRA0,70);		//Range
-    ui->tagTable->setColumnWidth(ColumnAngle,55);	//Angle	
-
-    ui->tagTable->setColumnWidth(ColumnAlarm,70);
-    ui->tagTable->setColumnWidth(ColumnBattery,70);
-    ui->tagTable->setColumnWidth(ColumnCHRG,70);
-    ui->tagTable->setColumnWidth(Column_AccX,70);
-    ui->tagTable->setColumnWidth(Column_AccY,70);
-    ui->tagTable->setColumnWidth(Column_AccZ,70);
-    ui->tagTable->setColumnWidth(ColumnOffRange,70);
-    ui->tagTable->setColumnWidth(ColumnOffPDoa,70);
+    //Tag ID, x, y, range, ... (the header labels are given by the model)
+    _tagModel = new TagTableModel(this);
+    ui->tagTable->setModel(_tagModel);
+
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnID,170);    	//ID
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnJoin,70); 	//join
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnX,55); 		//x
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnY,55); 		//y
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnRA0,70);		//Range
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnAngle,55);	//Angle	
+
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnAlarm,70);
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnBattery,70);
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnCHRG,70);
+    ui->tagTable->setColumnWidth(TagTableModel::Column_AccX,70);
+    ui->tagTable->setColumnWidth(TagTableModel::Column_AccY,70);
+    ui->tagTable->setColumnWidth(TagTableModel::Column_AccZ,70);
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnOffRange,70);
+    ui->tagTable->setColumnWidth(TagTableModel::ColumnOffPDoa,70);
 
     //久凌电子
-    ui->tagTable->setColumnHidden(ColumnIDr, true); //ID raw hex
-    //ui->tagTable->setColumnWidth(ColumnIDr,70); //ID raw hex
+    ui->tagTable->setColumnHidden(TagTableModel::ColumnIDr, true); //ID raw hex
+    //ui->tagTable->setColumnWidth(TagTableModel::ColumnIDr,70); //ID raw hex
 
     if(desktopWidth <= 800)
     {
@@ -90,6 +91,9 @@ GraphicsWidget::GraphicsWidget(QWidget *parent) :
 
     _selectedTagIdx = -1;
 
+    _defaultFilter = FilterNone;
+    _filterWindow = FILTER_SIZE;
+
     //set defaults
     _tagSize = 0.15;
     _nodeSize = NODE_SIZE;
@@ -97,8 +101,17 @@ GraphicsWidget::GraphicsWidget(QWidget *parent) :
     _showHistoryP = _showHistory = false;
     _showRange = false;
 
-    _busy = true ;
-    _ignore = true;
+    _droppedUpdates = 0;
+    _mergedUpdates = 0;
+    _earlyFrames = 0;
+    _coalesce = true;
+
+    //started by the first update of a frame, so there are no wake-ups while no reports come in
+    _frameTimer = new QTimer(this);
+    _frameTimer->setSingleShot(true);
+    _frameTimer->setTimerType(Qt::PreciseTimer);
+    _frameTimer->setInterval(FRAME_PERIOD_MS);
+    connect(_frameTimer, SIGNAL(timeout()), this, SLOT(applyUpdates()));
 
     //periodic timer, to periodically check if tags are present
     //this timer is started on reception of onReady() signal
@@ -115,9 +128,11 @@ void GraphicsWidget::onReady()
     QObject::connect(this, SIGNAL(centerAt(double,double)), graphicsView(), SLOT(centerAt(double, double)));
     QObject::connect(this, SIGNAL(centerRect(QRectF)), graphicsView(), SLOT(centerRect(QRectF)));
 
-    QObject::connect(ui->tagTable, SIGNAL(cellChanged(int, int)), this, SLOT(tagTableChanged(int, int)));
-    QObject::connect(ui->tagTable, SIGNAL(cellClicked(int, int)), this, SLOT(tagTableClicked(int, int)));
-    QObject::connect(ui->tagTable, SIGNAL(itemSelectionChanged()), this, SLOT(itemSelectionChanged()));
+    QObject::connect(ui->tagTable, SIGNAL(clicked(QModelIndex)), this, SLOT(tagTableClicked(QModelIndex)));
+    ui->tagTable->setContextMenuPolicy(Qt::CustomContextMenu);
+    QObject::connect(ui->tagTable, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(tagTableContextMenu(QPoint)));
+    QObject::connect(_tagModel, SIGNAL(joinedChanged(quint64, bool)), this, SLOT(tagJoinedChanged(quint64, bool)));
+    QObject::connect(_tagModel, SIGNAL(showLabelChanged(quint64, bool)), this, SLOT(tagShowLabelChanged(quint64, bool)));
 
     //QObject::connect(ui->tagTable, SIGNAL(cellDoubleClicked(int, int)), this, SLOT(tagTableDoubleClicked(int, int)));
 
@@ -125,12 +140,11 @@ void GraphicsWidget::onReady()
     _timer->start();
 
     QObject::connect(_signalMapper, SIGNAL(mapped(const QString &)), this, SLOT(tableComboChanged(const QString &)));
-
-    _busy = false ;
 }
 
 GraphicsWidget::~GraphicsWidget()
 {
+    delete _itemPool;
     delete _scene;
     delete ui;
 }
@@ -253,148 +267,197 @@ void GraphicsWidget::tableComboChanged(QString position)
     int row = coordinates[0].toInt();
     int col = coordinates[1].toInt();
 
-    tagTableClicked(row, col);
+    tagTableClicked(_tagModel->index(row, col));
     //QComboBox* combo=(QComboBox*)table->cellWidget(row, col);
     //tag->fastrate = indexToRates[cbox->currentIndex()];
 }
 
+/**
+ * @fn    sendToNode
+ * @brief  queue a command to the serial connection's command queue (it lives in the I/O thread),
+ *         \a reply is the root element name of the node's reply to wait for (none: pause for \a timeout ms)
+ *
+ * */
+void GraphicsWidget::sendToNode(const QByteArray &cmd, const QByteArray &reply, int timeout)
+{
+    QMetaObject::invokeMethod(RTLSDisplayApplication::serialConnection(), "queueCommand", Qt::QueuedConnection,
+                              Q_ARG(QByteArray, cmd), Q_ARG(QByteArray, reply), Q_ARG(int, timeout), Q_ARG(int, 0));
+}
 
-void GraphicsWidget::itemSelectionChanged(void)
+void GraphicsWidget::tagTableClicked(const QModelIndex &index)
 {
-    QList <QTableWidgetItem *>  l = ui->tagTable->selectedItems();
+    _selectedTagIdx = index.row();
 }
 
-void GraphicsWidget::tagTableChanged(int r, int c)
+/**
+ * @fn    tagTableContextMenu
+ * @brief  select the position filter of the tag under the mouse or of all the tags, and the median filter's window
+ *         (the cost and jitter of each filter are in the Diagnostics window)
+ *
+ * */
+void GraphicsWidget::tagTableContextMenu(const QPoint &pos)
 {
-    if(!_ignore)
+    QModelIndex index = ui->tagTable->indexAt(pos);
+    RTLSClient *client = RTLSDisplayApplication::client();
+    QMenu menu(this);
+    QMenu *tagMenu = NULL;
+    QMenu *allMenu;
+    QAction *window;
+    QAction *chosen;
+    quint64 id64 = 0;
+
+    if(index.isValid())
     {
-        Tag *tag = NULL;
-        bool ok;
-        quint64 tagId = (ui->tagTable->item(r,ColumnIDr)->text()).toULongLong(&ok, 16);
-        tag = _tags.value(tagId, NULL);
+        const tag_row_t &row = _tagModel->tag(index.row());
 
-        if(!tag) return;
+        id64 = row.id64;
+        tagMenu = menu.addMenu(tr("Position filter of %1").arg(row.label));
+    }
 
-        if(c == ColumnID) //label has changed
-        {
-            QString newLabel = ui->tagTable->item(r,ColumnID)->text();
+    allMenu = menu.addMenu(tr("Position filter of all tags"));
 
-            tag->tagLabelStr = newLabel;
-            tag->tagLabel->setText(newLabel);
+    for(int type = 0; type < FilterTypes; type++)
+    {
+        QAction *all = allMenu->addAction(PositionFilter::typeName(type));
 
-            //update the map
-            QMap<quint64, QString>::iterator i = _tagLabels.find(tagId);
+        all->setCheckable(true);
+        all->setChecked(type == _defaultFilter);
+        all->setData(type);
 
-            if(i == _tagLabels.end()) //did not find the label
-            {
-                //insert the new value
-                _tagLabels.insert(tagId, newLabel);
-            }
-            else //if (i != taglabels.end()) // && i.key() == tagId)
-            {
-                _tagLabels.erase(i); //erase the key
-                _tagLabels.insert(tagId, newLabel);
-            }
+        if(tagMenu)
+        {
+            QAction *one = tagMenu->addAction(PositionFilter::typeName(type));
+
+            one->setCheckable(true);
+            one->setChecked(type == _tagFilter.value(id64, _defaultFilter));
+            one->setData(type);
         }
+    }
+
+    menu.addSeparator();
+    window = menu.addAction(tr("Median filter window (%1 reports)...").arg(_filterWindow));
+
+    chosen = menu.exec(ui->tagTable->viewport()->mapToGlobal(pos));
+
+    if(chosen == NULL)
+    {
+        return;
+    }
 
-        /*if(c == ColumnFR) //label has changed
+    if(chosen == window)
+    {
+        bool ok;
+        int reports = QInputDialog::getInt(this, tr("Median filter"), tr("Reports in the window:"),
+                                           _filterWindow, 3, 201, 2, &ok);
+
+        if(ok)
         {
-            tag->joined = tag->joined;
-        }*/
+            _filterWindow = reports;
+            QMetaObject::invokeMethod(client, "setMotionFilterWindow", Qt::QueuedConnection, Q_ARG(int, reports));
+        }
+    }
+    else if(chosen->parent() == allMenu)
+    {
+        _defaultFilter = chosen->data().toInt();
+        _tagFilter.clear();
+
+        QMetaObject::invokeMethod(client, "setDefaultFilter", Qt::QueuedConnection, Q_ARG(int, _defaultFilter));
+    }
+    else if(tagMenu && (chosen->parent() == tagMenu))
+    {
+        _tagFilter.insert(id64, chosen->data().toInt());
+
+        QMetaObject::invokeMethod(client, "setTagFilter", Qt::QueuedConnection,
+                                  Q_ARG(quint64, id64), Q_ARG(int, chosen->data().toInt()));
     }
 }
 
-void GraphicsWidget::tagTableClicked(int r, int c)
+/**
+ * @fn    tagShowLabelChanged
+ * @brief  the Tag ID check box has been toggled: show/hide the tag's labels
+ *
+ * */
+void GraphicsWidget::tagShowLabelChanged(quint64 tagId, bool show)
 {
-    Tag *tag = NULL;
-    bool ok;
-    quint64 tagId = (ui->tagTable->item(r,ColumnIDr)->text()).toULongLong(&ok, 16);
-    tag = _tags.value(tagId, NULL);
-
-    _selectedTagIdx = r;
+    Tag *tag = _tags.value(tagId, NULL);
 
     if(!tag) return;
 
-    if(c == ColumnJoin) //add/remove tag from the list of known tags
-    {
-        QTableWidgetItem *pItemC0 = ui->tagTable->item(r, ColumnID);
-        QTableWidgetItem *pItem = ui->tagTable->item(r, c);
-        tag->joined = (pItem->checkState() == Qt::Checked) ? true : false;
+    tag->showLabel = show;
 
-        if(tag->joined)
-        {
-            pItemC0->setForeground(QBrush(Qt::black));
+    tag->tagLabel->setOpacity(tag->showLabel ? 1.0 : 0.0);
+    tag->tagLabel2->setOpacity(tag->showLabel ? 1.0 : 0.0);
+}
 
+/**
+ * @fn    tagJoinedChanged
+ * @brief  the Joined check box has been toggled: add/remove tag from the list of known tags
+ *
+ * */
+void GraphicsWidget::tagJoinedChanged(quint64 tagId, bool joined)
+{
+    Tag *tag = _tags.value(tagId, NULL);
+    int r = _tagModel->rowOf(tagId);
 
-            pItem->setBackground(QBrush(QColor::fromHsvF(tag->colourH, tag->colourS, tag->colourV)));
-        }
-        else
-        {
-            pItemC0->setForeground(QBrush(Qt::red));
+    if(!tag || (r < 0)) return;
 
-            pItem->setBackground(QBrush(Qt::white));
+    tag->joined = joined;
 
-            tag->showLabel = false;
-            QTableWidgetItem *item = ui->tagTable->item(r, ColumnID);
-            item->setCheckState(Qt::Unchecked);
-        }
+    if(tag->joined)
+    {
+        _tagModel->setLabelColour(r, Qt::black);
     }
-
-    if(c == ColumnID) //toggle label
+    else
     {
-        QTableWidgetItem *pItem = ui->tagTable->item(r, c);
-        tag->showLabel = (pItem->checkState() == Qt::Checked) ? true : false;
+        _tagModel->setLabelColour(r, Qt::red);
 
-        tag->tagLabel->setOpacity(tag->showLabel ? 1.0 : 0.0);
-        tag->tagLabel2->setOpacity(tag->showLabel ? 1.0 : 0.0);
+        tag->showLabel = false;
+        _tagModel->setShowLabel(r, false);
     }
 
     //if tag belongs to the network
-    if((c == ColumnJoin))
+    if(tag->joined == true)
     {
-        if(tag->joined == true)
-        {
-            //fast_rate/slow_rate are in units of superframe periods
-            //add 64bitID 16bitID fast_rate slow_rate IMU
-            //"Add2list 11AABB4455FF7788 10AA 1 2 1"
-            //add this tag to the node's known list so ranging can start
-            //
-            //
-            //slow_rate is set to 100*100ms (0.1 Hz) and should be read from config file
-            //
-            //
-            QString ids = QString("%1").arg(tagId, 16, 16, QChar('0'));
-            //久凌电子 截取16位后4位.
-            QString addr = ids.right(4);
-            //QString id16s = QString("%1").arg(tag->id16, 4, 16, QChar('0'));
-            QString frs = QString("%1").arg(tag->fastrate, 4, 16, QChar('0'));
-            QString mods = QString("%1").arg(tag->useIMU, 2, 16, QChar('0'));
-
-            //slow rate is set to 100 (0x0064)
-            //QString add2list = QString("addtag %1 %2 %3 64 %4\r\n").arg(ids).arg(id16s).arg(frs).arg(mods);
-            //QString add2list = QString("addtag %1 %2 %3 64 %4\r\n").arg(ids).arg(0x1000).arg(frs).arg(mods);
+        //fast_rate/slow_rate are in units of superframe periods
+        //add 64bitID 16bitID fast_rate slow_rate IMU
+        //"Add2list 11AABB4455FF7788 10AA 1 2 1"
+        //add this tag to the node's known list so ranging can start
+        //
+        //
+        //slow_rate is set to 100*100ms (0.1 Hz) and should be read from config file
+        //
+        //
+        QString ids = QString("%1").arg(tagId, 16, 16, QChar('0'));
+        //久凌电子 截取16位后4位.
+        QString addr = ids.right(4);
+        //QString id16s = QString("%1").arg(tag->id16, 4, 16, QChar('0'));
+        QString frs = QString("%1").arg(tag->fastrate, 4, 16, QChar('0'));
+        QString mods = QString("%1").arg(tag->useIMU, 2, 16, QChar('0'));
+
+        //slow rate is set to 100 (0x0064)
+        //QString add2list = QString("addtag %1 %2 %3 64 %4\r\n").arg(ids).arg(id16s).arg(frs).arg(mods);
+        //QString add2list = QString("addtag %1 %2 %3 64 %4\r\n").arg(ids).arg(0x1000).arg(frs).arg(mods);
 
 			//1.ID(64位)
-            //2.Addr(16位)
-            //3.最快频率
-            //4.最慢频率
-            //5.加速度传感器
-            QString add2list = QString("addtag %1 %2 %3 64 %4\r\n").arg(ids).arg(addr).arg(frs).arg(mods);
+        //2.Addr(16位)
+        //3.最快频率
+        //4.最慢频率
+        //5.加速度传感器
+        QString add2list = QString("addtag %1 %2 %3 64 %4\r\n").arg(ids).arg(addr).arg(frs).arg(mods);
 
 
-            RTLSDisplayApplication::serialConnection()->writeData(add2list.toLocal8Bit());
+        sendToNode(add2list.toLocal8Bit(), "TagAdded", CMD_TIMEOUT_MS);
 
-            RTLSDisplayApplication::serialConnection()->writeData("save\r\n");
-        }
+        sendToNode("save\r\n");
     }
 
-    if ((c == ColumnJoin) && (tag->joined == false))
+    if (tag->joined == false)
     {
         QString ids = QString("%1").arg(tagId, 16, 16, QChar('0'));
         QString deltag = QString("deltag %1\r\n").arg(ids);
-        RTLSDisplayApplication::serialConnection()->writeData(deltag.toLocal8Bit());
+        sendToNode(deltag.toLocal8Bit(), "TagDeleted", CMD_TIMEOUT_MS);
 
-        RTLSDisplayApplication::serialConnection()->writeData("save\r\n");
+        sendToNode("save\r\n");
 
         //clearTag(r); //clear Tag from table and also remove from Tag List (_tags)
         //RTLSDisplayApplication::client()->removeTagFromList(tagId);
@@ -409,44 +472,20 @@ void GraphicsWidget::tagTableClicked(int r, int c)
  * */
 void GraphicsWidget::tagIDToString(quint64 tagId, QString *t)
 {
-    //NOTE: this needs to be hex string as it is written into ColumnIDr
-    //and is used later to remove the correct Tag
+    //NOTE: this is the same hex string as the (hidden) ColumnIDr of the tag table
     *t = "0x"+QString::number(tagId, 16);
 }
 
-int GraphicsWidget::findTagRowIndex(QString &t)
-{
-    for (int ridx = 0 ; ridx < ui->tagTable->rowCount() ; ridx++ )
-    {
-        QTableWidgetItem* item = ui->tagTable->item(ridx, ColumnIDr);
-
-        if(item)
-        {
-            if(item->text() == t)
-            {
-                return ridx;
-            }
-        }
-    }
-
-    return -1;
-}
-
 //get tag ID 64 from label
 quint64 GraphicsWidget::getID64FromLabel(QString &label)
 {
-    bool ok;
     quint64 tagId = 0;
 
-    for (int ridx = 0 ; ridx < ui->tagTable->rowCount() ; ridx++ )
+    for (int ridx = 0 ; ridx < _tagModel->rowCount() ; ridx++ )
     {
-        //QTableWidgetItem* item = ui->tagTable->item(ridx, ColumnIDr);
-        QTableWidgetItem* itemLabel = ui->tagTable->item(ridx, ColumnID);
-        QTableWidgetItem* itemID64 = ui->tagTable->item(ridx, ColumnIDr);
-
-        if(label == itemLabel->text())
+        if(label == _tagModel->tag(ridx).label)
         {
-            tagId = itemID64->text().toULongLong(&ok, 16);
+            tagId = _tagModel->tag(ridx).id64;
             break;
         }
 
@@ -461,14 +500,11 @@ QStringList GraphicsWidget::getListOfTags(void)
 {
     QStringList list;
 
-    for (int ridx = 0 ; ridx < ui->tagTable->rowCount() ; ridx++ )
+    for (int ridx = 0 ; ridx < _tagModel->rowCount() ; ridx++ )
     {
-        //QTableWidgetItem* item = ui->tagTable->item(ridx, ColumnIDr);
-        QTableWidgetItem* item = ui->tagTable->item(ridx, ColumnID);
-        QTableWidgetItem* item2 = ui->tagTable->item(ridx, ColumnJoin);
-        if(item2->checkState() == Qt::Checked)
+        if(_tagModel->tag(ridx).joined)
         {
-            list << item->text();
+            list << _tagModel->tag(ridx).label;
         }
 
     }
@@ -514,88 +550,33 @@ int getRateIndex(int fastrate)
 
 /**
  * @fn    insertTag
- * @brief  insert Tag into the tagTable at row ridx
+ * @brief  add Tag to the end of the tagTable
+ * @return the row of the tag
  *
  * */
-void GraphicsWidget::insertTag(Tag *tag, int ridx, QString &t, bool showLabel)
+int GraphicsWidget::insertTag(Tag *tag, bool showLabel)
 {
-    _ignore = true;
+    qCDebug(lcTable) << "Insert Tag" << _tagModel->rowCount() << QString::number(tag->id, 16) << tag->tagLabelStr;
 
-    ui->tagTable->insertRow(ridx);
-
-    qDebug() << "Insert Tag" << ridx << t << tag->tagLabelStr;
-
-    for( int col = ColumnID ; col < ui->tagTable->columnCount(); col++)
-    {
-        QTableWidgetItem* item = new QTableWidgetItem();
-        QTableWidgetItem *pItem = new QTableWidgetItem();
-        if(col == ColumnID )
-        {
-            if(showLabel)
-            {
-                pItem->setCheckState(Qt::Checked);
-                pItem->setText(tag->tagLabelStr);
-            }
-            else
-            {
-                pItem->setCheckState(Qt::Unchecked);
-                pItem->setText(tag->tagLabelStr);
-            }
-            pItem->setFlags((pItem->flags() ^ Qt::ItemIsEditable) | Qt::ItemIsSelectable);
-            ui->tagTable->setItem(ridx, col, pItem);
-        }
-        else
-        {
-            if(col == ColumnIDr)
-            {
-                item->setText(t);
-            }
-
-            item->setFlags((item->flags() ^ Qt::ItemIsEditable) | Qt::ItemIsSelectable);
-            ui->tagTable->setItem(ridx, col, item);
-        }
-
-        if(col == ColumnJoin)
-        {
-            if(tag->joined)
-            {
-                pItem->setCheckState(Qt::Checked);
-                pItem->setBackground(QBrush(QColor::fromHsvF(tag->colourH, tag->colourS, tag->colourV)));
-            }
-            else
-            {
-                pItem->setCheckState(Qt::Unchecked);
-                pItem->setBackground(QBrush(Qt::white));
-
-            }
-            pItem->setText(" ");
-            pItem->setTextAlignment(Qt::AlignHCenter);
-            pItem->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable);
-            ui->tagTable->setItem(ridx,col,pItem);
-        }
-   }
-
-   _ignore = false; //we've added a row
+    return _tagModel->addTag(tag->id, tag->tagLabelStr,
+                             QColor::fromHsvF(tag->colourH, tag->colourS, tag->colourV),
+                             tag->joined, showLabel);
 }
 
 void GraphicsWidget::addDiscoveredTag(quint64 tagId, int id, bool known, int fastrate, int imu)
 {
     Tag *tag;
-    QString t ;
 
     tag = _tags.value(tagId, NULL);
 
     if(!tag) //add tag that has not already been added
     {
-        qDebug() << "addDiscoveredTag " << QString::number(tagId, 16) ;
+        qCDebug(lcTable) << "addDiscoveredTag " << QString::number(tagId, 16) ;
 
         addNewTag(tagId, true);
 
         tag = this->_tags.value(tagId, NULL);
 
-        tagIDToString(tagId, &t); //convert uint64 to string
-
-        int ridx = findTagRowIndex(t);
         tag->id16 = id;
         tag->joined = known;
         tag->useIMU = imu;
@@ -605,12 +586,7 @@ void GraphicsWidget::addDiscoveredTag(quint64 tagId, int id, bool known, int fas
             tag->fastrate = fastrate;
         }
 
-        if(ridx == -1)
-        {
-            ridx = ui->tagTable->rowCount();
-
-            insertTag(tag, ridx, t, true /*tag->showLabel*/);
-        }
+        insertTag(tag, true /*tag->showLabel*/);
     }
 }
 
@@ -627,7 +603,7 @@ void GraphicsWidget::addNewNode(quint64 nodeId, bool show)
 
     QString _nodeLabel = QString("      Node");
 
-    qDebug() << "Add new Node: 0x" + QString::number(nodeId, 16) << nodeId;
+    qCDebug(lcScene) << "Add new Node: 0x" + QString::number(nodeId, 16) << nodeId;
 
     //insert into QMap list, and create an array to hold history of its positions
     _nodes.insert(nodeId,new(Node));
@@ -689,7 +665,7 @@ void GraphicsWidget::addNewTag(quint64 tagId, bool show)
     Tag *tag;
 	QString taglabel = "Tag"+QString::number(tagId, 16); //taglabels.value(tagId, NULL);
 
-    qDebug() << "Add new Tag: 0x" + taglabel << tagId;
+    qCDebug(lcScene) << "Add new Tag: 0x" + taglabel << tagId;
 
     //insert into QMap list, and create an array to hold history of its positions
     _tags.insert(tagId,new(Tag));
@@ -698,8 +674,6 @@ void GraphicsWidget::addNewTag(quint64 tagId, bool show)
 
     tag->id = tagId ;
 
-    tag->p.resize(_historyLength);
-
     c_h += 0.568034;
     if (c_h >= 1)
         c_h -= 1;
@@ -707,6 +681,13 @@ void GraphicsWidget::addNewTag(quint64 tagId, bool show)
     tag->colourS = 0.55;
     tag->colourV = 0.98;
 
+    //the position history, drawn under the tag
+    tag->trail = new TrailItem(_historyLength);
+    tag->trail->setPointSize(_tagSize);
+    tag->trail->setColour(QColor::fromHsvF(tag->colourH, tag->colourS, tag->colourV).darker());
+    tag->trail->setZValue(4);
+    this->_scene->addItem(tag->trail);
+
     //tag->tsPrev = 0;
     tag->fastrate = 1; //default rate is 10 Hz
     tag->joined = false ;
@@ -749,7 +730,7 @@ void GraphicsWidget::addNewTag(quint64 tagId, bool show)
         this->_scene->addItem(tag->tagLabel2);
     }
 
-    QAbstractGraphicsShapeItem *tag_alarm = this->_scene->addEllipse(-1*0.2/2, -1*0.2/2, 0.2, 0.2);
+    QGraphicsEllipseItem *tag_alarm = _itemPool->acquire(QRectF(-1*0.2/2, -1*0.2/2, 0.2, 0.2));
     QBrush b2 = QBrush(QColor(185, 0, 0, 196));//QColor::fromHsvF(node->colourH, node->colourS, node->colourV));
 
     tag->alarm = tag_alarm;
@@ -769,83 +750,71 @@ void GraphicsWidget::nodePos(int nodeId, double x, double y)
 {
     //qDebug() << "nodePos Node: " + QString::number(tagId) << " " << x << " " << y ;
 
-    if(_busy) //don't display
-    {
-        qDebug() << "(Widget - busy IGNORE) Node: " + QString::number(nodeId) << " " << x << " " << y;
-    }
-    else
-    {
-        Node *node = NULL;
-        //bool newNode = false;
-
-        _busy = true ;
+    Node *node = NULL;
+    //bool newNode = false;
 
-        node = _nodes.value(nodeId, NULL);
 
-        if(!node) //add new node to the nodes array
-        {
-            //node does not exist, so create a new one
-            //newNode = true;
-            addNewNode(nodeId, true);
-            node = this->_nodes.value(nodeId, NULL);
-        }
+    node = _nodes.value(nodeId, NULL);
 
+    if(!node) //add new node to the nodes array
+    {
+        //node does not exist, so create a new one
+        //newNode = true;
+        addNewNode(nodeId, true);
+        node = this->_nodes.value(nodeId, NULL);
+    }
 
-        //if(!node->p[node->idx]) //we have not added this object yet to the history array
-        {
-            //QGraphicsPixmapItem *item = this->_scene->addPixmap(QPixmap("node.png"));
-            QGraphicsEllipseItem *ellipse1 = this->_scene->addEllipse(-1*_nodeSize/2, -1*_nodeSize/2, _nodeSize, _nodeSize);
-            QGraphicsEllipseItem *ellipse3 = this->_scene->addEllipse(-1*_nodeSize/2, -1*_nodeSize/2, _nodeSize, _nodeSize);
-            QGraphicsEllipseItem *ellipse2 = this->_scene->addEllipse(-1*_nodeSize/2, -1*_nodeSize/2, _nodeSize, _nodeSize);
-
-            //this will be used for geo-fencing centre
-            ellipse1->setOpacity(0);
-
-            //this will be used for geo-fencing
-            ellipse2->setOpacity(0);
-
-            //this is to define the working region area
-            ellipse3->setStartAngle(0*16); //start at 60, it is in 16ths of a degree (whole range is 360 * 16)
-            ellipse3->setSpanAngle(180*16); //go to 120 deg
-
-            node->zone1 = ellipse1;
-            node->zone2 = ellipse2;
-            node->zone3 = ellipse3;
-
-            //node->p[node->idx] = item;
-            node->zone1->setPen(Qt::NoPen);
-            node->zone2->setPen(Qt::NoPen);
-            node->zone3->setPen(Qt::NoPen);
-
-            //set semi transparent colour
-            QBrush b = QBrush(QColor(0, 255, 0 ,127));//QColor::fromHsvF(node->colourH, node->colourS, node->colourV));
-            node->zone1->setBrush(b);
-            node->zone1->setBrush(b.color().lighter());
-            //node->zone1->setOpacity(0);
-
-            QBrush b3 = QBrush(QColor(0, 235, 0 ,127));//QColor::fromHsvF(node->colourH, node->colourS, node->colourV));
-            node->zone3->setBrush(b3);
-            node->zone3->setBrush(b3.color().lighter());
-            //node->zone3->setOpacity(0);
-        }
 
-        _ignore = true;
+    //if(!node->p[node->idx]) //we have not added this object yet to the history array
+    {
+        //QGraphicsPixmapItem *item = this->_scene->addPixmap(QPixmap("node.png"));
+        QGraphicsEllipseItem *ellipse1 = this->_scene->addEllipse(-1*_nodeSize/2, -1*_nodeSize/2, _nodeSize, _nodeSize);
+        QGraphicsEllipseItem *ellipse3 = this->_scene->addEllipse(-1*_nodeSize/2, -1*_nodeSize/2, _nodeSize, _nodeSize);
+        QGraphicsEllipseItem *ellipse2 = this->_scene->addEllipse(-1*_nodeSize/2, -1*_nodeSize/2, _nodeSize, _nodeSize);
+
+        //this will be used for geo-fencing centre
+        ellipse1->setOpacity(0);
+
+        //this will be used for geo-fencing
+        ellipse2->setOpacity(0);
+
+        //this is to define the working region area
+        ellipse3->setStartAngle(0*16); //start at 60, it is in 16ths of a degree (whole range is 360 * 16)
+        ellipse3->setSpanAngle(180*16); //go to 120 deg
+
+        node->zone1 = ellipse1;
+        node->zone2 = ellipse2;
+        node->zone3 = ellipse3;
+
+        //node->p[node->idx] = item;
+        node->zone1->setPen(Qt::NoPen);
+        node->zone2->setPen(Qt::NoPen);
+        node->zone3->setPen(Qt::NoPen);
+
+        //set semi transparent colour
+        QBrush b = QBrush(QColor(0, 255, 0 ,127));//QColor::fromHsvF(node->colourH, node->colourS, node->colourV));
+        node->zone1->setBrush(b);
+        node->zone1->setBrush(b.color().lighter());
+        //node->zone1->setOpacity(0);
+
+        QBrush b3 = QBrush(QColor(0, 235, 0 ,127));//QColor::fromHsvF(node->colourH, node->colourS, node->colourV));
+        node->zone3->setBrush(b3);
+        node->zone3->setBrush(b3.color().lighter());
+        //node->zone3->setOpacity(0);
+    }
 
-        node->point.setX(x);
-        node->point.setY(y);
+    node->point.setX(x);
+    node->point.setY(y);
 
-        node->zone1->setZValue(3);
-        node->zone2->setZValue(5); //zone 2 is for geo-fencing
-        node->zone3->setZValue(6);
+    node->zone1->setZValue(3);
+    node->zone2->setZValue(5); //zone 2 is for geo-fencing
+    node->zone3->setZValue(6);
 
 
-        node->nodeLabel->setPos(x + 0.15, y + 0.15);
+    node->nodeLabel->setPos(x + 0.15, y + 0.15);
 
-        _ignore = false;
-        _busy = false ;
 
-        //qDebug() << "Tag: 0x" + QString::number(tagId, 16) << " " << x << " " << y << " " << z;
-    }
+    //qDebug() << "Tag: 0x" + QString::number(tagId, 16) << " " << x << " " << y << " " << z;
 }
 
 /*
@@ -873,153 +842,231 @@ void GraphicsWidget::scaleNode(qreal dx, qreal dy)
 
 
 /**
- * @fn    tagPos
- * @brief  update tag position on the screen (add to scene if it does not exist)
+ * @fn    updatesReady
+ * @brief  drain the position updates queued by the RTLS client (I/O thread)
+ *         and show them on the screen
+ *         updates are only ever dropped by the client, when its queue is full (droppedUpdates());
+ *         here a newer update of a tag replaces the pending one (mergedUpdates())
  *
  * */
-void GraphicsWidget::tagPos(quint64 tagId, double x, double y, int mode)
+void GraphicsWidget::updatesReady(void)
 {
-    QDateTime now = QDateTime::currentDateTime();
-    user_cmd_t user_cmd = *(user_cmd_t*)&mode;
+    RTLSClient *client = RTLSDisplayApplication::client();
+    LatencyMonitor *latency = client->latency();
+    tag_update_t u;
+
+    //re-arm before draining, so anything queued from now on signals again
+    client->rearmUpdates();
+
+    //only keep the latest update of each tag, they are applied on the next display frame
+    while(client->takeUpdate(&u))
+    {
+        int i = _pendingIndex.value(u.id64, -1);
+
+        latency->record(LatencyQueue, LatencyMonitor::now() - u.filterTime);
+
+        if(!_coalesce)
+        {
+            _pending.append(u);
+            applyUpdates();
+        }
+        else if(i < 0)
+        {
+            //never drop a tag's update here: if too many tags are waiting show them now
+            if(_pending.size() >= FRAME_PENDING_MAX)
+            {
+                _frameTimer->stop();
+                applyUpdates();
+                _earlyFrames++;
+            }
+
+            _pendingIndex.insert(u.id64, _pending.size());
+            _pending.append(u);
+        }
+        else
+        {
+            //merge: only the latest position of a tag is shown
+            _pending[i] = u;
+            _mergedUpdates++;
+        }
+    }
 
-    if(_busy) //don't display
+    if(!_pending.isEmpty() && !_frameTimer->isActive())
     {
-        qDebug() << "(Widget - busy IGNORE) Node: " + QString::number(tagId) << " " << x << " " << y;
+        _frameTimer->start();
     }
-    else
+
+    if(client->droppedUpdates() != _droppedUpdates)
     {
-        int ridx = -1;
-        Tag *tag = NULL;
-        bool newTag = false;
-        QString t ;
+        _droppedUpdates = client->droppedUpdates();
+        qCDebug(lcScene) << "position updates dropped" << _droppedUpdates << "max queue depth" << client->updateQueueMaxDepth()
+                 << "merged" << _mergedUpdates << "early frames" << _earlyFrames;
+    }
+}
 
-        _busy = true ;
+/**
+ * @fn    setCoalesceUpdates
+ * @brief  apply the updates once per display frame (default) or each one as it comes,
+ *         as before the frame pacing, to measure the difference (see DiagnosticsWidget)
+ * */
+void GraphicsWidget::setCoalesceUpdates(bool coalesce)
+{
+    _coalesce = coalesce;
 
-        tagIDToString(tagId, &t); //convert uint64 to string
+    if(!_coalesce && !_pending.isEmpty())
+    {
+        _frameTimer->stop();
+        applyUpdates();
+    }
+}
 
-        tag = _tags.value(tagId, NULL);
+/**
+ * @fn    applyUpdates
+ * @brief  move the tags which have been updated since the last display frame and update their table rows
+ *         (the scene latency stage is measured per tag, the total from the arrival of the latest report)
+ * */
+void GraphicsWidget::applyUpdates(void)
+{
+    LatencyMonitor *latency = RTLSDisplayApplication::client()->latency();
 
-        if(!tag) //add new tag to the tags array
-        {
-            //tag does not exist, so create a new one
-            newTag = true;
-            addNewTag(tagId, true);
-            tag = this->_tags.value(tagId, NULL);
-        }
+    for(int i = 0; i < _pending.size(); i++)
+    {
+        const tag_update_t &u = _pending.at(i);
+        qint64 start = LatencyMonitor::now();
+        qint64 done;
 
-        ridx = findTagRowIndex(t);
+        tagPos(u.id64, u.x, u.y, u.mode);
+        tagRange(u.id64, u.range, u.x, u.y, u.angle, u.mode, u.accX, u.accY, u.accZ);
 
-        if(!tag->p[tag->idx]) //we have not added this object yet to the history array
-        {
-            QAbstractGraphicsShapeItem *tag_pt = this->_scene->addEllipse(-1*_tagSize/2, -1*_tagSize/2, _tagSize, _tagSize);
-            tag->p[tag->idx] = tag_pt;
+        done = LatencyMonitor::now();
 
-            tag_pt->setZValue(5);
-            tag_pt->setPen(Qt::NoPen);
+        latency->record(LatencyScene, done - start);
+        latency->record(LatencyTotal, done - u.rxTime);
+    }
 
-            if(tag->idx > 0) //use same brush settings for existing tag ID
-            {
-                tag_pt->setBrush(tag->p[0]->brush());
-            }
-            else //new brush... new tag ID as idx = 0
-            {
-                QBrush b = QBrush(QColor::fromHsvF(tag->colourH, tag->colourS, tag->colourV));
-                QPen pen = QPen(b.color().darker());
-                pen.setStyle(Qt::SolidLine);
-                pen.setWidthF(PEN_WIDTH);
-                //set the brush colour of the labels
-                tag_pt->setBrush(b.color().darker());
-
-                tag->tagLabel->setBrush(b.color().darker());
-                tag->tagLabel->setPen(pen);
-                tag->tagLabel2->setBrush(b.color().darker());
-                tag->tagLabel2->setPen(pen);
-            }
+    _pending.clear();
+    _pendingIndex.clear();
 
-            tag_pt->setToolTip(t);
+    //one dataChanged() per run of changed rows for the whole frame
+    _tagModel->flush();
+}
 
-            if(newTag) //if this tag has not been added to the table add it now
-            {
+/**
+ * @fn    tagPos
+ * @brief  update tag position on the screen (add to scene if it does not exist)
+ *
+ * */
+void GraphicsWidget::tagPos(quint64 tagId, double x, double y, int mode)
+{
+    QDateTime now = QDateTime::currentDateTime();
+    user_cmd_t user_cmd = *(user_cmd_t*)&mode;
 
-                if(ridx == -1)
-                {
-                    ridx = ui->tagTable->rowCount();
+    int ridx = -1;
+    Tag *tag = NULL;
+    bool newTag = false;
+    QString t ;
 
-                    insertTag(tag, ridx, t, tag->showLabel);
-                }
-            }
 
-            //change colour of label to black if it was e.g. in red
-            {
+    tag = _tags.value(tagId, NULL);
 
-                QTableWidgetItem *pItemC0 = ui->tagTable->item(ridx, ColumnID);
+    if(!tag) //add new tag to the tags array
+    {
+        //tag does not exist, so create a new one
+        newTag = true;
+        addNewTag(tagId, true);
+        tag = this->_tags.value(tagId, NULL);
+    }
 
-                pItemC0->setForeground(QBrush(Qt::black)); // black
+    ridx = _tagModel->rowOf(tagId);
 
+    if(!tag->marker) //we have not added this object yet to the scene (new tag, or it was lost)
+    {
+        QGraphicsEllipseItem *tag_pt = _itemPool->acquire(QRectF(-1*_tagSize/2, -1*_tagSize/2, _tagSize, _tagSize));
+        tag->marker = tag_pt;
 
-            }
+        tag_pt->setZValue(5);
+        tag_pt->setPen(Qt::NoPen);
+
+        {
+            QBrush b = QBrush(QColor::fromHsvF(tag->colourH, tag->colourS, tag->colourV));
+            QPen pen = QPen(b.color().darker());
+            pen.setStyle(Qt::SolidLine);
+            pen.setWidthF(PEN_WIDTH);
+            //set the brush colour of the labels
+            tag_pt->setBrush(b.color().darker());
+
+            tag->tagLabel->setBrush(b.color().darker());
+            tag->tagLabel->setPen(pen);
+            tag->tagLabel2->setBrush(b.color().darker());
+            tag->tagLabel2->setPen(pen);
         }
 
-        //if stationary
+        tagIDToString(tagId, &t); //convert uint64 to string
+        tag_pt->setToolTip(t);
+
+        if(newTag) //if this tag has not been added to the table add it now
         {
-            QBrush b1 = tag->p[0]->brush();
-            QPen p1 = tag->tagLabel->pen();
 
-            if(mode&0x1)
-            {
-                //b1.setStyle(Qt::Dense7Pattern);
-                b1.setStyle(Qt::NoBrush);
-                p1.setStyle(Qt::SolidLine);
-                p1.setWidthF(PEN_WIDTH/2);
-            }
-            else
+            if(ridx == -1)
             {
-                b1.setStyle(Qt::SolidPattern);
-                p1.setStyle(Qt::NoPen);
+                ridx = insertTag(tag, tag->showLabel);
             }
-
-            tag->p[tag->idx]->setBrush(b1);
-            tag->p[tag->idx]->setPen(p1);
         }
 
-        tag->_last_time = now;
-        tag->_cleared = false;
-
-        //qDebug() << tag->idx << tag->p[0]->brush() << tag->tagLabel->pen();
-        //qDebug() << QString::number(tagId, 16) << tag->_last_time ;
-
-        _ignore = true;
-        //update table entries
-        ui->tagTable->item(ridx,ColumnX)->setText(QString::number(x, 'f', 3));
-        ui->tagTable->item(ridx,ColumnY)->setText(QString::number(y, 'f', 3));
-
-        //set tag position on the screen
-        tag->p[tag->idx]->setPos(x, y);
-
-        tag->alarm->setPos(x, y); //move it to the avg x and y values
+        //change colour of label to black if it was e.g. in red
+        _tagModel->setLabelColour(ridx, Qt::black);
+    }
 
-        tag->point.setX(x);
-        tag->point.setY(y);
+    //if stationary
+    {
+        QBrush b1 = tag->marker->brush();
+        QPen p1 = tag->tagLabel->pen();
 
-        if(_showHistory)
+        if(mode&0x1)
         {
-            tagHistory(tagId);
-            tag->idx = (tag->idx+1)%_historyLength;
+            //b1.setStyle(Qt::Dense7Pattern);
+            b1.setStyle(Qt::NoBrush);
+            p1.setStyle(Qt::SolidLine);
+            p1.setWidthF(PEN_WIDTH/2);
         }
         else
         {
-            //index will stay at 0
-            tag->p[tag->idx]->setOpacity(1);
+            b1.setStyle(Qt::SolidPattern);
+            p1.setStyle(Qt::NoPen);
         }
 
-        tag->tagLabel->setPos(x + 0.15, y + 0.15);
-        tag->tagLabel2->setPos(x + 0.15, y + 0.35);
+        tag->marker->setBrush(b1);
+        tag->marker->setPen(p1);
+    }
+
+    tag->_last_time = now;
+    tag->_cleared = false;
+
+    //qDebug() << tag->marker->brush() << tag->tagLabel->pen();
+    //qDebug() << QString::number(tagId, 16) << tag->_last_time ;
 
-        _ignore = false;
-        _busy = false ;
+    //update table entries
+    _tagModel->setPosition(ridx, x, y);
 
-        //qDebug() << "Tag: 0x" + QString::number(tagId, 16) << " " << x << " " << y << " " << z;
+    //set tag position on the screen
+    tag->marker->setPos(x, y);
+
+    tag->alarm->setPos(x, y); //move it to the avg x and y values
+
+    tag->point.setX(x);
+    tag->point.setY(y);
+
+    if(_showHistory)
+    {
+        //the latest position is opaque and the previous ones fade out over _historyLength reports
+        tag->trail->append(tag->point);
     }
+
+    tag->tagLabel->setPos(x + 0.15, y + 0.15);
+    tag->tagLabel2->setPos(x + 0.15, y + 0.35);
+
+
+    //qDebug() << "Tag: 0x" + QString::number(tagId, 16) << " " << x << " " << y << " " << z;
 }
 
 /**
@@ -1030,149 +1077,72 @@ void GraphicsWidget::tagPos(quint64 tagId, double x, double y, int mode)
 void GraphicsWidget::tagRange(quint64 tagID, double range, double x, double y, int angle, int mode,int Acc_x,int Acc_y, int Acc_z)
 {
     user_cmd_t user_cmd = *(user_cmd_t*)&mode;
-    if(_busy) //don't display
-    {
-        qDebug() << "(Widget - busy IGNORE) Tag: " << tagID << " range " << range << "mode" << mode;
-    }
-    else
-    {
-        Tag *tag = NULL;
-        QString t ;
-        int ridx = 0;
-        _busy = true ;
-
-        tag = _tags.value(tagID, NULL);
-
-        //NOTE: the ranges are shown on the tags only
-		if (tag)
-        {
-			QString _nodeLabel = QString("Distance:%1m, Angle:%2°, Alarm:%3, Battery:%4v")
-				.arg(range, 0, 'f', 2)
-				.arg(angle)
-				.arg(QString::number(user_cmd.is_alarm))
-                .arg(QString::number(user_cmd.battery_val/100.0, 'f', 3));
-            tag->tagLabel2->setText(_nodeLabel);
-        }
-
-        //update Tag range value in the table
-        tagIDToString(tagID, &t);
+    Tag *tag = NULL;
+    int ridx = 0;
 
-        ridx = findTagRowIndex(t);
+    tag = _tags.value(tagID, NULL);
 
-        if(ridx != -1)
-        {
-            ui->tagTable->item(ridx,ColumnRA0)->setText(QString::number(range, 'f', 3));
-			ui->tagTable->item(ridx,ColumnAngle)->setText(QString::number(angle));
-
-			//是否按键报警
-			if(user_cmd.is_alarm == 1){ui->tagTable->item(ridx,ColumnAlarm)->setText("Alarm");}
-			else{ui->tagTable->item(ridx,ColumnAlarm)->setText("Normal");}
-
-			//电池当前电压
-			ui->tagTable->item(ridx,ColumnBattery)->setText(QString::number(user_cmd.battery_val/100.0, 'f', 3));
-
-			//充电状态
-			if(user_cmd.is_chrg == 1 && user_cmd.is_tdby == 1)
-			{ui->tagTable->item(ridx,ColumnCHRG)->setText("Not Charging");}
-            else if(user_cmd.is_chrg == 0 && user_cmd.is_tdby == 1)
-			{ui->tagTable->item(ridx,ColumnCHRG)->setText("Charging");}
-            else if(user_cmd.is_chrg == 1 && user_cmd.is_tdby == 0)
-			{ui->tagTable->item(ridx,ColumnCHRG)->setText("Fully Charged");}
-            else
-			{ui->tagTable->item(ridx,ColumnCHRG)->setText("Not Charging");}
+    //NOTE: the ranges are shown on the tags only
+	if (tag)
+    {
+		QString _nodeLabel = QString("Distance:%1m, Angle:%2°, Alarm:%3, Battery:%4v")
+			.arg(range, 0, 'f', 2)
+			.arg(angle)
+			.arg(QString::number(user_cmd.is_alarm))
+            .arg(QString::number(user_cmd.battery_val/100.0, 'f', 3));
+        tag->tagLabel2->setText(_nodeLabel);
+    }
 
-			//三轴加速度XYZ轴的值
-			ui->tagTable->item(ridx,Column_AccX)->setText(QString::number(0));
-			ui->tagTable->item(ridx,Column_AccY)->setText(QString::number(0));
-			ui->tagTable->item(ridx,Column_AccZ)->setText(QString::number(0));
+    //update Tag range value in the table (the texts are formatted by the model when they are shown)
+    ridx = _tagModel->rowOf(tagID);
 
+    if((ridx == -1) && tag) //add tag into tag table
+    {
+        ridx = insertTag(tag, true);
+    }
 
-			//是否距离校正
-			if(user_cmd.is_offset_pdoa_zero_bit == 1){ui->tagTable->item(ridx,ColumnOffRange)->setText("Uncalibrated");}
-			else{ui->tagTable->item(ridx,ColumnOffRange)->setText("Calibrated");}
-			//是否角度校正
-			if(user_cmd.is_offset_pdoa_zero_bit == 1){ui->tagTable->item(ridx,ColumnOffPDoa)->setText("Uncalibrated");}
-			else{ui->tagTable->item(ridx,ColumnOffPDoa)->setText("Calibrated");}
+    if(ridx != -1)
+    {
+        _tagModel->setRange(ridx, range, angle, mode);
+    }
 
-//            ui->tagTable->item(ridx,ColumnBatAlarm)->setText(QString::number(mode>>13));
-        }
-        else //add tag into tag table
-        {
-            ridx = ui->tagTable->rowCount();
 
-            insertTag(tag, ridx, t, true);
-        }
+    //check geo-fencing area if enabled
+    {
+        Node *node = NULL;
 
+        node = _nodes.value(0, NULL);
 
-        //check geo-fencing area if enabled
+        if((node != NULL) && (ridx != -1))
         {
-            Node *node = NULL;
-
-            node = _nodes.value(0, NULL);
-
-            if(node != NULL)
+            if(node->gf_enabled)
             {
-                if(node->gf_enabled)
+                //QPointF p(x - node->gf_x, y - node->gf_y);
+                //QPointF p(x, y);
+                if(((node->gf_x < x) && ((node->gf_x + node->gf_width) > x))
+                        && ((node->gf_y > y) && ((node->gf_y + node->gf_height) < y)))
+                //if(node->zone2->contains(p))
                 {
-                    //QPointF p(x - node->gf_x, y - node->gf_y);
-                    //QPointF p(x, y);
-                    qDebug() << "(Widget - busy IGNORE) Tag: " << tagID << " range " << range;
+                    //ALARM !!!
+                    qCDebug(lcGeofence) << "tag" << QString::number(tagID, 16) << "in the zone at" << x << y;
 
-                    if(((node->gf_x < x) && ((node->gf_x + node->gf_width) > x))
-                            && ((node->gf_y > y) && ((node->gf_y + node->gf_height) < y)))
-                    //if(node->zone2->contains(p))
-                    {
-                        //ALARM !!!
-                        tag->alarm->setOpacity(1);
-                        ui->tagTable->item(ridx,ColumnID)->setBackground(QBrush(QColor(185, 0, 0, 127)));
-                    }
-                    else
-                    {
-                        tag->alarm->setOpacity(0); //transparent
-                        ui->tagTable->item(ridx,ColumnID)->setBackground(QBrush(QColor(Qt::white)));
-                    }
+                    tag->alarm->setOpacity(1);
+                    _tagModel->setAlarm(ridx, true);
                 }
                 else
                 {
                     tag->alarm->setOpacity(0); //transparent
-                    ui->tagTable->item(ridx,ColumnID)->setBackground(QBrush(QColor(Qt::white)));
+                    _tagModel->setAlarm(ridx, false);
                 }
-
             }
-         }
-
-        _ignore = false;
-        _busy = false ;
-    }
-}
-
-/**
- * @fn    tagHistory
- * @brief  plot tag's history (the latest position is opaque
- *         and the previous ones have less opacity so that the
- *         one that is _historyLength is transparent
- * */
-void GraphicsWidget::tagHistory(quint64 tagId)
-{
-    int i = 0;
-    int j = 0;
-
-    Tag *tag = this->_tags.value(tagId, NULL);
-    for(i = 0; i < _historyLength; i++)
-    {
-        QAbstractGraphicsShapeItem *tag_p = tag->p[i];
+            else
+            {
+                tag->alarm->setOpacity(0); //transparent
+                _tagModel->setAlarm(ridx, false);
+            }
 
-        if(!tag_p)
-        {
-            break;
-        }
-        else
-        {
-            j = (tag->idx - i); //element at index is opaque
-            if(j<0) j+= _historyLength;
-            tag_p->setOpacity(1-(float)j/_historyLength);
         }
-    }
+     }
 }
 
 /**
@@ -1184,10 +1154,6 @@ void GraphicsWidget::tagHistoryNumber(int newValue)
 {
     bool tag_showHistory = _showHistory;
 
-    while(_busy);
-
-    _busy = true;
-
     //remove old history
     setShowTagHistory(false);
 
@@ -1200,10 +1166,9 @@ void GraphicsWidget::tagHistoryNumber(int newValue)
 
         if(tag)
         {
-            tag->p.resize(newValue);
+            tag->trail->setLength(newValue); //reset history
         }
 
-        tag->idx = 0; //reset history
         i++;
     }
 
@@ -1212,8 +1177,6 @@ void GraphicsWidget::tagHistoryNumber(int newValue)
 
     //set the history to show/hide
     _showHistory = tag_showHistory;
-
-    _busy = false;
 }
 
 
@@ -1299,6 +1262,8 @@ void GraphicsWidget::startGeoFencing(float x, float y, float height, float width
         node->gf_width = width;
 
         node->gf_enabled = true;
+
+        qCDebug(lcGeofence) << "zone" << x << y << width << height;
     }
 
 }
@@ -1320,6 +1285,8 @@ void GraphicsWidget::stopGeoFencing(void)
         node->zone2->setOpacity(0);
         node->zone1->setOpacity(0);
         node->gf_enabled = false;
+
+        qCDebug(lcGeofence) << "zone off";
     }
 }
 
@@ -1331,8 +1298,6 @@ void GraphicsWidget::stopGeoFencing(void)
  * */
 void GraphicsWidget::setShowTagHistory(bool set)
 {
-    _busy = true ;
-
     if(set != _showHistory) //the value has changed
     {
         //for each tag
@@ -1343,33 +1308,18 @@ void GraphicsWidget::setShowTagHistory(bool set)
             while(i != _tags.end())
             {
                 Tag *tag = i.value();
-                //keep 1 at index 0 ...
-                for(int idx=1; idx<_historyLength; idx++ )
-                {
-                    QAbstractGraphicsShapeItem *tag_p = tag->p[idx];
-                    if(tag_p)
-                    {
-                        tag_p->setOpacity(0); //hide it
 
-                        this->_scene->removeItem(tag_p);
-                        delete(tag_p);
-                        tag_p = NULL;
-                        tag->p[idx] = 0;
-                    }
-                }
-                tag->idx = 0; //reset history
+                tag->trail->clear(); //reset history
                 i++;
             }
         }
-        else //the history will be shown though the tagHistory function above
+        else //the history will be shown through the tag's trail, see tagPos()
         {
 
         }
 
         _showHistoryP = _showHistory = set; //update the value
     }
-
-    _busy = false;
 }
 
 /**
@@ -1429,84 +1379,67 @@ void GraphicsWidget::centerOnNodes(void)
 //
 void GraphicsWidget::timerUpdateTagTableExpire(void)
 {
-    if(_busy == false)
+    if(!_tags.empty())
     {
-        _busy = true ;
-        if(!_tags.empty())
+        QMap<quint64, Tag*>::iterator i = _tags.begin();
+        QDateTime now1 = QDateTime::currentDateTime();
+		qCDebug(lcTable) << "GraphicsWidget.cpp" << "timerUpdateTagTableExpire";
+        qCDebug(lcTable) << "update tags on screen " ;
+        while(i != _tags.end())
         {
-            QMap<quint64, Tag*>::iterator i = _tags.begin();
-            QDateTime now1 = QDateTime::currentDateTime();
-			qDebug() << "GraphicsWidget.cpp" << "timerUpdateTagTableExpire";
-            qDebug() << "update tags on screen " ;
-            while(i != _tags.end())
+            Tag *tag = i.value();
+
+            if(tag->_last_time.isValid() && !tag->_cleared)
             {
-                Tag *tag = i.value();
+                QDateTime checkt ;
 
-                if(tag->_last_time.isValid() && !tag->_cleared)
+                //if there is no update from this tag within 30s then remove the tag from the display
+                if(tag->useIMU)
+                {
+                    checkt = tag->_last_time.addSecs(30) ;
+                }
+                else
                 {
-                    QDateTime checkt ;
+                    //fastrate is in units of 100 ms
+                    //
+                    checkt = tag->_last_time.addSecs(tag->fastrate * 30 / 10) ; //in seconds
+                }
+                //qDebug() << QString::number(tag->id, 16) << tag->_last_time  << checkt << now1 ;
+                //if(tag->joined) //tag is joined
+                if(checkt < now1) //last update was > 60s ago (remove tag)
+                {
+                    //qDebug() << tag->_last_time << now1 ;
 
-                    //if there is no update from this tag within 30s then remove the tag from the display
-                    if(tag->useIMU)
+                    //change colour of label to dark red
+                    //only if the tag is joined
+                    if(tag->joined)
                     {
-                        checkt = tag->_last_time.addSecs(30) ;
-                    }
-                    else
-                    {
-                        //fastrate is in units of 100 ms
-                        //
-                        checkt = tag->_last_time.addSecs(tag->fastrate * 30 / 10) ; //in seconds
-                    }
-                    //qDebug() << QString::number(tag->id, 16) << tag->_last_time  << checkt << now1 ;
-                    //if(tag->joined) //tag is joined
-                    if(checkt < now1) //last update was > 60s ago (remove tag)
-                    {
-                        //qDebug() << tag->_last_time << now1 ;
+                        int ridx = _tagModel->rowOf(tag->id);
 
-                        //change colour of label to dark red
-                        //only if the tag is joined
-                        if(tag->joined)
+                        if(ridx != -1)
                         {
-                            QString t;
-                            int ridx;
-                            tagIDToString(tag->id, &t);
-                            ridx = findTagRowIndex(t);
-                            QTableWidgetItem *pItemC0 = ui->tagTable->item(ridx, ColumnID);
-                            pItemC0->setForeground(QBrush(Qt::darkRed)); // darkRed
-
+                            _tagModel->setLabelColour(ridx, Qt::darkRed); // darkRed
                         }
+                    }
 
-                        if(tag->showLabel) //hide the labels once tag is gone
-                        {
-                            tag->tagLabel->setOpacity(0.0);
-                            tag->tagLabel2->setOpacity(0.0);
-                        }
+                    if(tag->showLabel) //hide the labels once tag is gone
+                    {
+                        tag->tagLabel->setOpacity(0.0);
+                        tag->tagLabel2->setOpacity(0.0);
+                    }
 
-                        //keep 1 at index 0 ...
-                        for(int idx=0; idx<_historyLength; idx++ )
-                        {
-                            QAbstractGraphicsShapeItem *tag_p = tag->p[idx];
-                            if(tag_p)
-                            {
-                                tag_p->setOpacity(0); //hide it
-
-                                this->_scene->removeItem(tag_p);
-                                delete(tag_p);
-                                tag_p = NULL;
-                                tag->p[idx] = 0;
-                            }
-                        }
+                    _itemPool->release(tag->marker); //hide it, it will be reused
+                    tag->marker = NULL;
+                    tag->trail->clear();
 
-                        tag->_cleared = true;
-                        qDebug() << "Tag clear history " <<  QString::number(tag->id, 16) << tag->fastrate << "last:" << checkt << "now:" << now1;
-                    }
+                    tag->_cleared = true;
+                    qCDebug(lcTable) << "Tag clear history " <<  QString::number(tag->id, 16) << tag->fastrate << "last:" << checkt << "now:" << now1;
                 }
-                //tag->idx = 0; //reset history
-                i++;
             }
-            qDebug() << "DONE update tags on screen " ;
+            //tag->idx = 0; //reset history
+            i++;
         }
-        _busy = false ;
+        qCDebug(lcTable) << "DONE update tags on screen " ;
     }
 
     //_timer->setInterval(30000);
@@ -1514,16 +1447,14 @@ void GraphicsWidget::timerUpdateTagTableExpire(void)
 
 void GraphicsWidget::clearTag(int r)
 {
-    qDebug() << "clear single row " << r;
-
-    QTableWidgetItem* item = ui->tagTable->item(r, ColumnIDr);
+    qCDebug(lcTable) << "clear single row " << r;
 
-    if(item)
+    if((r >= 0) && (r < _tagModel->rowCount()))
     {
-        qDebug() << "Item text: " << item->text();
+        quint64 tagID = _tagModel->tag(r).id64;
+
+        qCDebug(lcTable) << "Item text: " << QString::number(tagID, 16);
 
-        bool ok;
-        quint64 tagID = item->text().toULongLong(&ok, 16);
         //clear scene from any tags
         Tag *tag = this->_tags.value(tagID, NULL);
         if(tag->tagLabel) //remove label
@@ -1545,47 +1476,49 @@ void GraphicsWidget::clearTag(int r)
             tag->tagLabel2 = NULL;
         }
         //remove history...
-        for(int idx=0; idx<_historyLength; idx++ )
-        {
-            QAbstractGraphicsShapeItem *tag_p = tag->p[idx];
-            if(tag_p)
-            {
-                tag_p->setOpacity(0); //hide it
-
-                this->_scene->removeItem(tag_p);
-                delete(tag_p);
-                tag_p = NULL;
-                tag->p[idx] = 0;
-
-                qDebug() << "hist remove tag " << idx;
-            }
-        }
+        _itemPool->release(tag->marker); //hide it, it will be reused by the next tag
+        tag->marker = NULL;
+
+        this->_scene->removeItem(tag->trail);
+        delete(tag->trail);
+        tag->trail = NULL;
+        _itemPool->release(tag->alarm);
+        tag->alarm = NULL;
         {
             QMap<quint64, Tag*>::iterator i = _tags.find(tagID);
 
             if(i != _tags.end()) _tags.erase(i);
         }
+        delete tag;
+
+        _tagFilter.remove(tagID); //it gets the filter of all tags if it comes back
+
+        _tagModel->removeTag(r);
     }
-    ui->tagTable->removeRow(r);
 
 
-    qDebug() << "clear row ";
+    qCDebug(lcTable) << "clear row ";
 
 }
 
 void GraphicsWidget::clearTags(void)
 {
-    qDebug() << "table rows " << ui->tagTable->rowCount() << " list " << this->_tags.size();
+    qCDebug(lcTable) << "table rows " << _tagModel->rowCount() << " list " << this->_tags.size();
+
+    //the updates waiting for the next frame would add the tags back
+    _frameTimer->stop();
+    _pending.clear();
+    _pendingIndex.clear();
 
-    while (ui->tagTable->rowCount())
+    while (_tagModel->rowCount())
     {
         clearTag(0); //clear table from row 0... after each removal the next row will move into 0th position
     }
 
     //clear tag table
-    ui->tagTable->clearContents();
+    _tagModel->clear();
 
-    qDebug() << "clear tags/tag table";
+    qCDebug(lcTable) << "clear tags/tag table";
 
 }
 
@@ -18,9 +18,12 @@
 #include <QAbstractItemView>
 #include <QGraphicsView>
 #include "RTLSClient.h"
+#include "TagTableModel.h"
 #include <QDateTime>
 #include <QTimer>
 #include <QSignalMapper>
+#include <QHash>
+#include <QVector>
 
 namespace Ui {
 class GraphicsWidget;
@@ -31,19 +34,23 @@ class QGraphicsScene;
 class QModelIndex;
 class GraphicsView;
 class QAbstractGraphicsShapeItem;
+class QGraphicsEllipseItem;
 class QGraphicsItem;
+class EllipseItemPool;
+class TrailItem;
 
 struct Tag
 {
     Tag(void)
     {
-        idx = 0;
+        marker = NULL;
+        trail = NULL;
     }
 
     quint64 id;
     int id16;
-    int idx;
-    QVector<QAbstractGraphicsShapeItem *> p;
+    QGraphicsEllipseItem *marker;   //current position, from the GraphicsWidget's EllipseItemPool (NULL while the tag is lost)
+    TrailItem *trail;               //position history
     bool useIMU;   //use IMU on tag for low update rate indication
     bool joined ;  //does this tag belong to the known network
     int fastrate ; //this is one of the values: 1, 2, 5, 10, 50 or 100 units of 100 ms = SF period.
@@ -63,7 +70,7 @@ struct Tag
 
     bool _cleared;
 
-    QAbstractGraphicsShapeItem *alarm;
+    QGraphicsEllipseItem *alarm;        //from the EllipseItemPool too
 };
 
 struct Node
@@ -107,34 +114,16 @@ class GraphicsWidget : public QWidget
 
 public:
 
-    enum Column {
-        ColumnID = 0,   ///< 64 bit address of the tag (uint64)
-        ColumnJoin,     ///< join checkbox
-        ColumnX,        ///< X coordinate (double)
-        ColumnY,        ///< Y coordinate (double)
-        ColumnRA0,      ///< range (double)
-        ColumnAngle,    ///< angle (int)
-        
-        ColumnAlarm,     //是否按键报警
-        ColumnBattery,   //电池当前电压        
-        ColumnCHRG,      //充电状态
-        Column_AccX,     //三轴加速度X轴的值
-        Column_AccY,     //三轴加速度Y轴的值
-        Column_AccZ,     //三轴加速度Z轴的值
-        ColumnOffRange,  //是否距离校正
-        ColumnOffPDoa,   //是否角度校正
-        
-        ColumnIDr,      ///< ID raw (hex) hidden
-        ColumnCount
-    };
-
     explicit GraphicsWidget(QWidget *parent = 0);
     ~GraphicsWidget();
 
     GraphicsView *graphicsView();
 
-    int findTagRowIndex(QString &t);
-    void insertTag(Tag *tag, int ridx, QString &t, bool showLabel);
+    quint64 mergedUpdates(void) const { return _mergedUpdates; }
+    quint64 earlyFrames(void) const { return _earlyFrames; }
+    bool coalesceUpdates(void) const { return _coalesce; }
+
+    int insertTag(Tag *tag, bool showLabel);
     void tagIDToString(quint64 tagId, QString *t);
     void addNewNode(quint64 nodeId, bool show); //add Node into the nodes list (QMap)
     void addNewTag(quint64 tagId, bool show); //add Tag into the tags list (QMap)
@@ -157,6 +146,9 @@ public slots:
 
     void addDiscoveredTag(quint64 tagId, int id, bool known, int fastrate, int imu);
     void nodePos(int nodeId, double x, double y);
+    void updatesReady(void);
+    void applyUpdates(void);
+    void setCoalesceUpdates(bool coalesce);
     void tagPos(quint64 tagId, double x, double y, int mode);
     void tagRange(quint64 tagID, double range, double x, double y, int angle, int mode,int Acc_x,int Acc_y, int Acc_z);
 
@@ -165,9 +157,10 @@ public slots:
     void tagHistoryNumber(int value);
     void setShowTagHistory(bool);
 
-    void tagTableChanged(int r, int c);
-    void tagTableClicked(int r, int c);
-    void itemSelectionChanged(void);
+    void tagTableClicked(const QModelIndex &index);
+    void tagTableContextMenu(const QPoint &pos);
+    void tagShowLabelChanged(quint64 tagId, bool show);
+    void tagJoinedChanged(quint64 tagId, bool joined);
     void tableComboChanged(QString position);
 
     void startGeoFencing(float x, float y, float rangeStart, float rangeStop);
@@ -179,28 +172,44 @@ protected slots:
     void timerUpdateTagTableExpire(void);
 
 protected:
-    void tagHistory(quint64 tagId);
+    void sendToNode(const QByteArray &cmd, const QByteArray &reply = QByteArray(), int timeout = CMD_PAUSE_MS);
 
 private:
     Ui::GraphicsWidget *ui;
     QGraphicsScene *_scene;
+    EllipseItemPool *_itemPool; //recycled tag position/history items of _scene
 
     QMap<quint64, Tag*> _tags;
     QMap<quint64, Node *> _nodes;
     QMap<quint64, QString> _tagLabels;
 
+    TagTableModel *_tagModel;   //rows of the tag table, one per tag in _tags
+
     float _nodeSize;
     float _tagSize;
     int   _historyLength;
     bool _showHistory;
     bool _showHistoryP;
-    bool _busy;
-    bool _ignore;
 
     int _selectedTagIdx;
 
+    //position filters chosen from the tag table's context menu (they run in the client, on the I/O thread)
+    int _defaultFilter;             //PositionFilterType of all the tags
+    int _filterWindow;              //reports in the median filter's window
+    QHash<quint64, int> _tagFilter; //id64 -> PositionFilterType of the tags set on their own
+
     bool _showRange;
 
+    int _droppedUpdates; //last seen count of updates the client had to drop
+
+    //latest update of each tag waiting for the next display frame, in order of arrival
+    QVector<tag_update_t> _pending;
+    QHash<quint64, int> _pendingIndex;  //id64 -> index in _pending
+    quint64 _mergedUpdates;             //updates replaced by a newer one of the same tag before they were shown
+    quint64 _earlyFrames;               //frames applied before the frame timer because FRAME_PENDING_MAX tags were waiting
+    bool _coalesce;                     //false: each update is applied as it comes (to compare the CPU use)
+    QTimer *_frameTimer;
+
     QTimer *_timer;
     QSignalMapper *_signalMapper;
 };
@@ -43,7 +43,7 @@ void MinimapView::onReady()
 void MinimapView::floorplanChanged()
 {
     ViewSettings *vs = RTLSDisplayApplication::viewSettings();
-    QRectF sceneRect = vs->floorplanTransform().map(QRectF(0, 0, vs->floorplanPixmap().width(), vs->floorplanPixmap().height())).boundingRect();
+    QRectF sceneRect = vs->floorplanTransform().mapRect(QRectF(QPointF(0, 0), vs->floorplanSize()));
 
     _scene->setSceneRect(sceneRect);
     this->fitInView(sceneRect, Qt::KeepAspectRatio);
@@ -56,14 +56,15 @@ void MinimapView::visibleRectChanged()
 
 void MinimapView::drawForeground(QPainter *painter, const QRectF &rect)
 {
-    Q_UNUSED(rect)
-    const QPixmap &pm = RTLSDisplayApplication::viewSettings()->floorplanPixmap();
-    if (!pm.isNull())
+    FloorplanPyramid &fp = RTLSDisplayApplication::viewSettings()->floorplan();
+    if (!fp.isNull())
     {
+        QTransform t = RTLSDisplayApplication::viewSettings()->floorplanTransform();
+
         painter->save();
-        painter->setTransform(RTLSDisplayApplication::viewSettings()->floorplanTransform(), true);
+        painter->setTransform(t, true);
         painter->setPen(QPen(QBrush(Qt::black), 1));
-        painter->drawPixmap(0, 0, pm);
+        fp.draw(painter, t.inverted().mapRect(rect)); //the minimap is small, this is one of the coarse levels
         painter->restore();
 
         painter->setPen(QPen(QBrush(Qt::red), 0.1));
@@ -75,7 +76,7 @@ void MinimapView::resizeEvent(QResizeEvent *event)
 {
     Q_UNUSED(event)
     ViewSettings *vs = RTLSDisplayApplication::viewSettings();
-    QRectF sceneRect = vs->floorplanTransform().map(QRectF(0, 0, vs->floorplanPixmap().width(), vs->floorplanPixmap().height())).boundingRect();
+    QRectF sceneRect = vs->floorplanTransform().mapRect(QRectF(QPointF(0, 0), vs->floorplanSize()));
     this->fitInView(sceneRect, Qt::KeepAspectRatio);
 }
 
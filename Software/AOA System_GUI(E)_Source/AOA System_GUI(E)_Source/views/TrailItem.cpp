@@ -0,0 +1,200 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: TrailItem.cpp
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#include "TrailItem.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+TrailItem::TrailItem(int length, QGraphicsItem *parent) :
+    QGraphicsItem(parent),
+    _head(0),
+    _count(0),
+    _appends(0),
+    _colour(Qt::black),
+    _size(0.15)
+{
+    //only the exposed part of the trail is drawn
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+
+    setLength(length);
+}
+
+QRectF TrailItem::boundingRect() const
+{
+    if(_count == 0)
+    {
+        return QRectF();
+    }
+
+    return _points.adjusted(-_size/2, -_size/2, _size/2, _size/2);
+}
+
+void TrailItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    int n = _ring.size();
+    qreal r = _size / 2;
+    QRectF exposed = option->exposedRect.adjusted(-r, -r, r, r);
+
+    painter->setPen(Qt::NoPen);
+
+    //oldest first, so the newer points are drawn on top
+    for(int age = _count - 1; age > 0; age--)
+    {
+        const QPointF &p = _ring.at((_head - 1 - age + n) % n);
+
+        if(exposed.contains(p))
+        {
+            painter->setBrush(_gradient.at(age));
+            painter->drawEllipse(p, r, r);
+        }
+    }
+}
+
+/**
+* @brief append()
+*        the bounds only grow here, they are recomputed once every length() appends, i.e. when the points
+*        which could have defined them have all been overwritten, so append() stays O(1) amortised
+* */
+void TrailItem::append(const QPointF &point)
+{
+    int n = _ring.size();
+
+    if(n == 0)
+    {
+        return;
+    }
+
+    _ring[_head] = point;
+    _head = (_head + 1) % n;
+
+    if(_count < n)
+    {
+        _count++;
+    }
+
+    if(++_appends >= n)
+    {
+        updateBounds();
+    }
+    else if((_count == 1) ||
+            (point.x() < _points.left()) || (point.x() > _points.right()) ||
+            (point.y() < _points.top()) || (point.y() > _points.bottom()))
+    {
+        prepareGeometryChange();
+
+        if(_count == 1)
+        {
+            _points = QRectF(point, QSizeF(0, 0));
+        }
+        else
+        {
+            _points.setLeft(qMin(_points.left(), point.x()));
+            _points.setRight(qMax(_points.right(), point.x()));
+            _points.setTop(qMin(_points.top(), point.y()));
+            _points.setBottom(qMax(_points.bottom(), point.y()));
+        }
+    }
+
+    update();
+}
+
+void TrailItem::clear(void)
+{
+    prepareGeometryChange();
+
+    _head = 0;
+    _count = 0;
+    _appends = 0;
+    _points = QRectF();
+}
+
+void TrailItem::setLength(int length)
+{
+    if(length < 1)
+    {
+        length = 1;
+    }
+
+    clear();
+
+    _ring.resize(length);
+
+    updateGradient();
+}
+
+void TrailItem::setColour(const QColor &colour)
+{
+    _colour = colour;
+
+    updateGradient();
+    update();
+}
+
+void TrailItem::setPointSize(qreal size)
+{
+    prepareGeometryChange();
+
+    _size = size;
+}
+
+/**
+* @brief updateGradient()
+*        same opacity as the history items had: 1 - age / length
+* */
+void TrailItem::updateGradient(void)
+{
+    int n = _ring.size();
+
+    _gradient.resize(n);
+
+    for(int age = 0; age < n; age++)
+    {
+        QColor c = _colour;
+
+        c.setAlphaF(_colour.alphaF() * (1 - (qreal)age / n));
+        _gradient[age] = c;
+    }
+}
+
+void TrailItem::updateBounds(void)
+{
+    int n = _ring.size();
+    QRectF bounds;
+
+    for(int age = 0; age < _count; age++)
+    {
+        const QPointF &p = _ring.at((_head - 1 - age + n) % n);
+
+        if(age == 0)
+        {
+            bounds = QRectF(p, QSizeF(0, 0));
+        }
+        else
+        {
+            bounds.setLeft(qMin(bounds.left(), p.x()));
+            bounds.setRight(qMax(bounds.right(), p.x()));
+            bounds.setTop(qMin(bounds.top(), p.y()));
+            bounds.setBottom(qMax(bounds.bottom(), p.y()));
+        }
+    }
+
+    if(bounds != _points)
+    {
+        prepareGeometryChange();
+        _points = bounds;
+    }
+
+    _appends = 0;
+}
@@ -0,0 +1,69 @@
+// -------------------------------------------------------------------------------------------------------------------
+//
+//  File: TrailItem.h
+//
+//  Copyright 2015 (c) Decawave Ltd, Dublin, Ireland.
+//
+//  All rights reserved.
+//
+//  Author:
+//
+// -------------------------------------------------------------------------------------------------------------------
+
+#ifndef TRAILITEM_H
+#define TRAILITEM_H
+
+#include <QGraphicsItem>
+#include <QVector>
+#include <QColor>
+
+/**
+ * The TrailItem class draws the position history of one tag as a single scene item.
+ *
+ * The last length() positions are kept in a ring of points: append() is O(1), it only overwrites the oldest
+ * point and schedules one update of the item's bounding rect. paint() draws the points from the oldest to the
+ * newest with a precomputed opacity gradient (the newest opaque, the oldest nearly transparent), so a report
+ * costs one repaint region instead of an opacity change on every history item.
+ * The newest point is not drawn, it is under the tag's own marker.
+ */
+class TrailItem : public QGraphicsItem
+{
+public:
+    explicit TrailItem(int length, QGraphicsItem *parent = 0);
+
+    QRectF boundingRect() const;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
+
+    /**
+     * Add the tag's latest position, the oldest one is dropped once the trail is full.
+     */
+    void append(const QPointF &point);
+    void clear(void);
+
+    /**
+     * Change the number of positions kept, the trail is cleared.
+     */
+    void setLength(int length);
+    int length(void) const { return _ring.size(); }
+    int count(void) const { return _count; }
+
+    void setColour(const QColor &colour);
+    void setPointSize(qreal size);
+
+private:
+    void updateGradient(void);
+    void updateBounds(void);
+
+    QVector<QPointF> _ring;
+    int _head;              //next slot to write, the newest point is at _head - 1
+    int _count;             //valid points in the ring
+    int _appends;           //appends since the bounds were last recomputed
+
+    QColor _colour;
+    QVector<QColor> _gradient;  //colour of the point of each age, 0 is the newest
+    qreal _size;            //diameter of a point
+
+    QRectF _points;         //bounding rect of the point centres (may be larger than needed, see append())
+};
+
+#endif // TRAILITEM_H
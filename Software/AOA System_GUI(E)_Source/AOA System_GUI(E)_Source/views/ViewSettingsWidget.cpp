@@ -22,6 +22,7 @@
 #include "GraphicsView.h"
 #include "GraphicsWidget.h"
 
+#include <QApplication>
 #include <QFileDialog>
 #include <QInputDialog>
 #include <QMessageBox>
@@ -107,15 +108,24 @@ void ViewSettingsWidget::onReady()
 
     ui->calibrationProceBar->setValue(0);
 
+    //the offsets are set on the I/O thread, read them there (later changes come with phase/rangeOffsetUpdated())
+    double phaseOffset = 0;
+    double rangeOffset = 0;
+
+    QMetaObject::invokeMethod(RTLSDisplayApplication::client(), "getPhaseOffset", Qt::BlockingQueuedConnection,
+                              Q_RETURN_ARG(double, phaseOffset));
+    QMetaObject::invokeMethod(RTLSDisplayApplication::client(), "getRangeOffset", Qt::BlockingQueuedConnection,
+                              Q_RETURN_ARG(double, rangeOffset));
+
     // Show phase offset on GUI
     ui->phaseOffsetBox->hide();
     ui->label_z1_7->hide();
-    ui->phaseOffsetBox->setValue(RTLSDisplayApplication::client()->getPhaseOffset());
+    ui->phaseOffsetBox->setValue(phaseOffset);
 
     // Show range offset on GUI
     ui->rangeOffsetBox->hide();
     ui->label_z1_9->hide();
-    ui->rangeOffsetBox->setValue(RTLSDisplayApplication::client()->getRangeOffset());
+    ui->rangeOffsetBox->setValue(rangeOffset);
 
     QObject::connect(RTLSDisplayApplication::serialConnection(), SIGNAL(serialOpened(QString)),
                          this, SLOT(onConnected(QString)));
@@ -160,16 +170,18 @@ void ViewSettingsWidget::tabSelected(){
 
 int ViewSettingsWidget::applyFloorPlanPic(const QString &path)
 {
-    QPixmap pm(path);
+    //the first load of an image generates its tile pyramid, which can take a while for a large plan
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool ok = RTLSDisplayApplication::viewSettings()->setFloorplanImage(path);
+    QApplication::restoreOverrideCursor();
 
-    if (pm.isNull())
+    if (!ok)
     {
         //QMessageBox::critical(this, "Could not load floor plan", QString("Failed to load image : %1").arg(path));
         return -1;
     }
 
     ui->floorplanPath_lb->setText(QFileInfo(path).fileName());
-    RTLSDisplayApplication::viewSettings()->setFloorplanPixmap(pm);
 
     return 0;
 }
@@ -427,7 +439,8 @@ void ViewSettingsWidget::doCalibrationClicked()
                             if (ok)
                             {
                                 quint64 tagId = RTLSDisplayApplication::graphicsWidget()->getID64FromLabel(idStr);
-                                RTLSDisplayApplication::client()->enablePhaseAndDistCalibration(tagId, distance);
+                                QMetaObject::invokeMethod(RTLSDisplayApplication::client(), "enablePhaseAndDistCalibration", Qt::QueuedConnection,
+                                                          Q_ARG(quint64, tagId), Q_ARG(double, distance));
                             }
                          }
                          break;
@@ -68,7 +68,8 @@ int ConnectionWidget::updateDeviceList()
         ui->comPort->removeItem(0);
     }
 	//久凌电子
-    RTLSDisplayApplication::serialConnection()->findSerialDevices();
+    //the ports are enumerated in the I/O thread, wait for the list
+    QMetaObject::invokeMethod(RTLSDisplayApplication::serialConnection(), "findSerialDevices", Qt::BlockingQueuedConnection);
 
     ui->comPort->addItems(RTLSDisplayApplication::serialConnection()->portsList());
 
@@ -110,21 +111,25 @@ void ConnectionWidget::serialError(void)
 
 void ConnectionWidget::connectButtonClicked()
 {
+    //the serial connection lives in the I/O thread, so the requests are queued to it
+    //the result is reported back through connectionStateChanged()
+    SerialConnection *serial = RTLSDisplayApplication::serialConnection();
+
     switch (_state)
     {
     case SerialConnection::Disconnected:
     case SerialConnection::ConnectionFailed:
     {
-        RTLSDisplayApplication::serialConnection()->openConnection(ui->comPort->currentIndex());
+        QMetaObject::invokeMethod(serial, "openConnection", Qt::QueuedConnection, Q_ARG(int, ui->comPort->currentIndex()));
         break;
     }
 
     case SerialConnection::Connecting:
-        RTLSDisplayApplication::serialConnection()->cancelConnection();
+        QMetaObject::invokeMethod(serial, "cancelConnection", Qt::QueuedConnection);
         break;
 
     case SerialConnection::Connected:
-        RTLSDisplayApplication::serialConnection()->closeConnection(false);
+        QMetaObject::invokeMethod(serial, "closeConnection", Qt::QueuedConnection, Q_ARG(bool, false));
         break;
     }
 }
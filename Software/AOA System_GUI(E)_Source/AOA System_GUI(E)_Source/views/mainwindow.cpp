@@ -58,6 +58,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
     ui->viewSettings_dw->close();
     ui->minimap_dw->close();
+    ui->diagnostics_dw->close();
 
     connect(ui->minimap_dw->toggleViewAction(), SIGNAL(triggered()), SLOT(onMiniMapView()));
 
@@ -70,7 +71,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
 	QObject::connect(viewSettingsWidget(),SIGNAL(Signal_RangeLog_Generate()),RTLSDisplayApplication::client(), SLOT(Slot_RangeLog_Generate()));
     QObject::connect(viewSettingsWidget(),SIGNAL(Signal_Open_Serial_assistant()),RTLSDisplayApplication::serialSettings(), SLOT(Slot_Open_Serial_assistant()));
-	QObject::connect(RTLSDisplayApplication::client(),SIGNAL(Signal_Uart_Recvdata(QByteArray)),RTLSDisplayApplication::serialSettings(), SLOT(Slot_Uart_Recvdata(QByteArray)));		//串口接受的数据
+	QObject::connect(RTLSDisplayApplication::serialConnection(),SIGNAL(consoleData(QByteArray)),RTLSDisplayApplication::serialSettings(), SLOT(Slot_Uart_Recvdata(QByteArray)));		//串口接受的数据
     RTLSDisplayApplication::connectReady(this, "onReady()");
 }
 
@@ -121,6 +122,7 @@ QMenu *MainWindow::createPopupMenu(QMenu *menu)
 {
     menu->addAction(ui->viewSettings_dw->toggleViewAction());
     menu->addAction(ui->minimap_dw->toggleViewAction());
+    menu->addAction(ui->diagnostics_dw->toggleViewAction());
 
     return menu;
 }
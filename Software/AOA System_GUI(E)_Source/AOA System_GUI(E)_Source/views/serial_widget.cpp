@@ -2,16 +2,24 @@
 #include "ui_serial_widget.h"
 #include "RTLSDisplayApplication.h"
 #include "SerialConnection.h"
+#include "ConsoleModel.h"
+#include "LogCategories.h"
 #include <QDebug>
+#include <QFontDatabase>
+#include <QScrollBar>
 
 
-QString serial_Uart_Cache;
-
 serial_widget::serial_widget(QWidget *parent) :
     QWidget(parent),
-    ui(new Ui::serial_widget)
+    ui(new Ui::serial_widget),
+    _connected(false)
 {
     ui->setupUi(this);
+
+    //the received lines, only the visible rows are laid out (uniform item sizes)
+    _console = new ConsoleModel(CONSOLE_LINES, this);
+    ui->serial_listView_recv->setModel(_console);
+    ui->serial_listView_recv->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
 }
 
 serial_widget::~serial_widget()
@@ -23,11 +31,22 @@ serial_widget::~serial_widget()
  */
 void serial_widget::Slot_Open_Serial_assistant()
 {
+    //the ports are enumerated in the I/O thread, wait for the list
+    QMetaObject::invokeMethod(RTLSDisplayApplication::serialConnection(), "findSerialDevices", Qt::BlockingQueuedConnection);
+
+    ui->serial_comPort_UartPort->clear();
     ui->serial_comPort_UartPort->addItems(RTLSDisplayApplication::serialConnection()->portsList());
-    Slot_Serial_Uart_State(RTLSDisplayApplication::serialConnection()->_serial->isOpen());
+    Slot_Serial_Uart_State(_connected);
 	show();
 }
 
+void serial_widget::connectionStateChanged(SerialConnection::ConnectionState state)
+{
+    _connected = (state == SerialConnection::Connected);
+
+    Slot_Serial_Uart_State(_connected);
+}
+
 
 void serial_widget::Slot_Serial_Uart_State(bool state)
 {
@@ -61,7 +80,16 @@ void serial_widget::Slot_Serial_Uart_State(bool state)
 void serial_widget::Slot_Uart_Recvdata(QByteArray data)
 {
     QString str =  tr(data);
-    serial_Uart_Cache.append(str);
+    QScrollBar *bar = ui->serial_listView_recv->verticalScrollBar();
+    bool atEnd = (bar->value() == bar->maximum());
+
+    //刷新显示 - keep following the end unless the user has scrolled up
+    _console->append(data);
+
+    if(atEnd && !_console->isPaused())
+    {
+        ui->serial_listView_recv->scrollToBottom();
+    }
 
     int cmd_getver_StartIndex = str.indexOf("getver");
     int cmd_getcfg_StartIndex = str.indexOf("getcfg");
@@ -136,19 +164,19 @@ void serial_widget::Slot_Uart_Recvdata(QByteArray data)
 #endif
         }
     }
+}
 
-    //刷新显示
-    ui->serial_textEdit_recv->setText(serial_Uart_Cache);
-    ui->serial_textEdit_recv->moveCursor(QTextCursor::End);
-
-    if(serial_Uart_Cache.length() > 9096)
-    {
-        serial_Uart_Cache.clear();
-    }
 
+/*
+ * 串口连接在I/O线程中, 命令通过队列发送
+ * the replies of these commands are console text, not JSON objects: the queue pauses after each one
+ */
+void serial_widget::sendToNode(const QByteArray &cmd)
+{
+    QMetaObject::invokeMethod(RTLSDisplayApplication::serialConnection(), "queueCommand", Qt::QueuedConnection,
+                              Q_ARG(QByteArray, cmd), Q_ARG(QByteArray, QByteArray()), Q_ARG(int, CMD_PAUSE_MS), Q_ARG(int, 0));
 }
 
-
 void serial_widget::on_serial_pushButton_Uart_WriteCfg_clicked()
 {
 	//setcfg 1 1 3333 1 100 0 0
@@ -159,33 +187,79 @@ void serial_widget::on_serial_pushButton_Uart_WriteCfg_clicked()
     int User_Cmd = ui->serial_comboBox_usercmd->currentIndex();;
 
     QString setcfg = QString("setcfg 1 1 %1 %2 %3 %4 %5\r\n").arg(PanID).arg(AncID).arg(Serail_Rate).arg(Motion_filter).arg(User_Cmd);
-    RTLSDisplayApplication::serialConnection()->_serial->write(setcfg.toLocal8Bit());
+    sendToNode(setcfg.toLocal8Bit());
 
     qDebug() << "PanID" << ui->serial_lineEdit_Net->text().toLatin1() << "msg" << setcfg;
 }
 
 void serial_widget::on_serial_pushButton_Uart_ReadCfg_clicked()
 {
-    RTLSDisplayApplication::serialConnection()->_serial->write("getcfg\r\n");
+    sendToNode("getcfg\r\n");
 }
 
 void serial_widget::on_serial_pushButton_Uart_Save_clicked()
 {
-    RTLSDisplayApplication::serialConnection()->_serial->write("save\r\n");
+    sendToNode("save\r\n");
 }
 
 void serial_widget::on_serial_pushButton_Uart_Reset_2_clicked()
 {
-    RTLSDisplayApplication::serialConnection()->_serial->write("reset\r\n");
+    sendToNode("reset\r\n");
 }
 
 void serial_widget::on_serial_pushButton_Uart_Restore_clicked()
 {
-    RTLSDisplayApplication::serialConnection()->_serial->write("rtoken\r\n");
+    sendToNode("rtoken\r\n");
 }
 
 void serial_widget::on_serial_pushButton_Uart_Getver_clicked()
 {
-    RTLSDisplayApplication::serialConnection()->_serial->write("getver\r\n");
+    sendToNode("getver\r\n");
+}
+
+/*
+ * 过滤 - an invalid expression is shown in red and the previous filter is kept
+ */
+void serial_widget::on_serial_lineEdit_filter_textChanged(const QString &text)
+{
+    QRegularExpression filter(text);
+    QPalette palette = ui->serial_lineEdit_filter->palette();
+
+    palette.setColor(QPalette::Text, filter.isValid() ? Qt::black : Qt::red);
+    ui->serial_lineEdit_filter->setPalette(palette);
+
+    if(filter.isValid())
+    {
+        _console->setFilter(filter);
+        ui->serial_listView_recv->scrollToBottom();
+    }
+}
+
+void serial_widget::on_serial_checkBox_pause_toggled(bool checked)
+{
+    _console->setPaused(checked);
+
+    if(!checked)
+    {
+        if(_console->dropped() > 0)
+        {
+            qCInfo(lcSerial) << "serial console:" << _console->dropped() << "lines dropped while paused";
+
+            ui->serial_checkBox_pause->setToolTip(tr("%1 lines were dropped while paused").arg(_console->dropped()));
+        }
+
+        ui->serial_listView_recv->scrollToBottom();
+    }
+}
+
+void serial_widget::on_serial_checkBox_hex_toggled(bool checked)
+{
+    _console->setHexMode(checked);
+}
+
+void serial_widget::on_serial_pushButton_clear_clicked()
+{
+    _console->clear();
+    ui->serial_checkBox_pause->setToolTip(QString());
 }
 
@@ -3,6 +3,10 @@
 
 #include <QWidget>
 
+#include "SerialConnection.h"
+
+class ConsoleModel;
+
 namespace Ui {
 class serial_widget;
 }
@@ -19,6 +23,7 @@ public slots:
     void Slot_Open_Serial_assistant();
     void Slot_Serial_Uart_State(bool state);
     void Slot_Uart_Recvdata(QByteArray data);
+    void connectionStateChanged(SerialConnection::ConnectionState state);
 
 private slots:
 
@@ -34,8 +39,22 @@ private slots:
 
     void on_serial_pushButton_Uart_Getver_clicked();
 
+    void on_serial_lineEdit_filter_textChanged(const QString &text);
+
+    void on_serial_checkBox_pause_toggled(bool checked);
+
+    void on_serial_checkBox_hex_toggled(bool checked);
+
+    void on_serial_pushButton_clear_clicked();
+
 private:
+    void sendToNode(const QByteArray &cmd);
+
     Ui::serial_widget *ui;
+
+    ConsoleModel *_console;
+
+    bool _connected;    //tracked from connectionStateChanged(), the port itself lives on the I/O thread
 };
 
 #endif // SERIAL_WIDGET_H